@@ -0,0 +1,154 @@
+/**
+ * AsyncFileReader.h
+ *
+ * Reads a regular file into a BufferRing with several large block reads in
+ * flight at once, so the storage device keeps working while the parser is
+ * busy tokenizing the previous block.
+ *
+ * Two backends are provided:
+ * - io_uring: reads are queued on a kernel submission ring (raw syscalls,
+ *   no liburing needed) and reaped from the completion ring
+ * - pread pool: one worker thread per queue slot issuing blocking pread()
+ *   calls, used when io_uring is not compiled in or the kernel refuses it
+ *
+ * Reads may complete in any order; blocks are always published to the ring
+ * in file order.
+ */
+
+#ifndef ASYNCFILEREADER_H
+#define ASYNCFILEREADER_H
+
+#include "BufferRing.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
+
+/**
+ * Backends for AsyncFileReader
+ */
+enum AsyncBackend {
+    ASYNC_IO_URING,
+    ASYNC_PREAD_POOL
+};
+
+/**
+ * AsyncFileReader class - Queue of in-flight block reads feeding a BufferRing
+ */
+class AsyncFileReader {
+public:
+    /**
+     * Default number of reads kept in flight
+     */
+    static const int DEFAULT_QUEUE_DEPTH = 4;
+
+    /**
+     * Default size of each read in bytes
+     */
+    static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+    /**
+     * Constructor
+     * @param queueDepth Number of reads kept in flight (at least 1)
+     * @param blockSize Bytes per read; the ring's buffers must be at least this large
+     */
+    AsyncFileReader(int queueDepth = DEFAULT_QUEUE_DEPTH, size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+    /**
+     * Destructor - releases the io_uring instance, if any
+     */
+    ~AsyncFileReader();
+
+    /**
+     * Reads bytes [begin, end) of a file into the ring, one block per buffer, in order
+     * Runs on the ring's producer thread and returns once every block has
+     * been published, the ring was cancelled, or a read failed. The caller
+     * still has to call ring.finish().
+     *
+     * @param fd File descriptor of a regular file
+     * @param begin Offset of the first byte to read
+     * @param end Offset one past the last byte to read (at most the file size)
+     * @param ring Destination ring (buffers of at least blockSize bytes)
+     * @return true on success or cancellation, false on a read error
+     */
+    bool run(int fd, size_t begin, size_t end, BufferRing& ring);
+
+    /**
+     * Backend used by the last call to run()
+     */
+    AsyncBackend getBackend() const { return backend; }
+
+    /**
+     * Name of a backend ("io_uring", "pread")
+     */
+    static const char* backendName(AsyncBackend backend);
+
+private:
+    /**
+     * A block read that has been submitted but not yet published
+     */
+    struct Pending {
+        RingBuffer* buffer;
+        size_t offset;      // File offset of the block
+        size_t length;      // Bytes expected
+        size_t done;        // Bytes read so far
+        struct iovec vector;    // io_uring read target (buffer + done, length - done)
+        bool complete;
+        bool failed;
+    };
+
+    // io_uring backend
+    bool setupUring(unsigned int entries);
+    void teardownUring();
+    bool submitUring(unsigned long long slot);
+    bool reapUring(bool wait);
+    void drainUring();
+
+    // pread pool backend
+    void startPool(int fd);
+    void stopPool();
+    void submitPool(unsigned long long slot);
+    void poolWorker(int fd);
+
+    // Shared driver
+    bool submit(unsigned long long slot);
+    bool waitFor(unsigned long long slot);
+
+    int queueDepth;
+    size_t blockSize;
+    AsyncBackend backend;
+    int fd;
+    std::vector<Pending> pending;       // Indexed by block number % queueDepth
+
+    // io_uring state (raw mmap'ed rings)
+    int ringFd;
+    void* sqRing;
+    void* cqRing;
+    void* sqes;
+    size_t sqRingBytes;
+    size_t cqRingBytes;
+    size_t sqesBytes;
+    unsigned int* sqHead;
+    unsigned int* sqTail;
+    unsigned int* sqMask;
+    unsigned int* sqArray;
+    unsigned int* cqHead;
+    unsigned int* cqTail;
+    unsigned int* cqMask;
+    void* cqes;
+    unsigned int inFlight;
+    bool draining;                      // Reads are being cancelled: none is resubmitted
+
+    // pread pool state
+    std::vector<std::thread> workers;
+    std::deque<unsigned long long> requests;   // Slots waiting for a worker
+    std::mutex poolLock;
+    std::condition_variable requestReady;
+    std::condition_variable completionReady;
+    bool poolStopping;
+};
+
+#endif // ASYNCFILEREADER_H
@@ -0,0 +1,169 @@
+/**
+ * AsyncScorer.h
+ *
+ * Coroutine interface to scoring, for event-loop programs that cannot
+ * block a thread per request. A coroutine awaits scoreAsync() (or
+ * scoreBatchAsync() for many texts at once) and is suspended while its
+ * text waits in a MicroBatcher and is scored by a fixed pool of scoring
+ * threads, one per worker slot of the classifier, in batches exactly as
+ * the scoring server does. On completion the scoring thread does not run
+ * the coroutine itself: it posts it to the awaiter's Executor, so the
+ * coroutine always resumes on the executor's thread (for example, the
+ * event loop).
+ *
+ * Awaiting never blocks the executor's thread, except when the batcher's
+ * queue is full: then it waits for room, as a server connection does.
+ *
+ * Requires C++20 (-std=c++20).
+ */
+
+#ifndef ASYNCSCORER_H
+#define ASYNCSCORER_H
+
+#include "DSStringView.h"
+#include "MicroBatcher.h"
+#include "SentimentClassifier.h"
+#include "Task.h"
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Executor interface - Runs coroutines posted from any thread
+ */
+class Executor {
+public:
+    virtual ~Executor() {}
+
+    /**
+     * Schedules a suspended coroutine to be resumed on the executor
+     * May be called from any thread.
+     */
+    virtual void post(std::coroutine_handle<> coroutine) = 0;
+};
+
+/**
+ * SingleThreadExecutor class - Resumes coroutines on the thread calling run()
+ */
+class SingleThreadExecutor : public Executor {
+public:
+    SingleThreadExecutor() : running(0) {}
+
+    void post(std::coroutine_handle<> coroutine) override;
+
+    /**
+     * Starts a task on this executor when run() is called; the executor
+     * owns it until it finishes
+     */
+    void spawn(Task<void> task);
+
+    /**
+     * Resumes posted coroutines on the calling thread until every spawned
+     * task has finished
+     */
+    void run();
+
+private:
+    /**
+     * Coroutine that awaits a spawned task and then counts it as finished
+     */
+    struct Spawned;
+    static Spawned runSpawned(Task<void> task, SingleThreadExecutor* executor);
+
+    std::mutex lock;
+    std::condition_variable posted;
+    std::deque<std::coroutine_handle<>> ready;
+    size_t running;                 // Spawned tasks not finished (executor thread only)
+};
+
+/**
+ * AsyncScorer class - Scores texts for coroutines on a pool of scoring threads
+ */
+class AsyncScorer {
+public:
+    /**
+     * Constructor - starts one scoring thread per worker slot
+     * @param classifier Loaded (and possibly frozen) classifier; its worker
+     *        slots belong to the scorer until it is destroyed
+     * @param executor Executor awaiting coroutines are resumed on
+     * @param maxBatch Largest batch (1 disables batching)
+     * @param maxDelayMicros Longest time a text waits for its batch to fill
+     * @param latencyTargetMicros p99 latency the batch delay is tuned against
+     * @param queueLimit Most texts waiting at once
+     */
+    AsyncScorer(SentimentClassifier& classifier, Executor& executor, size_t maxBatch = 64, int maxDelayMicros = 200,
+                int latencyTargetMicros = 2000, size_t queueLimit = 65536);
+
+    /**
+     * Destructor - scores what is queued, then stops the scoring threads
+     */
+    ~AsyncScorer();
+
+    AsyncScorer(const AsyncScorer&) = delete;
+    AsyncScorer& operator=(const AsyncScorer&) = delete;
+
+    /**
+     * Scores one text
+     * The viewed text must stay valid until the task is awaited.
+     *
+     * @param text The text of the tweet
+     * @return Task producing the sentiment score (positive value suggests
+     *         positive sentiment, NaN if the scorer was being destroyed)
+     */
+    Task<float> scoreAsync(DSStringView text);
+
+    /**
+     * Scores several texts as one submission: one suspension and one
+     * resumption for all of them
+     * The texts must stay valid until the task is awaited.
+     *
+     * @param texts The texts to score
+     * @param count Number of texts
+     * @return Task producing the score of each text, in order
+     */
+    Task<std::vector<float>> scoreBatchAsync(const DSStringView* texts, size_t count);
+
+private:
+    /**
+     * Awaiter that queues requests and suspends until all are scored
+     * Resumes with the number of requests accepted (the first ones).
+     */
+    struct Submission {
+        AsyncScorer* scorer;
+        ScoreRequest* const* requests;
+        size_t count;
+        RequestGroup group;
+        ClientQueue queue;
+        std::coroutine_handle<> awaiting;
+        size_t refused;
+
+        Submission(AsyncScorer* owner, ScoreRequest* const* submitted, size_t submittedCount)
+            : scorer(owner), requests(submitted), count(submittedCount), refused(0) {}
+
+        bool await_ready() const noexcept { return count == 0; }
+        bool await_suspend(std::coroutine_handle<> coroutine);
+        size_t await_resume() const noexcept { return count - refused; }
+
+        /**
+         * Completion function of the request group: posts the awaiting
+         * coroutine to the executor
+         */
+        static void resume(void* context);
+    };
+
+    /**
+     * Scores batches from the batcher until it is stopped
+     */
+    void scoreLoop(int slot);
+
+    SentimentClassifier& classifier;
+    Executor& executor;
+    MicroBatcher batcher;
+    std::vector<std::thread> scorers;
+};
+
+#endif // ASYNCSCORER_H
@@ -0,0 +1,121 @@
+/**
+ * BloomFilter.h
+ *
+ * Blocked Bloom filter over 64-bit keys.
+ * Every key maps to a single 64-byte block (one cache line) and all of its
+ * bits are set or tested inside that block, so a lookup costs one cache miss
+ * regardless of the number of hash functions. Bits are set with atomic OR,
+ * so concurrent inserts need no lock.
+ */
+
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+/**
+ * BlockedBloomFilter class - Probabilistic set with no false negatives
+ */
+class BlockedBloomFilter {
+public:
+    /**
+     * Default constructor
+     * Creates an empty filter; call one of the init functions before use
+     */
+    BlockedBloomFilter();
+
+    /**
+     * Sizes the filter to a fixed memory budget
+     * Discards any existing contents. Not thread-safe.
+     * @param memoryBytes Size of the bit array (rounded up to whole blocks)
+     * @param numHashes Bits set per key (1 to 16)
+     */
+    void initWithMemory(size_t memoryBytes, int numHashes);
+
+    /**
+     * Sizes the filter for a number of keys and a target false-positive rate
+     * Discards any existing contents. Not thread-safe.
+     * @param expectedKeys Number of keys that will be inserted
+     * @param falsePositiveRate Target probability that mayContain() is wrong
+     */
+    void initForKeys(size_t expectedKeys, double falsePositiveRate);
+
+    /**
+     * Inserts a key
+     * Thread-safe.
+     * @param key Key to insert (should already be well mixed)
+     * @return true if every bit was already set, i.e. the key was probably
+     *         inserted before
+     */
+    bool insert(uint64_t key);
+
+    /**
+     * Tests for a key
+     * @param key Key to look up
+     * @return false if the key was definitely never inserted
+     */
+    bool mayContain(uint64_t key) const;
+
+    /**
+     * Expected false-positive rate after inserting the given number of keys
+     */
+    double estimatedFalsePositiveRate(size_t insertedKeys) const;
+
+    /**
+     * Bytes used by the bit array
+     */
+    size_t memoryBytes() const { return numBlocks * BLOCK_WORDS * sizeof(uint64_t); }
+
+    /**
+     * Number of bits set per key
+     */
+    int getNumHashes() const { return numHashes; }
+
+    /**
+     * Number of 64-byte blocks in the bit array
+     */
+    size_t getNumBlocks() const { return numBlocks; }
+
+    /**
+     * Copies the bit array out, for example into a serialized model
+     * Not thread-safe with concurrent inserts.
+     * @param out Receives memoryBytes() bytes
+     */
+    void copyBits(uint64_t* out) const;
+
+    /**
+     * Tests for a key in a bit array copied out with copyBits()
+     * @param bits The copied bit array
+     * @param numBlocks getNumBlocks() of the filter it was copied from
+     * @param numHashes getNumHashes() of the filter it was copied from
+     * @param key Key to look up
+     * @return false if the key was definitely never inserted
+     */
+    static bool mayContain(const uint64_t* bits, size_t numBlocks, int numHashes, uint64_t key);
+
+    /**
+     * Starts loading the block of a key in a copied bit array into the cache
+     */
+    static void prefetch(const uint64_t* bits, size_t numBlocks, uint64_t key) {
+        __builtin_prefetch(&bits[blockFor(key, numBlocks) * BLOCK_WORDS]);
+    }
+
+private:
+    static const int BLOCK_WORDS = 8;  // 8 x 64 bits = one 64-byte cache line
+
+    /**
+     * Computes the block index for a key (multiply-shift on the high half)
+     */
+    static size_t blockFor(uint64_t key, size_t numBlocks) {
+        return static_cast<size_t>(((key >> 32) * static_cast<uint64_t>(numBlocks)) >> 32);
+    }
+
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+    size_t numBlocks;
+    int numHashes;
+};
+
+#endif // BLOOMFILTER_H
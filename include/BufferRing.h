@@ -0,0 +1,116 @@
+/**
+ * BufferRing.h
+ *
+ * Fixed ring of large byte buffers passed between one producer thread
+ * (reading or decompressing input) and one consumer (the line parser).
+ * Buffers cycle empty -> producer -> full -> consumer -> empty, so input
+ * I/O and decompression overlap with parsing while memory stays bounded at
+ * numBuffers x bufferSize.
+ *
+ * Buffers are page aligned so they can be used directly as targets of
+ * asynchronous block reads (see AsyncFileReader).
+ */
+
+#ifndef BUFFERRING_H
+#define BUFFERRING_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Alignment of every ring buffer in bytes
+ */
+const size_t RING_BUFFER_ALIGNMENT = 4096;
+
+/**
+ * Releases memory obtained from std::aligned_alloc
+ */
+struct AlignedFree {
+    void operator()(char* p) const { std::free(p); }
+};
+
+/**
+ * One buffer of the ring
+ */
+struct RingBuffer {
+    std::unique_ptr<char[], AlignedFree> data;
+    size_t capacity;    // Bytes allocated
+    size_t size;        // Bytes filled by the producer
+};
+
+/**
+ * BufferRing class - Bounded producer/consumer hand-off of byte buffers
+ */
+class BufferRing {
+public:
+    /**
+     * Default constructor - an unallocated ring; call init() before use
+     */
+    BufferRing();
+
+    /**
+     * Allocates the buffers and resets the ring. Not thread-safe.
+     * @param numBuffers Number of buffers in flight
+     * @param bufferSize Capacity of each buffer in bytes (rounded up to
+     *                   a multiple of RING_BUFFER_ALIGNMENT)
+     */
+    void init(int numBuffers, size_t bufferSize);
+
+    /**
+     * Producer: waits for an empty buffer
+     * @return Empty buffer, or nullptr if the consumer cancelled the ring
+     */
+    RingBuffer* acquireEmpty();
+
+    /**
+     * Producer: hands a filled buffer to the consumer
+     * @param buffer Buffer returned by acquireEmpty()
+     */
+    void publishFull(RingBuffer* buffer);
+
+    /**
+     * Producer: signals that no more buffers will be published
+     * @param failed True if the input ended because of an error
+     */
+    void finish(bool failed);
+
+    /**
+     * Consumer: waits for the next filled buffer
+     * @return Filled buffer, or nullptr once the producer has finished and
+     *         every published buffer has been consumed
+     */
+    RingBuffer* acquireFull();
+
+    /**
+     * Consumer: returns a consumed buffer to the producer
+     * @param buffer Buffer returned by acquireFull()
+     */
+    void releaseEmpty(RingBuffer* buffer);
+
+    /**
+     * Consumer: stops the producer early (e.g. when closing before EOF)
+     */
+    void cancel();
+
+    /**
+     * True if the producer reported an error
+     */
+    bool hasFailed();
+
+private:
+    std::vector<RingBuffer> buffers;
+    std::deque<RingBuffer*> emptyQueue;
+    std::deque<RingBuffer*> fullQueue;
+    std::mutex lock;
+    std::condition_variable changed;
+    bool finished;
+    bool failed;
+    bool cancelled;
+};
+
+#endif // BUFFERRING_H
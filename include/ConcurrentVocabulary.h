@@ -0,0 +1,138 @@
+/**
+ * ConcurrentVocabulary.h
+ *
+ * Word count table shared by all training threads. It is an open
+ * addressing hash table with linear probing whose slots hold
+ * - an atomic pointer to the key, published with compare-and-swap, and
+ * - the positive and negative counts packed into one atomic 64-bit word,
+ *   so counting a token is a single fetch_add.
+ * Key text is copied into a per-thread arena, so inserting a new word
+ * takes no lock and no call to the general-purpose allocator. The slot
+ * array and arena blocks can be backed by huge pages (see LargePageBuffer).
+ *
+ * The table never rehashes. Once it reaches its load limit, further new
+ * words are counted in a small per-thread overflow map instead, which
+ * forEach() reports together with the table.
+ */
+
+#ifndef CONCURRENTVOCABULARY_H
+#define CONCURRENTVOCABULARY_H
+
+#include "DSString.h"
+#include "LargePageBuffer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+/**
+ * ConcurrentVocabulary class - Lock-free shared word count table
+ */
+class ConcurrentVocabulary {
+public:
+    ConcurrentVocabulary();
+
+    /**
+     * Sizes the table and creates one arena per thread
+     * Discards any existing contents. Not thread-safe.
+     *
+     * @param expectedWords Number of distinct words expected (kept under 50% load)
+     * @param numThreads Number of threads that will call add()
+     * @param hugePages Pages to back the slots and arenas with
+     */
+    void reserve(size_t expectedWords, int numThreads, HugePageMode hugePages = HUGE_PAGES_OFF);
+
+    /**
+     * Counts one occurrence of a word
+     * Thread-safe, as long as each thread passes its own thread index.
+     *
+     * @param thread Index of the calling thread (0 to numThreads - 1)
+     * @param text Word bytes
+     * @param length Number of bytes
+     * @param positive True to count a positive occurrence, else negative
+     */
+    void add(int thread, const char* text, int length, bool positive);
+
+    /**
+     * Calls visit(word, positive, negative) for every word counted
+     * A word counted partly in the table and partly as overflow is visited
+     * more than once, so callers must add up the counts they are given.
+     * Not thread-safe; call once every thread has finished adding.
+     */
+    void forEach(const std::function<void(const DSString&, int, int)>& visit) const;
+
+    /**
+     * Number of distinct words in the table (not counting overflow words)
+     */
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    /**
+     * Number of distinct words counted in the overflow maps
+     */
+    size_t overflowWords() const;
+
+    /**
+     * Bytes used by the slot array and the key arenas
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * Pages the slot array got
+     */
+    HugePageMode slotPages() const { return slotMemory.backing(); }
+
+private:
+    /**
+     * A key as stored in an arena; text follows the header
+     */
+    struct KeyRecord {
+        uint64_t hash;
+        uint32_t length;
+        char text[4];           // length bytes (allocation is sized to fit)
+    };
+
+    /**
+     * One table slot
+     */
+    struct Slot {
+        std::atomic<KeyRecord*> key;        // nullptr marks an empty slot
+        std::atomic<uint64_t> counts;       // positive << 32 | negative
+    };
+
+    /**
+     * State owned by one thread: key arena and overflow counts
+     */
+    struct alignas(64) ThreadArena {
+        std::vector<LargePageBuffer> blocks;
+        char* next;             // Free space in the current block
+        size_t remaining;
+        size_t usedBytes;
+        std::map<DSString, std::pair<int, int>> overflow;
+
+        ThreadArena() : next(nullptr), remaining(0), usedBytes(0) {}
+    };
+
+    /**
+     * Copies a key into the thread's arena
+     */
+    KeyRecord* allocateKey(ThreadArena& arena, uint64_t hash, const char* text, int length);
+
+    /**
+     * Returns the most recent allocation of the thread's arena
+     */
+    void releaseKey(ThreadArena& arena, KeyRecord* record);
+
+    LargePageBuffer slotMemory;
+    Slot* slots;                                // Constructed in slotMemory
+    size_t capacity;                            // Power of two
+    size_t maxCount;                            // Load limit
+    std::atomic<size_t> count;
+    std::vector<ThreadArena> arenas;
+    HugePageMode hugePages;
+    size_t arenaBlockBytes;
+};
+
+#endif // CONCURRENTVOCABULARY_H
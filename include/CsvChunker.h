@@ -0,0 +1,96 @@
+/**
+ * CsvChunker.h
+ *
+ * Splits a buffer of CSV text into chunks that start on record boundaries,
+ * so each chunk can be parsed by a different thread.
+ *
+ * A newline only ends a record when it is outside a quoted field, and
+ * whether a byte is inside quotes depends on every quote before it. The
+ * chunker therefore works in two passes:
+ * 1. Every chunk is scanned independently (in parallel) under both
+ *    assumptions - starting outside quotes and starting inside quotes -
+ *    recording the first record-ending newline for each assumption and
+ *    the parity of its quote count.
+ * 2. A prefix pass over the chunk parities (one XOR per chunk) resolves the
+ *    true starting state of every chunk, which selects the right
+ *    speculative boundary.
+ *
+ * Escaped quotes ("") toggle the state twice, so parity alone is exact.
+ */
+
+#ifndef CSVCHUNKER_H
+#define CSVCHUNKER_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * CsvChunker class - Record-aligned parallel splitting of CSV text
+ */
+class CsvChunker {
+public:
+    /**
+     * Marks "no record boundary found"
+     */
+    static const size_t NO_BOUNDARY = static_cast<size_t>(-1);
+
+    /**
+     * Constructor
+     * @param numThreads Threads used for the speculative scan (at least 1)
+     */
+    explicit CsvChunker(int numThreads = 1);
+
+    /**
+     * Splits data into up to numChunks record-aligned chunks
+     * data must start at a record boundary (outside quotes).
+     *
+     * @param data CSV text
+     * @param length Number of bytes in data
+     * @param numChunks Number of chunks wanted
+     * @param atEnd True if no more data follows; otherwise the bytes after the
+     *              last complete record are left out of the chunks
+     * @param boundaries Set to chunk offsets: chunk i is
+     *                   [boundaries[i], boundaries[i + 1]); the last entry is
+     *                   where the unconsumed tail starts. Empty chunks are
+     *                   possible when a chunk contains no record boundary.
+     */
+    void split(const char* data, size_t length, int numChunks, bool atEnd,
+               std::vector<size_t>& boundaries) const;
+
+    /**
+     * Finds the end of the record starting at position
+     *
+     * @param data CSV text
+     * @param position Start of a record (outside quotes)
+     * @param end Offset one past the last byte that may be examined
+     * @return Offset of the record's terminating newline, or end if the
+     *         record is not terminated before end
+     */
+    static size_t recordEnd(const char* data, size_t position, size_t end);
+
+private:
+    /**
+     * Result of the speculative scan of one chunk
+     */
+    struct ChunkScan {
+        bool oddQuotes;             // Chunk contains an odd number of quotes
+        size_t firstBreak[2];       // First record-ending newline if the chunk
+                                    // starts outside [0] / inside [1] quotes
+    };
+
+    /**
+     * Scans one chunk under both starting assumptions
+     */
+    static void scanChunk(const char* data, size_t begin, size_t end, ChunkScan& scan);
+
+    /**
+     * Finds the offset just past the last record-ending newline of data
+     * @param insideAtEnd Quote state after the last byte
+     * @return Offset after the newline, or 0 if there is none
+     */
+    static size_t lastRecordEnd(const char* data, size_t length, bool insideAtEnd);
+
+    int numThreads;
+};
+
+#endif // CSVCHUNKER_H
@@ -37,6 +37,14 @@ public:
      */
     DSString(const char* str);
 
+    /**
+     * Constructor from a character range
+     * Copies exactly len characters; the range need not be null-terminated
+     * @param str Pointer to the first character to copy
+     * @param len Number of characters to copy
+     */
+    DSString(const char* str, int len);
+
     /**
      * Copy constructor
      * Creates a deep copy of another DSString
@@ -125,6 +133,9 @@ public:
 
     /**
      * Converts string to lowercase
+     * UTF-8 aware: ASCII runs are converted 16 bytes at a time and multi-byte
+     * characters are decoded so accented Latin, Greek and Cyrillic capitals are
+     * lowered too. The byte length of the result always equals the original.
      * @return New DSString with all characters converted to lowercase
      */
     DSString toLowerCase() const;
@@ -0,0 +1,103 @@
+/**
+ * DSStringView.h
+ *
+ * Non-owning, read-only view over a range of characters.
+ * Lets the tokenizer and feature stages refer to pieces of a tweet
+ * without allocating a new DSString for every token.
+ *
+ * Like DSString, this class does NOT use <cstring> or <string> internally.
+ */
+
+#ifndef DSSTRINGVIEW_H
+#define DSSTRINGVIEW_H
+
+#include "DSString.h"
+#include <iostream> // For ostream operator<< overloading
+
+/**
+ * DSStringView class - A pointer/length pair referring to characters owned elsewhere
+ *
+ * The viewed characters are not copied and are not null-terminated in general,
+ * so the view must not outlive the buffer it points into.
+ */
+class DSStringView {
+private:
+    const char* data;   // First viewed character (not owned)
+    int length;         // Number of viewed characters
+
+public:
+    /**
+     * Default constructor
+     * Creates an empty view
+     */
+    DSStringView();
+
+    /**
+     * Constructor from a character range
+     * @param str Pointer to the first character
+     * @param len Number of characters in the view
+     */
+    DSStringView(const char* str, int len);
+
+    /**
+     * Constructor from a DSString
+     * The view is only valid while the DSString is alive and unmodified
+     * @param str DSString to view
+     */
+    DSStringView(const DSString& str);
+
+    /**
+     * Equality operator
+     * @param other View to compare with
+     * @return true if both views contain the same characters
+     */
+    bool operator==(const DSStringView& other) const;
+
+    /**
+     * Array subscript operator
+     * @param index Position of character to access
+     * @return Character at specified position
+     * @note Does not perform bounds checking
+     */
+    char operator[](int index) const { return data[index]; }
+
+    /**
+     * Returns the number of viewed characters
+     */
+    int size() const { return length; }
+
+    /**
+     * Returns a pointer to the first viewed character
+     * @note The range is generally NOT null-terminated
+     */
+    const char* begin() const { return data; }
+
+    /**
+     * Returns a pointer one past the last viewed character
+     */
+    const char* end() const { return data + length; }
+
+    /**
+     * Returns a sub-view of this view
+     * @param start Starting position (0-based index)
+     * @param numChars Number of characters to include
+     * @return View of the requested range, clamped to this view
+     */
+    DSStringView substring(int start, int numChars) const;
+
+    /**
+     * Copies the viewed characters into a new, owning DSString
+     * @return DSString with the same characters
+     */
+    DSString toDSString() const;
+
+    /**
+     * Stream insertion operator
+     * @param os Output stream
+     * @param view DSStringView to output
+     * @return Reference to the output stream
+     */
+    friend std::ostream& operator<<(std::ostream& os, const DSStringView& view);
+};
+
+#endif // DSSTRINGVIEW_H
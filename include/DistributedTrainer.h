@@ -0,0 +1,61 @@
+/**
+ * DistributedTrainer.h
+ *
+ * Local coordinator for sharded training. The training input is split into
+ * shards (record-aligned byte ranges of a single file, or balanced lists of
+ * whole files), one forked worker process trains on each shard and writes
+ * a partial model (see ModelFile.h), and the partial models are k-way
+ * merged into the final one.
+ *
+ * Counts are sums over tweets, so the merged model is identical to the
+ * model trained by a single process on the whole file. The same steps can
+ * be run by hand on several machines with --shard and the merge subcommand.
+ */
+
+#ifndef DISTRIBUTEDTRAINER_H
+#define DISTRIBUTEDTRAINER_H
+
+#include "DSString.h"
+#include "InputSet.h"
+#include "SentimentClassifier.h"
+#include <vector>
+
+/**
+ * DistributedTrainer class - Forks shard workers and merges their models
+ */
+class DistributedTrainer {
+public:
+    /**
+     * Constructor
+     * @param numWorkers Number of worker processes (at least 1)
+     */
+    explicit DistributedTrainer(int numWorkers);
+
+    /**
+     * Trains the classifier with one worker process per shard
+     * On success the classifier holds the merged model.
+     *
+     * @param classifier Classifier configured with the tokenizer settings;
+     *                   each worker trains a copy of it
+     * @param inputs Training files; a single file must be uncompressed
+     * @return True on success, false otherwise
+     */
+    bool train(SentimentClassifier& classifier, const InputSet& inputs);
+
+private:
+    /**
+     * Creates a private directory for the partial models
+     * @return False (with a message on stderr) if it cannot be created
+     */
+    bool makeWorkDirectory();
+
+    /**
+     * Removes the partial models and the work directory
+     */
+    void cleanUp(const std::vector<DSString>& files);
+
+    int numWorkers;
+    DSString workDirectory;
+};
+
+#endif // DISTRIBUTEDTRAINER_H
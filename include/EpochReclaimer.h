@@ -0,0 +1,70 @@
+/**
+ * EpochReclaimer.h
+ *
+ * Epoch-based reclamation for objects that readers reach through an atomic
+ * pointer (read-copy-update). A writer publishes a replacement by swapping
+ * the pointer and then calls synchronize(), which returns once no reader
+ * can still be using the old object, so it can be deleted.
+ *
+ * Every reader owns one slot. enter() records the global epoch in the slot
+ * before the reader loads the pointer, exit() clears it again; neither
+ * takes a lock or waits for the writer. synchronize() advances the global
+ * epoch and waits until every slot is either idle or has entered in the
+ * new epoch: such a reader loaded the pointer after the swap.
+ */
+
+#ifndef EPOCHRECLAIMER_H
+#define EPOCHRECLAIMER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * EpochReclaimer class - Waits out readers of a swapped pointer
+ */
+class EpochReclaimer {
+public:
+    /**
+     * Constructor
+     * @param numReaders Number of reader slots (at least 1)
+     */
+    explicit EpochReclaimer(int numReaders);
+
+    /**
+     * Marks a reader as active; call before loading the shared pointer
+     * @param reader Slot of the calling reader, used by one thread at a time
+     */
+    void enter(int reader);
+
+    /**
+     * Marks a reader as idle; the object it loaded may be reclaimed after this
+     */
+    void exit(int reader);
+
+    /**
+     * Advances the epoch and waits until no reader that entered before can
+     * still be active. Call after swapping the pointer, then delete the old
+     * object. Only one thread may synchronize at a time.
+     *
+     * @return Seconds spent waiting for readers
+     */
+    double synchronize();
+
+    int numReaders() const { return readerCount; }
+
+private:
+    /**
+     * Epoch a reader entered in (0 = idle), on a cache line of its own
+     */
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch;
+        ReaderSlot() : epoch(0) {}
+    };
+
+    std::atomic<uint64_t> globalEpoch;
+    int readerCount;
+    std::unique_ptr<ReaderSlot[]> readers;
+};
+
+#endif // EPOCHRECLAIMER_H
@@ -0,0 +1,77 @@
+/**
+ * FingerprintSet.h
+ *
+ * Compact set of 64-bit fingerprints using open addressing with linear
+ * probing. Each slot is a single atomic 64-bit word and inserts claim an
+ * empty slot with compare-and-swap, so any number of threads can insert
+ * concurrently without a lock.
+ *
+ * The capacity is fixed when the set is sized; it never rehashes.
+ */
+
+#ifndef FINGERPRINTSET_H
+#define FINGERPRINTSET_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+/**
+ * FingerprintSet class - Lock-free insert-only hash set of 64-bit keys
+ */
+class FingerprintSet {
+public:
+    /**
+     * Default constructor
+     * Creates an empty set with no capacity; call reserve() before use
+     */
+    FingerprintSet();
+
+    /**
+     * Sizes the set for an expected number of keys (kept under 50% load)
+     * Discards any existing contents. Not thread-safe.
+     * @param expectedKeys Number of distinct keys the set should hold
+     */
+    void reserve(size_t expectedKeys);
+
+    /**
+     * Inserts a fingerprint
+     * Thread-safe. When the set is too full to accept more keys the key is
+     * not stored, true is returned and the overflow counter is incremented.
+     * @param fingerprint Key to insert
+     * @return true if the key was not present before, false if it was
+     */
+    bool insert(uint64_t fingerprint);
+
+    /**
+     * Checks whether a fingerprint has been inserted
+     * @param fingerprint Key to look up
+     * @return true if present
+     */
+    bool contains(uint64_t fingerprint) const;
+
+    /**
+     * Number of keys stored
+     */
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    /**
+     * Number of inserts dropped because the set was full
+     */
+    size_t getOverflows() const { return overflows.load(std::memory_order_relaxed); }
+
+    /**
+     * Bytes used by the slot array
+     */
+    size_t memoryBytes() const { return capacity * sizeof(uint64_t); }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;   // 0 marks an empty slot
+    size_t capacity;                                // Power of two
+    size_t maxCount;                                // Load limit
+    std::atomic<size_t> count;
+    std::atomic<size_t> overflows;
+};
+
+#endif // FINGERPRINTSET_H
@@ -0,0 +1,315 @@
+/**
+ * FrozenModel.h
+ *
+ * Read-only serving form of a trained model. Prediction only needs one
+ * signed weight per word (positive count - negative count), so freezing
+ * replaces the two int counts of the training map with a single weight,
+ * optionally quantized to int16 or int8 with one scale for the model:
+ *
+ *     weight ~= quantized * scale
+ *
+ * The scale is chosen so nearly all weights fit the width. The few that
+ * do not are the most frequent, decisive words, so instead of saturating
+ * they keep their quantized value in a small int32 side table, and their
+ * slot in the weight array holds the most negative value as a marker.
+ *
+ * Everything lives in one contiguous blob that refers to its own parts by
+ * offset, never by pointer, so it can be copied or mapped anywhere:
+ *
+ *   FrozenHeader
+ *   hot slots  2^hotSlotBits x uint64 for the hotWords most frequent words
+ *   cold slots 2^slotBits x uint64 for all other words
+ *   entries    numWords x FrozenEntry (text offset and length)
+ *   weights    numWords x int8/int16/int32
+ *   wide       numWide x FrozenWide, by word id (weights too large for the width)
+ *   text       word bytes, back to back
+ *   guard      Bloom filter bits over the cold words (optional)
+ *
+ * A slot holds hash tag << 32 | (word id + 1), 0 = empty. Word ids follow
+ * descending training frequency, so by Zipf's law the few thousand words
+ * that make up most tokens share the first cache lines of the entries,
+ * weights and text, and the hot slot table is small enough to stay in
+ * L1/L2. Lookups hash the token once, probe the hot table, then the cold
+ * table, and compare the text only when the 32-bit tag matches.
+ *
+ * Tokens missing from the hot table are mostly typos, usernames and other
+ * words the model has never seen. A blocked Bloom filter over the cold
+ * words (one cache line per key) rejects most of them before the cold
+ * table is probed.
+ *
+ * Because nothing in the blob is a pointer, one process can publish it in
+ * a POSIX shared memory segment and any number of scoring processes can
+ * map that segment read-only and look words up in place: they share one
+ * physical copy, and attaching costs an mmap instead of a training run.
+ */
+
+#ifndef FROZENMODEL_H
+#define FROZENMODEL_H
+
+#include "DSString.h"
+#include "LargePageBuffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+/**
+ * Fixed-size header at the start of the blob
+ */
+struct FrozenHeader {
+    char magic[4];              // "SNTF"
+    uint32_t version;
+    uint32_t numWords;
+    uint32_t weightBits;        // 8, 16 or 32
+    float scale;                // Weight of one quantization step
+    uint32_t slotBits;          // log2 of the cold slot count
+    uint32_t hotWords;          // Word ids below this are in the hot table
+    uint32_t hotSlotBits;       // log2 of the hot slot count
+    uint32_t guardHashes;       // Bits per key in the cold-word guard (0 = no guard)
+    uint32_t tokenizerFlags;    // Tokenizer settings of the model (MODEL_FLAG_* bits)
+    uint32_t numWide;           // Entries in the side table
+    uint64_t hotSlotsOffset;
+    uint64_t slotsOffset;
+    uint64_t entriesOffset;
+    uint64_t weightsOffset;
+    uint64_t wideOffset;
+    uint64_t textOffset;
+    uint64_t guardOffset;
+    uint64_t guardBlocks;       // 64-byte blocks in the guard
+    uint64_t totalBytes;
+};
+
+/**
+ * Location of one word's text in the blob
+ */
+struct FrozenEntry {
+    uint32_t textOffset;        // Relative to FrozenHeader::textOffset
+    uint32_t length;
+};
+
+/**
+ * Quantized weight too large for the weight width
+ */
+struct FrozenWide {
+    uint32_t id;
+    int32_t weight;
+};
+
+/**
+ * Choices made when freezing a model
+ */
+struct FreezeOptions {
+    int weightBits;                 // 32, 16 or 8
+    size_t hotWords;                // Most frequent words in the hot table (0 = none)
+    double bloomFalsePositiveRate;  // Target rate of the cold-word guard (0 = no guard)
+    HugePageMode hugePages;         // Pages to back the blob with
+    uint32_t tokenizerFlags;        // Recorded so attaching processes can check their settings
+
+    FreezeOptions()
+        : weightBits(32), hotWords(1024), bloomFalsePositiveRate(0.01), hugePages(HUGE_PAGES_TRANSPARENT),
+          tokenizerFlags(0) {}
+};
+
+/**
+ * Summary of a freeze, for reporting
+ */
+struct FreezeStats {
+    size_t words;               // Words in the model
+    int weightBits;
+    float scale;
+    size_t wide;                // Weights too large for the width, kept in the side table
+    size_t zeroed;              // Non-zero weights that quantized to zero
+    size_t weightBytes;         // Size of the weight array
+    size_t fullWeightBytes;     // Size of the two-int count pairs it replaces
+    size_t totalBytes;          // Size of the whole blob
+    HugePageMode pages;         // Pages the blob got
+    size_t hotWords;            // Words in the hot table
+    size_t hotBytes;            // Hot slots plus the hot words' entries, weights and text
+    double hotShare;            // Fraction of training tokens that are hot words
+    size_t bloomBytes;          // Size of the cold-word guard (0 = none)
+    int bloomHashes;
+    double bloomFalsePositiveRate;  // Expected rate for the cold words inserted
+};
+
+/**
+ * Per-thread lookup counters
+ */
+struct FrozenProbeStats {
+    long long hotHits;          // Found in the hot table
+    long long coldHits;         // Found in the cold table
+    long long misses;           // Not in the model
+    long long bloomSkipped;     // Misses the guard answered without a cold probe
+    long long bloomPassed;      // Cold probes the guard let through
+
+    FrozenProbeStats() : hotHits(0), coldHits(0), misses(0), bloomSkipped(0), bloomPassed(0) {}
+};
+
+/**
+ * FrozenModel class - Compact read-only word weight table
+ */
+class FrozenModel {
+public:
+    FrozenModel();
+    ~FrozenModel();
+    FrozenModel(const FrozenModel&) = delete;
+    FrozenModel& operator=(const FrozenModel&) = delete;
+
+    /**
+     * Builds the frozen model from training counts
+     * The scale is 1 (exact) when every weight fits the chosen width.
+     * Otherwise it is chosen so the 99.9th percentile weight fits, and the
+     * few larger weights go to the int32 side table at the same scale, so
+     * no weight is off by more than half a step.
+     *
+     * @param counts Word counts (positive, negative)
+     * @param options Weight width, hot tier size and guard false-positive rate
+     * @param stats Receives what was lost to quantization and the tier sizes
+     * @return false (with a message on stderr) for invalid options
+     */
+    bool build(const std::map<DSString, std::pair<int, int>>& counts, const FreezeOptions& options,
+               FreezeStats& stats);
+
+    /**
+     * Makes this model a copy of another one in freshly mapped memory
+     * The copy is written by the calling thread, so under the kernel's
+     * first-touch policy its pages land on the caller's NUMA node.
+     *
+     * @param other Frozen model to copy
+     * @param hugePages Pages to back the copy with
+     */
+    void copyFrom(const FrozenModel& other, HugePageMode hugePages);
+
+    /**
+     * Publishes the model in a POSIX shared memory segment
+     * An existing segment of the same name is replaced; processes still
+     * attached to it keep their mapping. The header is completed last, so
+     * a process attaching while the copy is in progress is refused rather
+     * than given half a model.
+     *
+     * @param name Segment name ("/name", see shm_open)
+     * @return false (with a message on stderr) on failure
+     */
+    bool publish(const char* name) const;
+
+    /**
+     * Maps a published model read-only, replacing this one
+     * @param name Segment name given to publish()
+     * @return false (with a message on stderr) if the segment is missing
+     *         or does not hold a complete frozen model of this version
+     */
+    bool attach(const char* name);
+
+    /**
+     * Removes a published segment; attached processes keep their mapping
+     * @return false (with a message on stderr) if it could not be removed
+     */
+    static bool unpublish(const char* name);
+
+    /**
+     * True once build(), copyFrom() or attach() has succeeded
+     */
+    bool isFrozen() const { return base != nullptr; }
+
+    /**
+     * True if the model is mapped from a shared memory segment
+     */
+    bool isShared() const { return shared != nullptr; }
+
+    /**
+     * Tokenizer settings the model was trained with
+     */
+    uint32_t getTokenizerFlags() const { return header()->tokenizerFlags; }
+
+    /**
+     * Number of words in the model
+     */
+    size_t numWords() const { return isFrozen() ? header()->numWords : 0; }
+
+    /**
+     * Looks up the quantized weight of a word
+     * @param word Word bytes
+     * @param length Number of bytes
+     * @param weight Receives the quantized weight if found
+     * @param probes Counts which tier answered and what the guard skipped
+     * @return true if the word is in the model
+     */
+    bool lookup(const char* word, int length, int& weight, FrozenProbeStats& probes) const;
+
+    /**
+     * Looks up the quantized weights of many words
+     * Words are hashed a group at a time, and the slots and guard blocks
+     * of the whole group are prefetched before the first one is probed, so
+     * the cache misses of a group overlap instead of following each other.
+     * Results and probe counts are the same as calling lookup() per word.
+     *
+     * @param words Start of each word
+     * @param lengths Number of bytes of each word
+     * @param count Number of words
+     * @param weights Receives each word's quantized weight (0 if not found)
+     * @param found Receives 1 for each word in the model, 0 otherwise
+     * @param probes Counts which tier answered and what the guard skipped
+     */
+    void lookupBatch(const char* const* words, const int* lengths, size_t count, int* weights, uint8_t* found,
+                     FrozenProbeStats& probes) const;
+
+    /**
+     * Weight of one quantization step
+     */
+    float getScale() const { return header()->scale; }
+
+    /**
+     * Size of the blob in bytes
+     */
+    size_t sizeBytes() const { return isFrozen() ? header()->totalBytes : 0; }
+
+    /**
+     * Discards the frozen model
+     */
+    void clear();
+
+private:
+    const FrozenHeader* header() const { return reinterpret_cast<const FrozenHeader*>(base); }
+
+    /**
+     * Points the cached views at the sections of the blob at base
+     */
+    void setViews();
+
+    /**
+     * Probes one slot table for a word
+     * @return Word id + 1, or 0 if the word is not in the table
+     */
+    uint32_t probe(const uint64_t* table, uint64_t mask, uint64_t hash, const char* word, int length) const;
+
+    /**
+     * Looks up a word whose hash is already known
+     */
+    bool lookupHashed(const char* word, int length, uint64_t hash, int& weight, FrozenProbeStats& probes) const;
+
+    /**
+     * Reads the quantized weight of a word id
+     */
+    int weightOf(uint32_t id) const;
+
+    LargePageBuffer blob;       // Blob built or copied by this process
+    void* shared;               // Or: read-only mapping of a published blob
+    size_t sharedBytes;
+    const char* base;           // Start of whichever holds the model
+
+    // Cached views into the blob (all derived from the header offsets)
+    const uint64_t* hotSlots;
+    const uint64_t* slots;
+    const FrozenEntry* entries;
+    const void* weights;
+    const FrozenWide* wide;
+    uint32_t numWide;
+    const char* text;
+    uint64_t hotSlotMask;
+    uint64_t slotMask;
+    int weightBits;
+    const uint64_t* guardBits;  // nullptr = no guard
+    size_t guardBlocks;
+    int guardHashes;
+};
+
+#endif // FROZENMODEL_H
@@ -0,0 +1,33 @@
+/**
+ * Hash64.h
+ *
+ * Fast non-cryptographic 64-bit hashing shared by the fingerprinting,
+ * caching and model lookup code. Bytes are consumed 8 at a time and the
+ * result is finished with the MurmurHash3 64-bit avalanche step, so every
+ * input bit affects every output bit.
+ */
+
+#ifndef HASH64_H
+#define HASH64_H
+
+#include <cstdint>
+
+/**
+ * Hashes a range of bytes
+ * @param data Pointer to the first byte
+ * @param length Number of bytes to hash
+ * @param seed Starting value; chaining hash64 calls with the previous result
+ *             as seed hashes a sequence of ranges
+ * @return 64-bit hash value
+ */
+uint64_t hash64(const char* data, int length, uint64_t seed = 0);
+
+/**
+ * Mixes a 64-bit value so nearby inputs give unrelated outputs
+ * (MurmurHash3 fmix64 finalizer)
+ * @param value Value to mix
+ * @return Mixed value
+ */
+uint64_t mix64(uint64_t value);
+
+#endif // HASH64_H
@@ -0,0 +1,168 @@
+/**
+ * InputReader.h
+ *
+ * Line reader for training and test files that transparently handles
+ * compressed input. The format is detected from the file's magic bytes:
+ * - gzip (1F 8B)        decompressed with zlib
+ * - zstd (28 B5 2F FD)  decompressed with libzstd
+ * - anything else       read as plain text
+ *
+ * A dedicated producer thread reads (and decompresses) the file into a ring
+ * of large buffers while the caller parses lines out of them, so
+ * decompression overlaps with parsing and no temporary file is written.
+ * Uncompressed regular files are read by AsyncFileReader, which keeps
+ * several block reads in flight (io_uring, or a pread thread pool).
+ *
+ * gzip support needs zlib (-lz) and zstd support needs libzstd (-lzstd);
+ * each is compiled in only when its header is available, and a file in an
+ * unsupported format is reported as an error when opened.
+ */
+
+#ifndef INPUTREADER_H
+#define INPUTREADER_H
+
+#include "DSString.h"
+#include "BufferRing.h"
+#include "AsyncFileReader.h"
+#include <cstddef>
+#include <string>
+#include <thread>
+
+/**
+ * Input formats recognized by magic bytes
+ */
+enum InputFormat {
+    INPUT_PLAIN,
+    INPUT_GZIP,
+    INPUT_ZSTD
+};
+
+/**
+ * InputReader class - Buffered, optionally decompressing line reader
+ */
+class InputReader {
+public:
+    /**
+     * Constructor
+     * The ring holds queueDepth + 2 buffers of blockSize bytes: queueDepth
+     * reads in flight, one buffer being parsed and one ready behind it.
+     *
+     * @param queueDepth Block reads kept in flight for uncompressed files
+     * @param blockSize Bytes per read and per ring buffer
+     */
+    InputReader(int queueDepth = AsyncFileReader::DEFAULT_QUEUE_DEPTH,
+                size_t blockSize = AsyncFileReader::DEFAULT_BLOCK_SIZE);
+
+    /**
+     * Destructor - stops the producer thread and closes the file
+     */
+    ~InputReader();
+
+    /**
+     * Marks "read to the end of the file" for open()'s rangeEnd
+     */
+    static const size_t WHOLE_FILE = static_cast<size_t>(-1);
+
+    /**
+     * Opens a file, detects its format and starts the producer thread
+     * A byte range can only be read from an uncompressed regular file.
+     *
+     * @param path Path of the file to read ("/dev/stdin" works for pipes)
+     * @param rangeBegin Offset of the first byte to read
+     * @param rangeEnd Offset one past the last byte to read
+     * @return true on success; false (with a message on stderr) otherwise
+     */
+    bool open(const DSString& path, size_t rangeBegin = 0, size_t rangeEnd = WHOLE_FILE);
+
+    /**
+     * Reads the next line, without the trailing newline
+     * Follows std::getline: a final line without a newline is returned,
+     * but a trailing newline does not produce an extra empty line.
+     * @param line Receives the line
+     * @return false at end of input
+     */
+    bool readLine(std::string& line);
+
+    /**
+     * Appends the next block of raw (decompressed) bytes to out
+     * For callers that split records themselves; may be mixed with readLine().
+     *
+     * @param out String to append to
+     * @return false at end of input (nothing appended)
+     */
+    bool readBytes(std::string& out);
+
+    /**
+     * Stops the producer thread and closes the file
+     */
+    void close();
+
+    /**
+     * True if reading stopped because of an I/O or decompression error
+     */
+    bool hasError();
+
+    /**
+     * Detected format of the open file
+     */
+    InputFormat getFormat() const { return format; }
+
+    /**
+     * Name of a format ("plain", "gzip", "zstd")
+     */
+    static const char* formatName(InputFormat format);
+
+    /**
+     * Detects the format from the first bytes of a file
+     * @param magic Up to four leading bytes
+     * @param length Number of bytes available in magic
+     */
+    static InputFormat detectFormat(const char* magic, int length);
+
+    /**
+     * How the file was read ("io_uring", "pread" or "read");
+     * valid once readLine() has returned false
+     */
+    const char* readMethod() const { return method; }
+
+    /**
+     * Rough upper bound of the uncompressed size in bytes, for sizing tables
+     * (0 if the input is a pipe)
+     */
+    size_t sizeHint() const { return sizeEstimate; }
+
+private:
+    /**
+     * Reads raw file bytes, first returning any bytes consumed by format detection
+     * @return Number of bytes read, 0 at end of file, -1 on error
+     */
+    long readRaw(char* destination, size_t length);
+
+    // Producer thread bodies
+    void produce();
+    bool producePlain();
+    bool produceGzip();
+    bool produceZstd();
+
+    int fd;
+    int queueDepth;
+    size_t blockSize;
+    size_t fileBytes;           // Size of a regular file, 0 for pipes
+    size_t rangeBegin;          // Byte range being read from a regular file
+    size_t rangeEnd;
+    bool regularFile;
+    const char* method;         // Set by the producer thread before it finishes
+    InputFormat format;
+    size_t sizeEstimate;
+    char magic[4];              // Bytes read while detecting the format
+    int magicLength;
+    int magicPosition;
+
+    BufferRing ring;
+    std::thread producer;
+    RingBuffer* current;        // Buffer being parsed (consumer side)
+    size_t position;            // Parse position inside current
+    bool endOfInput;
+};
+
+#endif // INPUTREADER_H
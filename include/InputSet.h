@@ -0,0 +1,122 @@
+/**
+ * InputSet.h
+ *
+ * The list of files behind one input argument. An argument may name
+ * - a single file (or a pipe such as /dev/stdin),
+ * - a directory, meaning every regular file directly inside it,
+ * - a glob pattern such as "data/2024-*.csv.gz" (quoted so the shell
+ *   passes it through), or
+ * - a manifest, written "@list.txt": one path, directory or pattern per
+ *   line, relative to the manifest's directory; blank lines and lines
+ *   starting with '#' are ignored.
+ *
+ * Every file is a complete CSV file with its own header. A file entry may
+ * also be a byte range of a file (a training shard), which starts after
+ * the header.
+ */
+
+#ifndef INPUTSET_H
+#define INPUTSET_H
+
+#include "DSString.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * One file (or byte range of a file) in an InputSet
+ */
+struct InputFile {
+    DSString path;
+    size_t bytes;           // Bytes to read from disk (0 for pipes)
+    size_t estimate;        // Rough uncompressed size, used for scheduling
+    size_t begin;           // First byte to read
+    size_t end;             // One past the last byte (InputReader::WHOLE_FILE for all)
+
+    /**
+     * True if the entry starts at the beginning of the file, so its first
+     * record is the CSV header
+     */
+    bool hasHeader() const { return begin == 0; }
+};
+
+/**
+ * InputSet class - Expanded list of input files
+ */
+class InputSet {
+public:
+    InputSet();
+
+    /**
+     * Expands an input argument and appends its files
+     * @param spec File, directory, glob pattern or @manifest
+     * @return false (with a message on stderr) if it names nothing readable
+     */
+    bool add(const DSString& spec);
+
+    /**
+     * Appends a byte range of an uncompressed file
+     */
+    void addRange(const DSString& path, size_t begin, size_t end);
+
+    /**
+     * Orders the files by decreasing estimated size (ties by path), so
+     * workers pulling files in order start the longest jobs first
+     */
+    void sortLargestFirst();
+
+    /**
+     * Splits the files into numShards sets of similar total size
+     * Longest processing time first: each file, largest first, goes to the
+     * currently smallest shard. The result only depends on the file list,
+     * so independent processes compute the same assignment.
+     *
+     * @param numShards Number of shards
+     * @param shards Set to numShards sets, each sorted largest first
+     */
+    void assignShards(int numShards, std::vector<InputSet>& shards) const;
+
+    size_t size() const { return files.size(); }
+    bool empty() const { return files.empty(); }
+    const InputFile& operator[](size_t index) const { return files[index]; }
+
+    /**
+     * Sum of the estimated uncompressed sizes (0 if unknown, e.g. pipes)
+     */
+    size_t totalEstimate() const;
+
+    /**
+     * Sum of the bytes read from disk
+     */
+    size_t totalBytes() const;
+
+private:
+    /**
+     * Appends one file after checking it can be opened
+     */
+    bool addFile(const DSString& path);
+
+    /**
+     * Appends every regular file in a directory, in name order
+     */
+    bool addDirectory(const DSString& path);
+
+    /**
+     * Appends every file matching a glob pattern, in name order
+     */
+    bool addPattern(const DSString& pattern);
+
+    /**
+     * Expands every line of a manifest file
+     * @param depth Nesting level, to stop manifests that include each other
+     */
+    bool addManifest(const DSString& path, int depth);
+
+    /**
+     * Expands one argument
+     */
+    bool addSpec(const DSString& spec, int depth);
+
+    std::vector<InputFile> files;
+};
+
+#endif // INPUTSET_H
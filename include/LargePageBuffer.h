@@ -0,0 +1,98 @@
+/**
+ * LargePageBuffer.h
+ *
+ * Zero-filled anonymous memory for big, randomly accessed tables (frozen
+ * model blobs, vocabulary slots and key arenas). With 4 KiB pages a lookup
+ * in a table of many megabytes usually misses the TLB as well as the cache;
+ * backing the table with 2 MiB pages lets a few TLB entries cover it.
+ *
+ * Memory comes straight from mmap:
+ * - explicit: MAP_HUGETLB pages from the hugetlbfs pool
+ *   (vm.nr_hugepages must be configured)
+ * - transparent: a 2 MiB aligned mapping advised with MADV_HUGEPAGE, which
+ *   the kernel backs with huge pages when it can
+ * - off: ordinary pages
+ * Each mode falls back to the next one when its pages are not available,
+ * and backing() reports what was actually obtained.
+ */
+
+#ifndef LARGEPAGEBUFFER_H
+#define LARGEPAGEBUFFER_H
+
+#include <cstddef>
+
+/**
+ * Page sizes to request for large buffers
+ */
+enum HugePageMode {
+    HUGE_PAGES_OFF,
+    HUGE_PAGES_TRANSPARENT,
+    HUGE_PAGES_EXPLICIT
+};
+
+/**
+ * LargePageBuffer class - Owns one anonymous memory mapping
+ */
+class LargePageBuffer {
+public:
+    /**
+     * Size of one huge page (x86-64 and arm64 default)
+     */
+    static const size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+
+    LargePageBuffer();
+    ~LargePageBuffer();
+    LargePageBuffer(LargePageBuffer&& other) noexcept;
+    LargePageBuffer& operator=(LargePageBuffer&& other) noexcept;
+    LargePageBuffer(const LargePageBuffer&) = delete;
+    LargePageBuffer& operator=(const LargePageBuffer&) = delete;
+
+    /**
+     * Maps a zero-filled buffer, replacing any previous one
+     * Buffers smaller than a huge page always use ordinary pages.
+     *
+     * @param bytes Usable size of the buffer
+     * @param mode Largest page size to try
+     * @return false if no memory could be mapped at all
+     */
+    bool allocate(size_t bytes, HugePageMode mode);
+
+    /**
+     * Unmaps the buffer
+     */
+    void release();
+
+    char* data() const { return memory; }
+    size_t size() const { return bytes; }
+
+    /**
+     * Pages actually used: HUGE_PAGES_TRANSPARENT means the mapping was
+     * advised, not that the kernel has already backed it with huge pages
+     */
+    HugePageMode backing() const { return pages; }
+
+    /**
+     * Parses a mode name: off, thp or hugetlb
+     * @return false for an unknown name
+     */
+    static bool parseMode(const char* name, HugePageMode& mode);
+
+    /**
+     * Returns the name of a mode
+     */
+    static const char* modeName(HugePageMode mode);
+
+    /**
+     * Describes the pages behind a buffer, for reports
+     */
+    static const char* describeBacking(HugePageMode pages);
+
+private:
+    char* memory;               // Start of the usable buffer
+    size_t bytes;
+    void* mapping;              // Start and length of the whole mapping
+    size_t mappedBytes;
+    HugePageMode pages;
+};
+
+#endif // LARGEPAGEBUFFER_H
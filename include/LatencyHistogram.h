@@ -0,0 +1,112 @@
+/**
+ * LatencyHistogram.h
+ *
+ * HDR-style latency histogram in nanoseconds. Values below 256 ns get a
+ * bucket each; above that every power of two is split into 128 equal
+ * sub-buckets, so any recorded value is known to within 1% with a fixed
+ * 35 KiB of counters covering up to about 18 minutes. The exact maximum is
+ * kept separately.
+ *
+ * A histogram has one writer: each thread records into its own, with a
+ * relaxed load and store per counter (no locked read-modify-write, since
+ * no other thread writes it). Readers may merge a histogram into a
+ * private one at any time; they see every count at most a few
+ * nanoseconds late, never a torn one.
+ */
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * LatencyHistogram class - Log-linear buckets of latencies
+ */
+class LatencyHistogram {
+public:
+    /**
+     * Sub-buckets per power of two (2^7 = 128: under 1% error)
+     */
+    static const int SUB_BUCKET_BITS = 7;
+
+    /**
+     * Values from 2^MAX_BITS ns (about 18 minutes) on share the last bucket
+     */
+    static const int MAX_BITS = 40;
+
+    LatencyHistogram();
+
+    /**
+     * Records one latency; only one thread may record into a histogram
+     * @param nanos Latency in nanoseconds
+     */
+    void record(uint64_t nanos);
+
+    /**
+     * Records one latency given as a clock duration
+     */
+    void record(std::chrono::steady_clock::duration elapsed) {
+        record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    /**
+     * Adds another histogram's counts to this one
+     * The other histogram may be recorded into meanwhile; this one may not.
+     */
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * Clears all counts (not while another thread records)
+     */
+    void reset();
+
+    /**
+     * Number of recorded values
+     */
+    uint64_t count() const { return counts->total.load(std::memory_order_relaxed); }
+
+    /**
+     * Largest recorded value in nanoseconds
+     */
+    uint64_t maxValue() const { return counts->max.load(std::memory_order_relaxed); }
+
+    /**
+     * Value below which the given percentage of recorded values lie
+     * @param percent Percentile, such as 99.9
+     * @return Upper end of the bucket holding that value in nanoseconds
+     *         (at most maxValue()), or 0 if nothing was recorded
+     */
+    uint64_t valueAtPercentile(double percent) const;
+
+    /**
+     * Formats p50, p90, p99, p99.9 and max in microseconds, for reports
+     */
+    std::string summary() const;
+
+private:
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int NUM_BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + SUB_BUCKETS;
+
+    /**
+     * Bucket of a value
+     */
+    static int bucketOf(uint64_t nanos);
+
+    /**
+     * Largest value that falls into a bucket
+     */
+    static uint64_t highestInBucket(int bucket);
+
+    struct Counts {
+        std::atomic<uint64_t> buckets[NUM_BUCKETS];
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> max;
+    };
+    std::unique_ptr<Counts> counts;
+};
+
+#endif // LATENCYHISTOGRAM_H
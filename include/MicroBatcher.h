@@ -0,0 +1,200 @@
+/**
+ * MicroBatcher.h
+ *
+ * Queue between the connections of the scoring server and its scoring
+ * threads. Connections submit requests; a scoring thread takes them as a
+ * batch once the batch target is reached or the oldest waiting request
+ * has waited for the batch delay, whichever comes first, and scores the
+ * whole batch with one batched lookup.
+ *
+ * Both limits adapt to the traffic. Every tuning window the delay follows
+ * the p99 queueing-plus-scoring latency (halved when p99 exceeds the
+ * latency target, raised slowly while p99 is well below it, never above
+ * the configured maximum), and the batch target becomes the number of
+ * requests expected to arrive within one delay at the observed arrival
+ * rate. Light traffic therefore gets a target of one and is dispatched
+ * immediately, while heavy traffic fills batches without waiting out the
+ * delay.
+ *
+ * The queue is bounded. Every client (connection) has a queue of its own
+ * inside the batcher, batches take one request per client in turn, and a
+ * client may hold at most a fixed number of queued requests, so a client
+ * with a deep pipeline cannot starve the others. When either limit is
+ * reached, submit() blocks the submitting connection, which stops reading
+ * from its socket (backpressure through TCP flow control), or, with load
+ * shedding on, returns at once and leaves the rest of the requests to be
+ * refused.
+ */
+
+#ifndef MICROBATCHER_H
+#define MICROBATCHER_H
+
+#include "DSString.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+struct RequestGroup;
+struct ScoreRequest;
+
+/**
+ * Requests of one client waiting in the batcher
+ * Owned by the client's connection; must be empty when it is destroyed.
+ */
+struct ClientQueue {
+    std::deque<ScoreRequest*> requests;
+    bool scheduled;             // In the batcher's round-robin order
+
+    ClientQueue() : scheduled(false) {}
+};
+
+/**
+ * One tweet to score
+ */
+struct ScoreRequest {
+    DSString text;
+    int score;                                      // Set when the request completes
+    std::chrono::steady_clock::time_point arrival;  // Set by submit()
+    RequestGroup* group;                            // Notified when the request completes
+};
+
+/**
+ * Requests submitted together (the pipelined lines of one connection
+ * read), waited for together
+ */
+struct RequestGroup {
+    std::mutex lock;
+    std::condition_variable done;
+    size_t remaining;
+    void (*onComplete)(void* context);  // If set, called instead of waking wait(); the group
+    void* context;                      // may be destroyed as soon as it is called
+
+    RequestGroup() : remaining(0), onComplete(nullptr), context(nullptr) {}
+
+    /**
+     * Blocks until every request of the group has completed
+     */
+    void wait();
+};
+
+/**
+ * Current batching policy and counters, for the stats command
+ */
+struct BatcherStats {
+    long long requests;         // Requests completed
+    long long batches;          // Batches completed
+    size_t queued;              // Requests waiting now
+    size_t queueLimit;          // Most requests that may wait
+    long long shed;             // Requests refused because the queue was full
+    long long blocked;          // Times a connection waited for queue space
+    size_t targetBatch;         // Current batch target
+    int delayMicros;            // Current batch delay
+    double arrivalRate;         // Requests per second in the last window
+    long long p99Micros;        // p99 latency in the last window
+};
+
+/**
+ * MicroBatcher class - Forms batches under size and deadline limits
+ */
+class MicroBatcher {
+public:
+    /**
+     * Length of one tuning window
+     */
+    static const int TUNE_WINDOW_MS = 100;
+
+    /**
+     * Constructor
+     * @param maxBatch Largest batch (1 disables batching)
+     * @param maxDelayMicros Longest time a request may wait for its batch to fill
+     * @param latencyTargetMicros p99 latency the delay is tuned against
+     * @param queueLimit Most requests waiting at once
+     * @param clientLimit Most requests one client may have waiting
+     */
+    MicroBatcher(size_t maxBatch, int maxDelayMicros, int latencyTargetMicros, size_t queueLimit,
+                 size_t clientLimit);
+
+    /**
+     * Queues a client's requests, in order
+     * Without shedding, waits for queue space as often as needed until all
+     * are queued (or stop() is called); with shedding, queues what fits
+     * and returns immediately.
+     *
+     * @param client Queue of the submitting client
+     * @param requests Requests to queue
+     * @param count Number of requests
+     * @param shed True to refuse what does not fit instead of waiting
+     * @return Number of requests queued (the first ones); only these will
+     *         be completed
+     */
+    size_t submit(ClientQueue& client, ScoreRequest* const* requests, size_t count, bool shed);
+
+    /**
+     * Waits for the next batch
+     * @param batch Receives the requests of the batch
+     * @return False once stop() was called and the queue is empty
+     */
+    bool takeBatch(std::vector<ScoreRequest*>& batch);
+
+    /**
+     * Completes a scored batch: wakes the submitters (or calls their
+     * completion function) and records latencies
+     */
+    void complete(const std::vector<ScoreRequest*>& batch);
+
+    /**
+     * Lets takeBatch() return false once the queue is drained
+     */
+    void stop();
+
+    BatcherStats stats();
+
+private:
+    /**
+     * Adapts the delay and the batch target at the end of a window
+     * (called with the lock held)
+     */
+    void retune(std::chrono::steady_clock::time_point now);
+
+    /**
+     * Arrival time of the oldest waiting request (called with the lock
+     * held and at least one request queued)
+     */
+    std::chrono::steady_clock::time_point oldestArrival() const;
+
+    const size_t maxBatch;
+    const int maxDelayMicros;
+    const int latencyTargetMicros;
+    const size_t queueLimit;
+    const size_t clientLimit;
+
+    std::mutex lock;
+    std::condition_variable arrived;
+    std::condition_variable spaceFreed;
+    std::deque<ClientQueue*> clients;   // Clients with waiting requests, in round-robin order
+    size_t queued;
+    bool stopping;
+
+    // Policy in effect
+    size_t targetBatch;
+    int delayMicros;
+
+    // Current tuning window
+    std::chrono::steady_clock::time_point windowStart;
+    long long windowArrivals;
+    std::vector<long long> windowLatencies;     // Microseconds, up to MAX_SAMPLES
+
+    // Totals and the results of the last window
+    long long requests;
+    long long batches;
+    long long shed;
+    long long blocked;
+    double arrivalRate;
+    long long p99Micros;
+};
+
+#endif // MICROBATCHER_H
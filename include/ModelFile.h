@@ -0,0 +1,158 @@
+/**
+ * ModelFile.h
+ *
+ * Binary format for trained count models, used to save a model, load it
+ * for prediction, and combine partial models trained on separate shards.
+ *
+ * Layout (native byte order, little-endian on every supported platform):
+ *   ModelHeader
+ *   numWords word records, sorted by DSString order:
+ *       uint32 length, int32 positive, int32 negative, length bytes of text
+ *   if MODEL_SUBWORD is set:
+ *       uint32 bucketBits, int32 minN, int32 maxN,
+ *       2^bucketBits x (int32 positive, int32 negative)
+ *
+ * Because word records are sorted, several models can be merged with a
+ * streaming k-way merge that never holds more than one record per input.
+ */
+
+#ifndef MODELFILE_H
+#define MODELFILE_H
+
+#include "DSString.h"
+#include <cstdint>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+/**
+ * Current format version
+ */
+const uint32_t MODEL_FORMAT_VERSION = 1;
+
+/**
+ * Tokenizer settings recorded in ModelHeader::flags. Models can only be
+ * merged or used for prediction with the settings they were trained with.
+ */
+const uint32_t MODEL_STEMMED = 1u << 0;
+const uint32_t MODEL_NEGATION = 1u << 1;
+const uint32_t MODEL_SUBWORD = 1u << 2;
+
+/**
+ * Fixed-size header at the start of every model file
+ */
+struct ModelHeader {
+    char magic[4];              // "SNTM"
+    uint32_t version;           // MODEL_FORMAT_VERSION
+    uint32_t flags;             // MODEL_* bits
+    uint32_t reserved;
+    int64_t totalPositive;      // Positive training tweets counted
+    int64_t totalNegative;      // Negative training tweets counted
+    uint64_t numWords;          // Number of word records that follow
+
+    /**
+     * Constructor - an empty model with the magic and version filled in
+     */
+    ModelHeader();
+};
+
+/**
+ * ModelWriter class - Writes a model file record by record
+ */
+class ModelWriter {
+public:
+    ModelWriter();
+
+    /**
+     * Creates the file and writes a provisional header
+     * @param path Output path
+     * @param header Header to write; numWords is filled in by close()
+     * @return false (with a message on stderr) if the file cannot be created
+     */
+    bool open(const DSString& path, const ModelHeader& header);
+
+    /**
+     * Appends one word record; words must be written in ascending order
+     */
+    void writeWord(const DSString& word, int positive, int negative);
+
+    /**
+     * Appends the subword section (only if MODEL_SUBWORD is set)
+     */
+    void writeSubword(unsigned int bucketBits, int minN, int maxN,
+                      const std::vector<std::pair<int, int>>& counts);
+
+    /**
+     * Rewrites the header with the final word count and closes the file
+     * @return false (with a message on stderr) if any write failed
+     */
+    bool close();
+
+    /**
+     * Closes and deletes a partly written file
+     */
+    void discard();
+
+private:
+    std::ofstream out;
+    DSString path;
+    ModelHeader header;
+};
+
+/**
+ * ModelReader class - Reads a model file record by record
+ */
+class ModelReader {
+public:
+    ModelReader();
+
+    /**
+     * Opens a model file and validates its header
+     * @return false (with a message on stderr) if the file is missing or not a model
+     */
+    bool open(const DSString& path);
+
+    /**
+     * Header of the open file
+     */
+    const ModelHeader& getHeader() const { return header; }
+
+    /**
+     * Reads the next word record
+     * @return false once all numWords records have been read, or on error
+     */
+    bool nextWord(DSString& word, int& positive, int& negative);
+
+    /**
+     * Reads the subword section; call after every word has been read
+     * @return false (with a message on stderr) if it is missing or malformed
+     */
+    bool readSubword(unsigned int& bucketBits, int& minN, int& maxN,
+                     std::vector<std::pair<int, int>>& counts);
+
+    /**
+     * True if a read failed or the file ended early
+     */
+    bool hasError() const { return failed; }
+
+private:
+    std::ifstream in;
+    DSString path;
+    ModelHeader header;
+    uint64_t wordsRead;
+    std::vector<char> buffer;   // Word text scratch space
+    bool failed;
+};
+
+/**
+ * Merges partial models into one by summing the counts of equal words
+ * All inputs must have been trained with the same tokenizer settings.
+ * On failure no output file is left behind.
+ *
+ * @param inputs Paths of the partial models
+ * @param output Path of the merged model
+ * @return true on success; false (with a message on stderr) otherwise
+ */
+bool mergeModelFiles(const std::vector<DSString>& inputs, const DSString& output);
+
+#endif // MODELFILE_H
@@ -0,0 +1,98 @@
+/**
+ * NumaTopology.h
+ *
+ * NUMA nodes of the machine and the CPUs this process may run on in each,
+ * read from /sys/devices/system/node (no libnuma needed). Parser threads
+ * are spread over the nodes in contiguous groups and pinned to all CPUs
+ * of their node with sched_setaffinity, so the scheduler can still move a
+ * thread within its node but never across the interconnect.
+ *
+ * Machines without NUMA information in sysfs, or whose allowed CPUs all
+ * sit on one node, are treated as a single node, and pinning is skipped.
+ */
+
+#ifndef NUMATOPOLOGY_H
+#define NUMATOPOLOGY_H
+
+#include <sched.h>
+#include <vector>
+
+/**
+ * NUMA placement modes for parser threads
+ */
+enum NumaMode {
+    NUMA_OFF,               // Leave placement to the scheduler
+    NUMA_PIN,               // Pin every thread to the CPUs of one node
+    NUMA_REPLICATE          // Pin, and give every node its own copy of the frozen model
+};
+
+/**
+ * NumaTopology class - Nodes, their CPUs and thread placement
+ */
+class NumaTopology {
+public:
+    /**
+     * Reads the topology of the calling process's allowed CPUs
+     */
+    NumaTopology();
+
+    /**
+     * Number of nodes with at least one allowed CPU (at least 1)
+     */
+    int numNodes() const { return static_cast<int>(nodeIds.size()); }
+
+    /**
+     * System number of a node (its nodeN directory in sysfs)
+     */
+    int nodeId(int node) const { return nodeIds[node]; }
+
+    /**
+     * Allowed CPUs of a node
+     */
+    const std::vector<int>& nodeCpus(int node) const { return cpus[node]; }
+
+    /**
+     * Node a thread slot is placed on: slots are split into contiguous
+     * groups, one per node, sized by the node's CPU count
+     *
+     * @param slot Index of the thread slot
+     * @param numSlots Number of thread slots
+     * @return Node index (0 to numNodes() - 1)
+     */
+    int nodeOfSlot(int slot, int numSlots) const;
+
+    /**
+     * Restricts the calling thread to the CPUs of one node
+     * @return false if the affinity could not be set
+     */
+    bool pinCurrentThread(int node) const;
+
+    /**
+     * Gives the calling thread back the process's original CPU set
+     */
+    void unpinCurrentThread() const;
+
+    /**
+     * Parses a sysfs CPU list such as "0-3,8-11"
+     * @return false if the text is malformed
+     */
+    static bool parseCpuList(const char* text, std::vector<int>& cpuList);
+
+    /**
+     * Parses a mode name: off, pin or replicate
+     * @return false for an unknown name
+     */
+    static bool parseMode(const char* name, NumaMode& mode);
+
+    /**
+     * Returns the name of a mode
+     */
+    static const char* modeName(NumaMode mode);
+
+private:
+    std::vector<int> nodeIds;
+    std::vector<std::vector<int>> cpus;
+    cpu_set_t allowed;                  // Affinity of the process at startup
+};
+
+#endif // NUMATOPOLOGY_H
@@ -0,0 +1,128 @@
+/**
+ * PorterStemmer.h
+ *
+ * Porter (1980) suffix-stripping stemmer plus a fixed-size memoizing cache.
+ * Maps inflected forms such as "waiting", "waited" and "waits" onto a common
+ * stem ("wait") so they share one entry in the classifier's vocabulary.
+ *
+ * Both classes work on caller-provided character buffers and never allocate
+ * per token: the stemmer rewrites a copy of the word in place and the cache
+ * stores short words and their stems inline in a flat array.
+ */
+
+#ifndef PORTERSTEMMER_H
+#define PORTERSTEMMER_H
+
+#include "DSStringView.h"
+#include <vector>
+
+/**
+ * PorterStemmer class - The classic Porter stemming algorithm
+ *
+ * Only lowercase ASCII words are stemmed; words containing any other
+ * character (digits, UTF-8 bytes, ...) are copied through unchanged.
+ * Words longer than MAX_WORD_LENGTH should be passed through by the caller,
+ * since the output buffer only has room for MAX_WORD_LENGTH characters.
+ */
+class PorterStemmer {
+public:
+    /**
+     * Longest word the stemmer will rewrite. Callers must provide an output
+     * buffer of at least this many characters.
+     */
+    static const int MAX_WORD_LENGTH = 64;
+
+    /**
+     * Stems a word into a caller-provided buffer
+     * The stem is never longer than the input word.
+     *
+     * @param word The (lowercase) word to stem; truncated to MAX_WORD_LENGTH
+     * @param out Output buffer with room for at least MAX_WORD_LENGTH characters
+     * @return Length of the stem written to out (not null-terminated)
+     */
+    int stem(const DSStringView& word, char* out);
+
+private:
+    char* b;    // Buffer being stemmed
+    int k;      // Index of the last character of the current word
+    int j;      // General offset into the word, set by ends()
+
+    bool isConsonant(int i) const;
+    int measure() const;
+    bool vowelInStem() const;
+    bool doubleConsonant(int i) const;
+    bool consonantVowelConsonant(int i) const;
+    bool ends(const char* suffix);
+    void setTo(const char* suffix);
+    void replaceIfMeasured(const char* suffix);
+
+    void step1ab();
+    void step1c();
+    void step2();
+    void step3();
+    void step4();
+    void step5();
+};
+
+/**
+ * StemCache class - Direct-mapped cache of recent word -> stem mappings
+ *
+ * Tweet text repeats a small set of hot words constantly, so most lookups
+ * hit the cache and skip the stemming algorithm entirely. Each slot holds
+ * the word and its stem inline (one 64-byte slot per entry); words longer
+ * than MAX_CACHED_LENGTH bypass the cache and are stemmed directly.
+ */
+class StemCache {
+public:
+    /**
+     * Longest word (and therefore stem) stored in a cache slot
+     */
+    static const int MAX_CACHED_LENGTH = 29;
+
+    /**
+     * Constructor
+     * @param numSlots Number of cache slots, rounded up to a power of two
+     */
+    explicit StemCache(int numSlots = 4096);
+
+    /**
+     * Returns the stem of a word, consulting the cache first
+     *
+     * @param word The (lowercase) word to stem
+     * @param out Output buffer with room for at least PorterStemmer::MAX_WORD_LENGTH characters
+     * @return Length of the stem written to out (not null-terminated)
+     */
+    int stem(const DSStringView& word, char* out);
+
+    /**
+     * Number of lookups answered from the cache
+     */
+    long long getHits() const { return hits; }
+
+    /**
+     * Number of lookups that ran the stemming algorithm
+     */
+    long long getMisses() const { return misses; }
+
+    /**
+     * Resets the hit/miss counters without evicting cached stems
+     */
+    void resetStats() { hits = 0; misses = 0; }
+
+private:
+    struct Slot {
+        unsigned int tag;           // Hash of the cached word (0 = empty)
+        unsigned char wordLength;   // Length of the cached word
+        unsigned char stemLength;   // Length of its stem
+        char word[MAX_CACHED_LENGTH];
+        char stem[MAX_CACHED_LENGTH];
+    };
+
+    std::vector<Slot> slots;
+    unsigned int mask;      // numSlots - 1
+    PorterStemmer stemmer;
+    long long hits;
+    long long misses;
+};
+
+#endif // PORTERSTEMMER_H
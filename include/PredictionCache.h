@@ -0,0 +1,120 @@
+/**
+ * PredictionCache.h
+ *
+ * Bounded cache of sentiment scores keyed by a 64-bit hash of the
+ * normalized tweet text. In a real stream a large share of scored texts are
+ * exact retweets; a hit returns the cached score without tokenizing.
+ *
+ * The cache is split into independently locked shards, and each shard is
+ * set-associative: a key maps to one set of WAYS entries and eviction within
+ * the set follows the CLOCK (second chance) policy. Memory is fixed at
+ * construction time.
+ */
+
+#ifndef PREDICTIONCACHE_H
+#define PREDICTIONCACHE_H
+
+#include "DSString.h"
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * PredictionCache class - Sharded, set-associative CLOCK cache of scores
+ */
+class PredictionCache {
+public:
+    /**
+     * Number of independently locked shards (power of two)
+     */
+    static const int NUM_SHARDS = 64;
+
+    /**
+     * Entries per set
+     */
+    static const int WAYS = 8;
+
+    /**
+     * Default constructor - a disabled cache that never hits
+     */
+    PredictionCache();
+
+    /**
+     * Sizes the cache and clears it. Not thread-safe.
+     * @param capacity Approximate number of entries (0 disables the cache)
+     */
+    void configure(size_t capacity);
+
+    /**
+     * True if the cache has been given a non-zero capacity
+     */
+    bool isEnabled() const { return setsPerShard > 0; }
+
+    /**
+     * Computes the cache key of a tweet text
+     * ASCII letters are case folded and runs of spaces collapsed, so
+     * trivially different copies of a text share one key. Only spaces are
+     * folded: tabs and line breaks are not token delimiters, so texts that
+     * differ in them may score differently.
+     * @param text Tweet text
+     * @return 64-bit key
+     */
+    static uint64_t textKey(const DSString& text);
+
+    /**
+     * Looks up a score
+     * Thread-safe.
+     * @param key Key from textKey()
+     * @param score Set to the cached score on a hit
+     * @return true on a hit
+     */
+    bool lookup(uint64_t key, int& score);
+
+    /**
+     * Stores a score, evicting an entry from the key's set if it is full
+     * Thread-safe.
+     * @param key Key from textKey()
+     * @param score Score to cache
+     */
+    void insert(uint64_t key, int score);
+
+    /**
+     * Total hits, misses and evictions across all shards
+     * Read while no lookups or inserts are in flight.
+     */
+    long long getHits() const;
+    long long getMisses() const;
+    long long getEvictions() const;
+
+    /**
+     * Resets the counters without clearing cached scores
+     */
+    void resetStats();
+
+    /**
+     * Prints hit rate and occupancy
+     */
+    void printStats() const;
+
+private:
+    struct Set {
+        uint64_t keys[WAYS];        // 0 marks an empty way
+        int scores[WAYS];
+        unsigned char referenced;   // CLOCK reference bit per way
+        unsigned char hand;         // CLOCK hand position
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::vector<Set> sets;
+        long long hits;
+        long long misses;
+        long long evictions;
+    };
+
+    Shard shards[NUM_SHARDS];
+    size_t setsPerShard;
+};
+
+#endif // PREDICTIONCACHE_H
@@ -0,0 +1,191 @@
+/**
+ * ScoringServer.h
+ *
+ * Long-running scoring daemon. Clients connect over TCP and send one
+ * request per line:
+ *
+ *   SCORE <tweet text>   ->  OK <sentiment> <score>
+ *   MODEL                ->  OK generation <n> words <count>
+ *   STATS                ->  OK requests <n> batches <n> ... (batching policy and
+ *                            latency percentiles)
+ *   PING                 ->  OK
+ *   (any SCORE when full)->  UNAVAILABLE       (with load shedding on)
+ *   QUIT                    (closes the connection)
+ *
+ * Anything else is answered with "ERR <reason>". Requests on one
+ * connection are answered in order.
+ *
+ * Connection threads only read and write. SCORE requests are queued in a
+ * MicroBatcher, and a fixed set of scoring threads, each owning one
+ * worker slot of the classifier, score them in batches. The batcher's
+ * queue is bounded overall and per connection: when it is full a
+ * connection stops reading from its socket until there is room again, or,
+ * with load shedding on, answers the requests that do not fit with
+ * UNAVAILABLE right away.
+ *
+ * The server scores with a saved model file (see ModelFile.h), frozen if
+ * requested. The directory holding the file is watched with inotify; when
+ * the file is rewritten or another file is renamed over it, the new model
+ * is loaded and frozen on a background thread while requests keep being
+ * answered by the old one. The new model is then published by swapping an
+ * atomic pointer, and the old one is deleted once every request that
+ * started before the swap has finished (see EpochReclaimer.h). Requests
+ * never wait for a reload, and a model that fails to load is reported and
+ * ignored.
+ */
+
+#ifndef SCORINGSERVER_H
+#define SCORINGSERVER_H
+
+#include "DSString.h"
+#include "EpochReclaimer.h"
+#include "FrozenModel.h"
+#include "LatencyHistogram.h"
+#include "MicroBatcher.h"
+#include "SentimentClassifier.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Settings of a scoring server
+ */
+struct ServerOptions {
+    DSString modelFile;             // Saved model to serve and watch
+    int port;                       // TCP port on the loopback interface
+    int threads;                    // Scoring threads (one classifier slot each)
+    size_t maxBatch;                // Micro-batching limits (see MicroBatcher.h)
+    int batchDelayMicros;
+    int latencyTargetMicros;
+    size_t queueLimit;              // Requests waiting for a scoring thread, in total
+    size_t clientLimit;             // ... and per connection
+    bool shed;                      // Refuse requests that do not fit instead of waiting
+    bool stemming;                  // Tokenizer settings the model was trained with
+    bool negation;
+    bool subword;
+    int freezeBits;                 // 0 = score from the loaded counts
+    FreezeOptions freezeOptions;
+    size_t cacheEntries;            // Prediction cache per model (0 = off)
+    bool watch;                     // Reload the model when its file changes
+
+    ServerOptions()
+        : port(7878), threads(1), maxBatch(64), batchDelayMicros(200), latencyTargetMicros(2000), queueLimit(4096),
+          clientLimit(1024), shed(false), stemming(false), negation(false), subword(false), freezeBits(0),
+          cacheEntries(0), watch(true) {}
+};
+
+/**
+ * ScoringServer class - Answers scoring requests and hot-swaps the model
+ */
+class ScoringServer {
+public:
+    /**
+     * Longest accepted request line in bytes
+     */
+    static const size_t MAX_LINE_BYTES = 64 * 1024;
+
+    explicit ScoringServer(const ServerOptions& options);
+    ~ScoringServer();
+    ScoringServer(const ScoringServer&) = delete;
+    ScoringServer& operator=(const ScoringServer&) = delete;
+
+    /**
+     * Loads the model, starts listening and starts the file watcher
+     * @return False (with a message on stderr) if any step fails
+     */
+    bool start();
+
+    /**
+     * Accepts connections until requestStop() is called, then closes every
+     * connection and stops the scoring threads and the watcher
+     */
+    void run();
+
+    /**
+     * Asks a running server to stop; safe to call from a signal handler
+     */
+    static void requestStop();
+
+private:
+    /**
+     * One loaded model, replaced as a whole on reload
+     */
+    struct ServingModel {
+        SentimentClassifier classifier;
+        uint64_t generation;
+        size_t words;
+    };
+
+    /**
+     * One client connection and the thread serving it
+     */
+    struct Connection {
+        int socket;
+        ClientQueue queue;              // Its requests waiting in the batcher
+        std::thread thread;
+        std::atomic<bool> finished;
+        Connection() : socket(-1), finished(false) {}
+    };
+
+    ServerOptions options;
+    int listenSocket;
+    std::atomic<ServingModel*> current;
+    EpochReclaimer epochs;              // One reader slot per scoring thread
+    uint64_t generation;                // Generation of the last model loaded (reload thread only)
+    std::atomic<uint64_t> servingGeneration;    // Of the model in use, for MODEL
+    std::atomic<size_t> servingWords;
+    MicroBatcher batcher;
+    std::vector<std::thread> scorers;
+    std::vector<LatencyHistogram> requestLatency;   // Per scoring thread: queueing and scoring per request
+    std::vector<LatencyHistogram> batchLatency;     // Per scoring thread: scoring per batch
+    std::thread watcher;
+    std::list<Connection> connections;  // Acceptor thread only
+
+    static std::atomic<bool> stopRequested;
+
+    /**
+     * Builds a classifier from the model file
+     * @return The new model, or nullptr (with a message on stderr)
+     */
+    ServingModel* loadServingModel();
+
+    /**
+     * Loads the model file again, swaps it in and reclaims the old model
+     */
+    void reloadModel();
+
+    /**
+     * Watches the model file's directory and reloads on changes
+     * @param notifier inotify descriptor, closed on return
+     */
+    void watchLoop(int notifier);
+
+    /**
+     * Scores batches from the batcher until it is stopped
+     * @param slot Classifier worker slot and epoch reader slot of the thread
+     */
+    void scoreLoop(int slot);
+
+    /**
+     * Answers the requests of one connection until it closes
+     */
+    void serveConnection(Connection* connection);
+
+    /**
+     * Answers one request line other than SCORE
+     * @param reply Set to the response line, without the newline
+     * @return False if the connection should be closed
+     */
+    bool handleCommand(const char* line, size_t length, std::string& reply);
+
+    /**
+     * Joins the threads of connections that have closed
+     * @param all True to close and join every connection
+     */
+    void reapConnections(bool all);
+};
+
+#endif // SCORINGSERVER_H
@@ -0,0 +1,91 @@
+/**
+ * SentimentApi.h
+ *
+ * C interface to the classifier, for embedding it in other programs
+ * (including non-C++ ones through their foreign function interfaces)
+ * instead of running ./sentiment on files. Build every source except
+ * main.cpp, the tests and the benchmarks into a static or shared library
+ * (see the README); with -fvisibility=hidden only the functions below are
+ * exported.
+ *
+ * The interface only passes plain C types and an opaque handle, so a
+ * program built against one version of the library keeps working with
+ * later ones. Functions never throw; failures are reported through the
+ * return value with a message on stderr, and loading reports the model it
+ * read on stdout, as the command line program does.
+ *
+ * A loaded model may be used by any number of threads at once. Each call
+ * to sentiment_score_batch() borrows one of the model's worker slots for
+ * its duration; when all are in use, further callers wait for one.
+ */
+
+#ifndef SENTIMENTAPI_H
+#define SENTIMENTAPI_H
+
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define SENTIMENT_API __attribute__((visibility("default")))
+#else
+#define SENTIMENT_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Loaded model (opaque)
+ */
+typedef struct sentiment_model sentiment_model;
+
+/**
+ * Tokenizer flags for sentiment_load_model(); must match the flags the
+ * model was trained with
+ */
+#define SENTIMENT_STEM 1u         /* Porter stemming (--stem) */
+#define SENTIMENT_NEGATION 2u     /* Negation scope marking (--negation) */
+#define SENTIMENT_NGRAMS 4u       /* Character n-grams for unknown words (--ngrams) */
+
+/**
+ * Loads a model saved with --save-model
+ * @param path Model file
+ * @param flags Tokenizer flags (SENTIMENT_STEM | ...)
+ * @param freeze_bits 32, 16 or 8 to score with a frozen model of that
+ *        weight width, 0 to score with the full counts
+ * @param cache_entries Prediction cache capacity (0 = no cache)
+ * @param max_callers Worker slots: threads that can score at the same
+ *        time (0 = one per core)
+ * @return The model, or NULL if it could not be loaded
+ */
+SENTIMENT_API sentiment_model* sentiment_load_model(const char* path, unsigned flags, int freeze_bits,
+                                                    size_t cache_entries, int max_callers);
+
+/**
+ * Scores a batch of tweet texts
+ * Texts need not be null-terminated. Scores are the sums of word weights:
+ * positive suggests positive sentiment, and the label the command line
+ * program writes is 4 for a score above zero and 0 otherwise.
+ *
+ * @param model Model from sentiment_load_model()
+ * @param texts UTF-8 text of each tweet
+ * @param lens Length of each text in bytes
+ * @param n Number of texts
+ * @param out Receives the score of each text
+ * @return 0 on success, -1 on invalid arguments, lack of memory or any
+ *         other failure
+ */
+SENTIMENT_API int sentiment_score_batch(sentiment_model* model, const char** texts, const size_t* lens, size_t n,
+                                        float* out);
+
+/**
+ * Frees a model; no call may be using it
+ * @param model Model from sentiment_load_model(), or NULL
+ */
+SENTIMENT_API void sentiment_free_model(sentiment_model* model);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENTIMENTAPI_H
@@ -10,9 +10,24 @@
 #define SENTIMENTCLASSIFIER_H
 
 #include "DSString.h"
+#include "DSStringView.h"
+#include "PorterStemmer.h"
+#include "SubwordFeatures.h"
+#include "TweetDeduplicator.h"
+#include "PredictionCache.h"
+#include "InputReader.h"
+#include "InputSet.h"
+#include "ConcurrentVocabulary.h"
+#include "FrozenModel.h"
+#include "NumaTopology.h"
+#include "LatencyHistogram.h"
 #include <vector>
 #include <map>
+#include <memory>
 #include <fstream>
+#include <functional> // for the batch parsing callbacks
+#include <mutex>
+#include <string>
 #include <utility> // for std::pair
 
 /**
@@ -47,24 +62,327 @@ private:
     int totalPositiveTweets;
     int totalNegativeTweets;
     
+    /**
+     * Optional stemming stage applied to every token after tokenization
+     * Each parser thread uses the stem cache of its WorkerState.
+     */
+    bool stemmingEnabled;
+    
+    /**
+     * Optional negation scope marking
+     * Tokens between a negator and the next clause punctuation are prefixed
+     * with NEGATION_MARKER. '!' is itself a delimiter, so a marked token can
+     * never collide with an ordinary word in wordSentimentCounts.
+     */
+    static const char NEGATION_MARKER = '!';
+    bool negationEnabled;
+    
+    /**
+     * Optional training-set deduplication (retweets, copy-paste spam)
+     */
+    DedupeMode dedupeMode;
+    TweetDeduplicator deduplicator;
+    
+    /**
+     * Optional shared training table: parser threads count words directly
+     * into one lock-free table instead of handing tokens to the serial merge.
+     * Only used without deduplication, which must see tweets in input order.
+     */
+    bool sharedVocabularyEnabled;
+    ConcurrentVocabulary sharedVocabulary;
+    HugePageMode sharedVocabularyPages;     // Pages for its slots and key arenas
+    
+    /**
+     * Optional frozen serving model: one (possibly quantized) weight per word
+     * in a compact table, used by prediction instead of wordSentimentCounts.
+     * With the parity check on, every scored tweet is also scored at full
+     * precision and label changes are counted.
+     */
+    FrozenModel frozenModel;
+    HugePageMode frozenPages;
+    FrozenProbeStats frozenProbes;
+    bool freezeCheckEnabled;
+    long long parityTweets;
+    long long parityMismatches;
+    double parityError;
+    
+    /**
+     * Optional cache of scores for repeated tweet texts in the predict path
+     */
+    PredictionCache predictionCache;
+    
+    /**
+     * Input reading: block reads kept in flight and bytes per read
+     */
+    int readQueueDepth;
+    size_t readBlockSize;
+    
+    /**
+     * Optional hashed character n-gram features, used to score tokens that
+     * are missing from wordSentimentCounts
+     */
+    bool subwordEnabled;
+    SubwordFeatures subwordFeatures;
+    
+    /**
+     * Subword counters: tokens hashed during training and the time spent,
+     * and out-of-vocabulary tokens scored from n-grams during prediction
+     */
+    long long subwordTokensTrained;
+    double subwordSeconds;
+    long long subwordTokensScored;
+    
+    /**
+     * Tokenizer throughput counters (tokens produced and time spent tokenizing)
+     */
+    long long tokensProcessed;
+    double tokenizeSeconds;
+    
+    /**
+     * State owned by one parser thread: its stem cache and the counters it
+     * updates while tokenizing and scoring, summed into the phase totals
+     * above once the phase ends. Cache-line aligned so neighbouring workers
+     * never write to the same line.
+     */
+    struct alignas(64) WorkerState {
+        StemCache stemCache;
+        long long tokens;
+        double tokenizeSeconds;
+        long long subwordScored;
+        int positiveTweets;         // Tweets counted into the shared vocabulary
+        int negativeTweets;
+        long long parityTweets;     // Frozen model parity check
+        long long parityMismatches;
+        double parityError;
+        FrozenProbeStats probes;    // Frozen model lookups by tier
+        int node;                   // NUMA node the thread runs on
+        long long tweetsPredicted;  // Prediction throughput
+        double predictSeconds;
+        LatencyHistogram tweetLatency;      // Scoring time per tweet
+        LatencyHistogram chunkLatency;      // Parsing and scoring time per batch chunk
+        std::vector<const char*> batchWords;    // Scratch space of scoreTexts
+        std::vector<int> batchLengths;
+        std::vector<int> batchWeights;
+        std::vector<uint8_t> batchFound;
+        
+        WorkerState() : tokens(0), tokenizeSeconds(0.0), subwordScored(0), positiveTweets(0), negativeTweets(0),
+                        parityTweets(0), parityMismatches(0), parityError(0.0), node(0), tweetsPredicted(0),
+                        predictSeconds(0.0) {}
+    };
+    
+    /**
+     * Parser threads used by train and predict, one WorkerState each
+     */
+    int numThreads;
+    std::vector<WorkerState> workers;
+    
+    /**
+     * NUMA placement: with more than one node, parser thread slots are
+     * pinned to the CPUs of their node, and in replicate mode each node
+     * scores with its own copy of the frozen model (index = node)
+     */
+    NumaMode numaMode;
+    NumaTopology numaTopology;
+    std::vector<std::unique_ptr<FrozenModel>> frozenReplicas;
+    
+    /**
+     * True if thread slots are pinned to NUMA nodes
+     */
+    bool numaPinning() const { return numaMode != NUMA_OFF && numaTopology.numNodes() > 1; }
+    
+    /**
+     * Assigns every worker slot its NUMA node
+     */
+    void assignNodes();
+    
+    /**
+     * Copies the frozen model onto every NUMA node when replicating
+     */
+    void replicateFrozenModel();
+    
+    /**
+     * Discards the frozen model and its replicas
+     */
+    void clearFrozenModel();
+    
+    /**
+     * Prints prediction throughput per NUMA node
+     */
+    void printNodeStats() const;
+    
+    /**
+     * Prints the latency percentiles of the parser threads, merged
+     */
+    void printLatencyStats() const;
+    
+    /**
+     * Bytes of input read per parallel parsing batch
+     */
+    static const size_t PARSE_BATCH_BYTES = 4 << 20;
+    
     /**
      * Tokenizes a tweet text into individual words
-     * Splits text by spaces and punctuation, converts to lowercase
+     * Splits text by spaces and punctuation, converts to lowercase,
+     * emits each emoji as its own token, stems each word when stemming
+     * is enabled, and marks words inside a negation scope when negation
+     * handling is enabled
      * 
      * @param tweetText The text of the tweet to tokenize
+     * @param stemCache Stem cache of the calling thread
      * @return Vector of DSString objects representing individual words
      */
-    std::vector<DSString> tokenizeTweet(const DSString& tweetText) const;
+    std::vector<DSString> tokenizeTweet(const DSString& tweetText, StemCache& stemCache) const;
+    
+    /**
+     * Emits one word found by the tokenizer and updates the negation scope
+     * 
+     * @param tokens Token list to append to
+     * @param text Lowercased tweet text
+     * @param wordStart Index of the first character of the word
+     * @param wordEnd Index one past the last character of the word
+     * @param negated Negation scope flag, set when the word is a negator
+     * @param stemCache Stem cache of the calling thread
+     */
+    void endWord(std::vector<DSString>& tokens, const char* text,
+                 int wordStart, int wordEnd, bool& negated, StemCache& stemCache) const;
+    
+    /**
+     * Appends one word to a token list, stemming it first if enabled
+     * 
+     * @param tokens Token list to append to
+     * @param word View of the (lowercase) word inside the tweet text
+     * @param negated True to prefix the token with NEGATION_MARKER
+     * @param stemCache Stem cache of the calling thread
+     */
+    void appendToken(std::vector<DSString>& tokens, const DSStringView& word, bool negated,
+                     StemCache& stemCache) const;
+    
+    /**
+     * Prints tokenizer throughput and, if stemming, the stem cache hit rate
+     * 
+     * @param phase Name of the phase being reported (e.g. "Training")
+     */
+    void printTokenizerStats(const char* phase) const;
+    
+    /**
+     * Prints how the last input was read (format, I/O backend or file pool)
+     */
+    void printInputStats() const;
     
     /**
      * Calculates a sentiment score for a tweet based on the training data
+     * Tokens missing from the vocabulary are scored from their character
+     * n-grams when subword features are enabled.
      * If score is positive, the tweet is classified as positive (4)
      * If score is negative or zero, the tweet is classified as negative (0)
      * 
      * @param tokens Vector of words from a tokenized tweet
+     * @param worker State of the calling thread (counts n-gram fallbacks)
+     * @return The sentiment score (positive value suggests positive sentiment)
+     */
+    int calculateSentimentScore(const std::vector<DSString>& tokens, WorkerState& worker) const;
+    
+    /**
+     * Turns the quantized sum of a tweet's frozen weights into its score
+     * and runs the parity check if enabled
+     * 
+     * @param tokens Vector of words from the tokenized tweet
+     * @param quantizedSum Sum of the quantized weights of the words found
+     * @param subwordScore Score of the words scored from their n-grams
+     * @param model Frozen model the weights came from
+     * @param worker State of the calling thread
+     * @return The sentiment score
+     */
+    int frozenScore(const std::vector<DSString>& tokens, long long quantizedSum, int subwordScore,
+                    const FrozenModel& model, WorkerState& worker) const;
+    
+    /**
+     * Scores tokens at full precision from wordSentimentCounts
+     * 
+     * @param tokens Vector of words from a tokenized tweet
+     * @param subwordScored Incremented for every n-gram fallback
+     * @return The sentiment score
+     */
+    int countScore(const std::vector<DSString>& tokens, long long& subwordScored) const;
+    
+    /**
+     * Scores one tweet text, consulting the prediction cache first
+     * Safe to call from several parser threads at once.
+     * 
+     * @param tweetText The text of the tweet
+     * @param worker State of the calling thread
      * @return The sentiment score (positive value suggests positive sentiment)
      */
-    int calculateSentimentScore(const std::vector<DSString>& tokens) const;
+    int scoreTweet(const DSString& tweetText, WorkerState& worker);
+    
+    /**
+     * Reads a CSV input in batches and parses every batch in parallel
+     * The header record is skipped if requested. Each batch is split into record-aligned
+     * chunks by CsvChunker (quoted fields may contain commas and newlines),
+     * every chunk is parsed on a thread of its own, and mergeChunk then runs
+     * for each chunk in order on the calling thread, so results can be
+     * combined in input order.
+     * 
+     * @param input Open reader positioned at the start of the file
+     * @param skipHeader True to skip the first record (the CSV header)
+     * @param parseRecord Called as parseRecord(slot, record) for every
+     *                    record, on the thread of that chunk; slot indexes
+     *                    workers
+     * @param mergeChunk Called with each chunk's slot after every batch
+     * @param firstSlot Slot of the first chunk
+     * @param numSlots Maximum number of chunks (and threads) per batch
+     * @param mergeLock Held around the merges if not null, for callers that
+     *                  parse several inputs at once
+     * @return False if reading the input failed
+     */
+    bool parseInBatches(InputReader& input, bool skipHeader,
+                        const std::function<void(int, const DSString&)>& parseRecord,
+                        const std::function<void(int)>& mergeChunk,
+                        int firstSlot, int numSlots, std::mutex* mergeLock);
+    
+    /**
+     * Parses every record of an input set
+     * A single file is split across all parser threads by parseInBatches.
+     * Several files are handed out whole to a pool of parser threads,
+     * largest first so the longest files do not start last; each thread
+     * parses into its own slot and merges under a lock after every batch.
+     * 
+     * @param inputs Files to parse
+     * @param role Kind of input ("training", "test"), for messages
+     * @param parseRecord Called as parseRecord(slot, record) for every record
+     * @param mergeChunk Called with a slot whose parsed records are ready
+     * @return False (with a message on stderr) if a file could not be read
+     */
+    bool parseInputs(const InputSet& inputs, const char* role,
+                     const std::function<void(int, const DSString&)>& parseRecord,
+                     const std::function<void(int)>& mergeChunk);
+    
+    /**
+     * Description of the last parsed input, printed by printInputStats()
+     */
+    std::string inputStats;
+    
+    /**
+     * Model file flags describing the current tokenizer settings
+     */
+    unsigned int modelFlags() const;
+    
+    /**
+     * Resets the per-thread counters and stem cache statistics
+     */
+    void resetWorkerStats();
+    
+    /**
+     * Sums the per-thread counters into the phase totals
+     */
+    void collectWorkerStats();
+    
+public:
+    /**
+     * Default constructor
+     * Initializes counters and data structures
+     */
+    SentimentClassifier();
     
     /**
      * Parses a CSV line into its components
@@ -75,13 +393,85 @@ private:
      * @return Vector of DSString objects for each column in the CSV
      */
     std::vector<DSString> parseCSVLine(const DSString& line, bool hasSentiment) const;
-
-public:
+    
     /**
-     * Default constructor
-     * Initializes counters and data structures
+     * Enables or disables the Porter stemming stage
+     * Must be set before training so training and prediction agree on tokens.
+     * 
+     * @param enabled True to stem every token after tokenization
      */
-    SentimentClassifier();
+    void setStemmingEnabled(bool enabled);
+    
+    /**
+     * Enables or disables hashed character n-gram features
+     * Must be set before training so the n-gram buckets are filled.
+     * 
+     * @param enabled True to score out-of-vocabulary tokens from their n-grams
+     */
+    void setSubwordFeaturesEnabled(bool enabled);
+    
+    /**
+     * Enables or disables negation scope marking in the tokenizer
+     * Must be set before training so training and prediction agree on tokens.
+     * 
+     * @param enabled True to mark tokens between a negator and the next clause punctuation
+     */
+    void setNegationEnabled(bool enabled);
+    
+    /**
+     * Selects how duplicate training tweets are detected and skipped
+     * 
+     * @param mode Deduplication strategy (DEDUPE_OFF to count every tweet)
+     */
+    void setDedupeMode(DedupeMode mode);
+    
+    /**
+     * Selects whether training threads count words in one shared lock-free
+     * table (ConcurrentVocabulary) instead of merging their tokens serially
+     * The model is the same either way, except that with deduplication
+     * the parser threads also decide which copy of a duplicate is kept.
+     * 
+     * @param enabled True to use the shared table
+     */
+    void setSharedVocabularyEnabled(bool enabled);
+    
+    /**
+     * Selects the pages backing the shared training table
+     * 
+     * @param mode HUGE_PAGES_OFF, HUGE_PAGES_TRANSPARENT or HUGE_PAGES_EXPLICIT
+     */
+    void setSharedVocabularyPages(HugePageMode mode);
+    
+    /**
+     * Enables the prediction cache for repeated tweet texts
+     * 
+     * @param capacity Number of cached scores (0 disables the cache)
+     */
+    void setPredictionCacheCapacity(size_t capacity);
+    
+    /**
+     * Sets how uncompressed input files are read
+     * 
+     * @param queueDepth Number of block reads kept in flight
+     * @param blockSize Bytes per read
+     */
+    void setReadOptions(int queueDepth, size_t blockSize);
+    
+    /**
+     * Sets the number of threads that parse and tokenize input in parallel
+     * Results do not depend on the thread count.
+     * 
+     * @param threads Number of parser threads (at least 1)
+     */
+    void setNumThreads(int threads);
+    
+    /**
+     * Selects NUMA placement of parser threads
+     * Machines with a single node ignore it.
+     * 
+     * @param mode NUMA_OFF, NUMA_PIN or NUMA_REPLICATE
+     */
+    void setNumaMode(NumaMode mode);
     
     /**
      * Trains the sentiment classifier on labeled data
@@ -89,28 +479,148 @@ public:
      * Reads the training CSV file, processes each tweet:
      * 1. Extracts sentiment, tweet ID, and text
      * 2. Tokenizes the text into words
-     * 3. Updates word frequency counts based on the tweet's sentiment
+     * 3. Skips the tweet if deduplication is on and it was seen before
+     * 4. Updates word frequency counts based on the tweet's sentiment
+     * 
+     * @param trainingData Training CSV file, directory, glob pattern or
+     *                     @manifest (see InputSet.h)
+     * @return True if training was successful, false otherwise
+     */
+    bool train(const DSString& trainingData);
+    
+    /**
+     * Trains on every file (or shard) of an input set
+     * All files feed the same counts. Without deduplication the result does
+     * not depend on the order in which files are processed.
      * 
-     * @param trainingDataFile Path to the training CSV file
+     * @param inputs Training files
      * @return True if training was successful, false otherwise
      */
-    bool train(const DSString& trainingDataFile);
+    bool train(const InputSet& inputs);
+    
+    /**
+     * Splits training input into shards for training in separate processes
+     * A single uncompressed file is split into record-aligned byte ranges
+     * (without the header) with the parallel quote-aware scan of CsvChunker.
+     * Several files are assigned whole, balancing total size with
+     * InputSet::assignShards. Either way every process computing the shards
+     * for the same input gets the same result.
+     * 
+     * @param inputs Training files
+     * @param numShards Number of shards
+     * @param shards Set to numShards input sets (some may be empty)
+     * @return False (with a message on stderr) if the input cannot be sharded
+     */
+    bool planShards(const InputSet& inputs, int numShards, std::vector<InputSet>& shards) const;
+    
+    /**
+     * Writes the trained counts to a binary model file (see ModelFile.h)
+     * 
+     * @param modelFile Path of the model file to write
+     * @return True on success, false otherwise
+     */
+    bool saveModel(const DSString& modelFile) const;
+    
+    /**
+     * Replaces the trained counts with those of a binary model file
+     * The model must have been trained with the current tokenizer settings.
+     * 
+     * @param modelFile Path of the model file to read
+     * @return True on success, false otherwise
+     */
+    bool loadModel(const DSString& modelFile);
+    
+    /**
+     * Freezes the trained counts into the compact serving model
+     * Prediction then looks words up in the frozen model. Quantization
+     * statistics, the size of the hot tier and the guard are printed.
+     * 
+     * @param options Weight width, hot tier size and guard false-positive rate
+     * @return True on success, false otherwise
+     */
+    bool freezeModel(const FreezeOptions& options);
+    
+    /**
+     * Publishes the frozen model in a POSIX shared memory segment so other
+     * scoring processes can attach to it without training
+     * 
+     * @param name Segment name, such as /sentiment-model
+     * @return True on success, false otherwise
+     */
+    bool publishModel(const DSString& name) const;
+    
+    /**
+     * Uses a frozen model published by another process instead of training
+     * The segment is mapped read-only and shared with every other process
+     * attached to it. Its tokenizer settings must match the current ones,
+     * and subword n-grams are not available (they are not part of a
+     * frozen model).
+     * 
+     * @param name Segment name given to publishModel()
+     * @return True on success, false otherwise
+     */
+    bool attachModel(const DSString& name);
+    
+    /**
+     * Enables scoring every tweet at full precision as well when the model
+     * is frozen, to report how many predictions quantization changed
+     * 
+     * @param enabled True to run the parity check during prediction
+     */
+    void setFreezeCheckEnabled(bool enabled);
+    
+    /**
+     * Number of words in the trained (or loaded) vocabulary
+     */
+    size_t getVocabularySize() const { return wordSentimentCounts.size(); }
+    
+    /**
+     * Number of worker slots (the parser thread count)
+     */
+    int getNumThreads() const { return numThreads; }
+    
+    /**
+     * Scores one tweet text on behalf of a serving thread
+     * Safe to call from several threads at once as long as each passes a
+     * different slot.
+     * 
+     * @param tweetText The text of the tweet
+     * @param slot Worker slot of the caller (0 to getNumThreads() - 1)
+     * @return The sentiment score (positive value suggests positive sentiment)
+     */
+    int scoreText(const DSString& tweetText, int slot);
+    
+    /**
+     * Scores a batch of tweet texts on behalf of a serving thread
+     * With a frozen model the words of all uncached tweets are looked up
+     * together (see FrozenModel::lookupBatch); scores are the same as
+     * scoring each text with scoreText().
+     * 
+     * @param tweetTexts The texts to score
+     * @param count Number of texts
+     * @param scores Receives the score of each text
+     * @param slot Worker slot of the caller (0 to getNumThreads() - 1)
+     */
+    void scoreTexts(const DSString* const* tweetTexts, size_t count, int* scores, int slot);
     
     /**
      * Predicts sentiments for tweets in test data
      * 
      * Reads the test CSV file (without sentiment labels), for each tweet:
      * 1. Extracts tweet ID and text
-     * 2. Tokenizes the text into words
-     * 3. Calculates sentiment score based on training data
+     * 2. Looks the text up in the prediction cache, if enabled
+     * 3. Otherwise tokenizes the text and calculates its sentiment score
      * 4. Stores the predicted sentiment
      * 5. Writes predictions to the output file in format: <sentiment>,<tweetID>
      * 
-     * @param testDataFile Path to the test CSV file
+     * With several test files, predictions are written in the order the
+     * parser threads finish their batches.
+     * 
+     * @param testData Test CSV file, directory, glob pattern or @manifest
      * @param predictionsOutputFile Path where prediction results will be written
      * @return True if prediction was successful, false otherwise
      */
-    bool predict(const DSString& testDataFile, const DSString& predictionsOutputFile);
+    bool predict(const DSString& testData, const DSString& predictionsOutputFile);
     
     /**
      * Evaluates prediction accuracy against ground truth
@@ -124,11 +634,12 @@ public:
      * - First line: accuracy to 3 decimal places
      * - Remaining lines: <predicted>,<actual>,<tweetID> for misclassified tweets
      * 
-     * @param groundTruthFile Path to the file with actual sentiments
+     * @param groundTruth File(s) with actual sentiments: a file, directory,
+     *                    glob pattern or @manifest
      * @param accuracyOutputFile Path where accuracy results will be written
      * @return True if evaluation was successful, false otherwise
      */
-    bool evaluatePredictions(const DSString& groundTruthFile, const DSString& accuracyOutputFile);
+    bool evaluatePredictions(const DSString& groundTruth, const DSString& accuracyOutputFile);
 };
 
 #endif // SENTIMENTCLASSIFIER_H
@@ -0,0 +1,104 @@
+/**
+ * SubwordFeatures.h
+ *
+ * fastText-style hashed character n-gram features.
+ * Every token is wrapped in boundary markers ("<good>") and its character
+ * n-grams (3 to 5 bytes by default) are hashed into a fixed-size bucket array
+ * of positive/negative counts. Words that never appeared in training still
+ * share n-grams with known words ("goooood" with "good", "luv" with "love"),
+ * so they can contribute to the sentiment score.
+ *
+ * Hashes are computed with a rolling polynomial hash directly over the token
+ * bytes: no substring is ever allocated.
+ */
+
+#ifndef SUBWORDFEATURES_H
+#define SUBWORDFEATURES_H
+
+#include "DSStringView.h"
+#include <vector>
+#include <utility> // for std::pair
+
+/**
+ * SubwordFeatures class - Hashed character n-gram counts
+ */
+class SubwordFeatures {
+public:
+    /**
+     * Constructor
+     * No memory is allocated until the first token is added.
+     *
+     * @param bucketBits log2 of the number of buckets
+     * @param minN Shortest n-gram length
+     * @param maxN Longest n-gram length
+     */
+    SubwordFeatures(int bucketBits = 20, int minN = 3, int maxN = 5);
+
+    /**
+     * Adds the n-grams of a training token to the bucket counts
+     *
+     * @param token Token from a training tweet
+     * @param positive True if the tweet is positive, false if negative
+     */
+    void addToken(const DSStringView& token, bool positive);
+
+    /**
+     * Scores a token from its n-grams alone
+     * Each n-gram contributes its (positive - negative) bucket count and the
+     * result is averaged over the token's n-grams, so long words do not
+     * outweigh short ones.
+     *
+     * @param token Token to score
+     * @return Average n-gram score, 0 if nothing has been trained or the
+     *         token is longer than MAX_TOKEN_LENGTH
+     */
+    int scoreToken(const DSStringView& token) const;
+
+    /**
+     * Tokens longer than this (URLs, keyboard mashing) have no n-gram features
+     */
+    static const int MAX_TOKEN_LENGTH = 64;
+
+    /**
+     * Configuration accessors, for saving the features to a model file
+     */
+    unsigned int getBucketBits() const { return bucketBits; }
+    int getMinN() const { return minN; }
+    int getMaxN() const { return maxN; }
+
+    /**
+     * (positive, negative) count per bucket; empty until a token is added
+     */
+    const std::vector<std::pair<int, int>>& getCounts() const { return counts; }
+
+    /**
+     * Replaces the bucket counts, e.g. with counts loaded from a model file
+     * The vectors are swapped, so no copy of the table is made.
+     *
+     * @param newCounts One (positive, negative) pair per bucket; receives the old counts
+     * @return false (counts unchanged) if newCounts has the wrong size
+     */
+    bool setCounts(std::vector<std::pair<int, int>>& newCounts);
+
+private:
+    /**
+     * Most n-grams hashed for a single token
+     */
+    static const int MAX_NGRAMS = 256;
+
+    /**
+     * Computes the bucket index of every n-gram of the token
+     *
+     * @param token Token to hash
+     * @param buckets Output array with room for MAX_NGRAMS entries
+     * @return Number of bucket indices written
+     */
+    int hashNgrams(const DSStringView& token, unsigned int* buckets) const;
+
+    std::vector<std::pair<int, int>> counts;   // (positive, negative) per bucket
+    unsigned int bucketBits;
+    int minN;
+    int maxN;
+};
+
+#endif // SUBWORDFEATURES_H
@@ -0,0 +1,176 @@
+/**
+ * Task.h
+ *
+ * Minimal C++20 coroutine task. A function returning Task<T> is a
+ * coroutine that starts when the task is first awaited (co_await task)
+ * and hands its co_return value to the awaiting coroutine, which it
+ * resumes directly when it finishes (symmetric transfer, so chains of
+ * tasks do not grow the stack). An exception escaping the coroutine is
+ * rethrown to the awaiter.
+ *
+ * Tasks are move-only and own their coroutine: destroying a task that has
+ * not run (or has finished) frees it. Top-level tasks are started by an
+ * executor (see AsyncScorer.h).
+ *
+ * Requires C++20 (-std=c++20).
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#if !defined(__cpp_impl_coroutine)
+#error "Task.h needs C++20 coroutines (-std=c++20)"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <typename T>
+class Task;
+
+/**
+ * Promise parts shared by every result type
+ */
+class TaskPromiseBase {
+public:
+    /**
+     * Resumes the awaiting coroutine, if any, when the task finishes
+     */
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept {
+            std::coroutine_handle<> continuation = finished.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;   // Coroutine awaiting the task
+    std::exception_ptr error;
+};
+
+/**
+ * Task class - Lazily started coroutine producing a T
+ */
+template <typename T>
+class Task {
+public:
+    struct promise_type : TaskPromiseBase {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_value(T result) { value.emplace(std::move(result)); }
+
+        std::optional<T> value;
+    };
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    /**
+     * Starts the task and suspends the awaiter until it has finished
+     */
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> task;
+
+            bool await_ready() const noexcept { return task.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                task.promise().continuation = awaiting;
+                return task;
+            }
+            T await_resume() {
+                if (task.promise().error) {
+                    std::rethrow_exception(task.promise().error);
+                }
+                return std::move(*task.promise().value);
+            }
+        };
+        return Awaiter{handle};
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+/**
+ * Task<void> - Lazily started coroutine without a result
+ */
+template <>
+class Task<void> {
+public:
+    struct promise_type : TaskPromiseBase {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_void() const noexcept {}
+    };
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    /**
+     * Starts the task and suspends the awaiter until it has finished
+     */
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> task;
+
+            bool await_ready() const noexcept { return task.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                task.promise().continuation = awaiting;
+                return task;
+            }
+            void await_resume() {
+                if (task.promise().error) {
+                    std::rethrow_exception(task.promise().error);
+                }
+            }
+        };
+        return Awaiter{handle};
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : handle(coroutine) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+#endif // TASK_H
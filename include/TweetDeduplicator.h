@@ -0,0 +1,149 @@
+/**
+ * TweetDeduplicator.h
+ *
+ * Detects repeated tweets (retweets, copy-paste spam) in the training stream
+ * so they are counted only once.
+ *
+ * Tweets are fingerprinted from their token sequence, which is already
+ * lowercased and stripped of punctuation and spacing, so trivially different
+ * copies of the same text produce the same 64-bit fingerprint. Three modes:
+ * - exact:   fingerprints kept in a lock-free open-addressing set
+ * - bloom:   fingerprints kept in a fixed-size blocked Bloom filter
+ *            (bounded memory; a false positive drops a unique tweet)
+ * - minhash: near-duplicates found with MinHash signatures and LSH banding
+ *
+ * isDuplicate() is thread-safe and lock-free in every mode, so concurrent
+ * training workers can share one deduplicator. The hashing is split from
+ * the insert: computeKeys() only reads the tokens, so parser threads can
+ * compute every tweet's fingerprint or MinHash band keys, leaving a
+ * single set insert per key to whichever thread decides the order.
+ */
+
+#ifndef TWEETDEDUPLICATOR_H
+#define TWEETDEDUPLICATOR_H
+
+#include "DSString.h"
+#include "FingerprintSet.h"
+#include "BloomFilter.h"
+#include <atomic>
+#include <vector>
+
+/**
+ * Deduplication strategies
+ */
+enum DedupeMode {
+    DEDUPE_OFF,
+    DEDUPE_EXACT,
+    DEDUPE_BLOOM,
+    DEDUPE_MINHASH
+};
+
+/**
+ * TweetDeduplicator class - Remembers which tweets have been seen
+ */
+class TweetDeduplicator {
+public:
+    /**
+     * Memory used by the Bloom filter in bounded-memory mode
+     */
+    static const size_t BLOOM_MEMORY_BYTES = 4 * 1024 * 1024;
+
+    /**
+     * MinHash signature size and LSH banding (BANDS x ROWS = NUM_MINHASHES).
+     * Signatures are taken over word bigrams; 4 bands of 8 rows flag pairs
+     * whose bigram sets have Jaccard similarity above ~0.85.
+     */
+    static const int NUM_MINHASHES = 32;
+    static const int LSH_BANDS = 4;
+    static const int LSH_ROWS = 8;
+
+    /**
+     * Set keys of one tweet: its fingerprint, or its LSH band keys
+     */
+    struct Keys {
+        uint64_t values[LSH_BANDS];
+        int count;                  // 0 = nothing to check (empty tweet or mode off)
+
+        Keys() : count(0) {}
+    };
+
+    /**
+     * Default constructor - deduplication off
+     */
+    TweetDeduplicator();
+
+    /**
+     * Selects the mode and sizes the underlying structures. Not thread-safe.
+     * @param mode Deduplication strategy
+     * @param expectedTweets Upper bound on the number of tweets to be checked
+     */
+    void configure(DedupeMode mode, size_t expectedTweets);
+
+    /**
+     * Computes the set keys of a tweet without recording it
+     * Thread-safe; touches no shared state.
+     * @param tokens Tokens of the tweet
+     * @param keys Receives the fingerprint or band keys
+     */
+    void computeKeys(const std::vector<DSString>& tokens, Keys& keys) const;
+
+    /**
+     * Records a tweet and reports whether it was seen before
+     * Thread-safe.
+     * @param tokens Tokens of the tweet
+     * @return true if the tweet duplicates (or, in minhash mode, nearly
+     *         duplicates) an earlier one
+     */
+    bool isDuplicate(const std::vector<DSString>& tokens);
+
+    /**
+     * Records a tweet by keys from computeKeys()
+     * Thread-safe.
+     * @param keys Keys of the tweet
+     * @return true if the tweet duplicates (or nearly duplicates) an earlier one
+     */
+    bool isDuplicate(const Keys& keys);
+
+    /**
+     * Prints the number of tweets checked and skipped, and memory used
+     */
+    void printStats() const;
+
+    /**
+     * Returns the active mode
+     */
+    DedupeMode getMode() const { return mode; }
+
+    /**
+     * Parses a mode name ("exact", "bloom", "minhash", "off")
+     * @param name Mode name from the command line
+     * @param mode Set to the parsed mode on success
+     * @return true if the name was recognized
+     */
+    static bool parseMode(const char* name, DedupeMode& mode);
+
+    /**
+     * Returns the name of a mode
+     */
+    static const char* modeName(DedupeMode mode);
+
+private:
+    /**
+     * 64-bit fingerprint of a token sequence
+     */
+    uint64_t fingerprint(const std::vector<DSString>& tokens) const;
+
+    /**
+     * LSH band keys of the tweet's MinHash signature
+     * @param bands Receives LSH_BANDS keys
+     */
+    void minHashBands(const std::vector<DSString>& tokens, uint64_t* bands) const;
+
+    DedupeMode mode;
+    FingerprintSet seen;            // exact fingerprints or LSH band keys
+    BlockedBloomFilter bloom;       // bounded-memory fingerprints
+    std::atomic<long long> checked;
+    std::atomic<long long> duplicates;
+};
+
+#endif // TWEETDEDUPLICATOR_H
@@ -0,0 +1,105 @@
+/**
+ * Utf8.h
+ *
+ * Minimal UTF-8 helpers used by DSString and the tokenizer.
+ * Tweets are overwhelmingly ASCII, so every helper here is built around an
+ * ASCII fast path that classifies 16 bytes at a time (SSE2 when available)
+ * and only falls back to decoding code points for non-ASCII runs.
+ *
+ * No Unicode library is used: case folding covers the common alphabetic
+ * blocks whose lowercase form has the same encoded length (Latin-1,
+ * Latin Extended-A, Greek, Cyrillic), delimiter detection covers the
+ * Unicode spaces and punctuation that show up in tweets, and emoji are
+ * recognized from a small table of code point ranges.
+ */
+
+#ifndef UTF8_H
+#define UTF8_H
+
+/**
+ * Number of bytes examined per call by the block helpers below
+ */
+const int UTF8_BLOCK_SIZE = 16;
+
+/**
+ * Decodes one UTF-8 encoded character
+ * Malformed or truncated sequences decode as a single byte with code point -1.
+ *
+ * @param str Pointer to the first byte of the character
+ * @param remaining Number of bytes available starting at str (must be > 0)
+ * @param codePoint Set to the decoded code point, or -1 if malformed
+ * @return Number of bytes consumed (1 to 4)
+ */
+int utf8Decode(const char* str, int remaining, int& codePoint);
+
+/**
+ * Encodes a code point as UTF-8
+ * @param codePoint Code point to encode (0 to 0x10FFFF)
+ * @param out Output buffer with room for 4 bytes
+ * @return Number of bytes written
+ */
+int utf8Encode(int codePoint, char* out);
+
+/**
+ * Returns the lowercase form of a code point
+ * Only mappings that keep the UTF-8 encoded length unchanged are applied,
+ * so lowercasing never changes the byte length of a string.
+ *
+ * @param codePoint Code point to convert
+ * @return Lowercase code point, or codePoint itself if it has no such mapping
+ */
+int utf8ToLower(int codePoint);
+
+/**
+ * Returns true if the code point separates words
+ * ASCII spaces and punctuation plus Unicode spaces, quotes and punctuation.
+ *
+ * @param codePoint Code point to test (-1 for malformed bytes, never a delimiter)
+ */
+bool isWordDelimiter(int codePoint);
+
+/**
+ * Returns true if the code point is an emoji or pictographic symbol
+ * Looked up by binary search in a compact table of code point ranges.
+ *
+ * @param codePoint Code point to test
+ */
+bool isEmoji(int codePoint);
+
+/**
+ * Returns true if the code point only modifies a neighbouring emoji
+ * (variation selectors, skin tone modifiers, zero width joiner)
+ *
+ * @param codePoint Code point to test
+ */
+bool isEmojiComponent(int codePoint);
+
+/**
+ * Lowercases one block of UTF8_BLOCK_SIZE bytes if they are all ASCII
+ *
+ * @param src Source bytes (at least UTF8_BLOCK_SIZE readable)
+ * @param dest Destination (at least UTF8_BLOCK_SIZE writable)
+ * @return true if the block was pure ASCII and has been written to dest;
+ *         false (dest untouched) if it contains a byte >= 0x80
+ */
+bool lowerAsciiBlock(const char* src, char* dest);
+
+/**
+ * Returns true if the code point ends a clause (and therefore a negation scope)
+ * Sentence and clause punctuation: , . ! ? ; : and their Unicode equivalents.
+ *
+ * @param codePoint Code point to test
+ */
+bool isClauseBoundary(int codePoint);
+
+/**
+ * Classifies one block of UTF8_BLOCK_SIZE bytes if they are all ASCII
+ *
+ * @param src Source bytes (at least UTF8_BLOCK_SIZE readable)
+ * @param delimiterMask Set to a bit mask with bit i set if src[i] is a delimiter
+ * @param clauseMask Set to a bit mask with bit i set if src[i] ends a clause
+ * @return true if the block was pure ASCII; false (masks untouched) otherwise
+ */
+bool classifyAsciiBlock(const char* src, unsigned int& delimiterMask, unsigned int& clauseMask);
+
+#endif // UTF8_H
@@ -0,0 +1,208 @@
+/**
+ * AsyncBench.cpp
+ *
+ * Benchmark of the coroutine scoring interface (AsyncScorer.h) against
+ * synchronous scoring. Scores the same tweets with scoreText() on the
+ * calling thread, and then on a single-threaded executor: awaiting one
+ * text at a time, with many coroutines waiting at once, and in batches
+ * of 64 per await. Prints the time per tweet of each, its difference from
+ * the synchronous path, and the cost of awaiting a task that completes
+ * without suspending.
+ *
+ * Usage: ./asyncbench <model_file> <tweets.csv> [freeze_bits] [threads] [--stem] [--negation] [--ngrams]
+ * (defaults: int16 frozen model, 0 = full counts; one scoring thread)
+ */
+
+#include "../include/AsyncScorer.h"
+#include "../include/SentimentClassifier.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Passes over the tweets per measurement
+static const int PASSES = 5;
+
+// Coroutines waiting at once in the concurrent measurement
+static const int CONCURRENT_TASKS = 256;
+
+// Texts per await in the batched measurement
+static const size_t BATCH_SIZE = 64;
+
+// Helper function: the tweet column of every data row (text after the fourth comma)
+std::vector<DSString> readTweets(const char* path) {
+    std::ifstream file(path);
+    std::vector<DSString> tweets;
+    std::string line;
+    std::getline(file, line);   // Header
+    while (std::getline(file, line)) {
+        size_t position = 0;
+        for (int comma = 0; comma < 4 && position != std::string::npos; comma++) {
+            position = line.find(',', position);
+            if (position != std::string::npos) {
+                position++;
+            }
+        }
+        if (position == std::string::npos) {
+            continue;
+        }
+        std::string text = line.substr(position);
+        if (!text.empty() && text.back() == '\r') {
+            text.pop_back();
+        }
+        tweets.push_back(DSString(text.c_str()));
+    }
+    return tweets;
+}
+
+// Helper coroutines: a task that finishes at once, and the measured loops
+Task<int> immediate(int value) {
+    co_return value;
+}
+
+Task<void> awaitImmediate(long long count, long long* sum) {
+    for (long long i = 0; i < count; i++) {
+        *sum += co_await immediate(static_cast<int>(i));
+    }
+}
+
+Task<void> scoreSequence(AsyncScorer* scorer, const std::vector<DSStringView>* views, size_t first, size_t step,
+                         double* sum) {
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (size_t i = first; i < views->size(); i += step) {
+            *sum += co_await scorer->scoreAsync((*views)[i]);
+        }
+    }
+}
+
+Task<void> scoreBatches(AsyncScorer* scorer, const std::vector<DSStringView>* views, double* sum) {
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (size_t i = 0; i < views->size(); i += BATCH_SIZE) {
+            size_t count = std::min(BATCH_SIZE, views->size() - i);
+            std::vector<float> scores = co_await scorer->scoreBatchAsync(views->data() + i, count);
+            for (float score : scores) {
+                *sum += score;
+            }
+        }
+    }
+}
+
+// Helper function: prints one result line
+void report(const char* name, double seconds, double tweets, double syncNanos) {
+    double nanos = seconds * 1e9 / tweets;
+    std::cout << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(10) << nanos << " ns" << std::setw(10) << (nanos - syncNanos) << " ns" << std::setw(12)
+              << (tweets / seconds) << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: ./asyncbench <model_file> <tweets.csv> [freeze_bits] [threads] "
+                  << "[--stem] [--negation] [--ngrams]" << std::endl;
+        return 1;
+    }
+    int freezeBits = 16;
+    int threads = 1;
+    SentimentClassifier classifier;
+    int position = 0;
+    for (int i = 3; i < argc; i++) {
+        if (std::strcmp(argv[i], "--stem") == 0) {
+            classifier.setStemmingEnabled(true);
+        } else if (std::strcmp(argv[i], "--negation") == 0) {
+            classifier.setNegationEnabled(true);
+        } else if (std::strcmp(argv[i], "--ngrams") == 0) {
+            classifier.setSubwordFeaturesEnabled(true);
+        } else if (position++ == 0) {
+            freezeBits = std::atoi(argv[i]);
+        } else {
+            threads = std::atoi(argv[i]);
+        }
+    }
+    classifier.setNumThreads(threads);
+    if (!classifier.loadModel(DSString(argv[1]))) {
+        return 1;
+    }
+    if (freezeBits > 0) {
+        FreezeOptions options;
+        options.weightBits = freezeBits;
+        if (!classifier.freezeModel(options)) {
+            return 1;
+        }
+    }
+    std::vector<DSString> tweets = readTweets(argv[2]);
+    if (tweets.empty()) {
+        std::cerr << "Error: No tweets in " << argv[2] << std::endl;
+        return 1;
+    }
+    std::vector<DSStringView> views(tweets.begin(), tweets.end());
+    double total = static_cast<double>(tweets.size()) * PASSES;
+
+    std::cout << "\n" << tweets.size() << " tweets x " << PASSES << " passes, " << classifier.getNumThreads()
+              << " scoring threads" << std::endl;
+    std::cout << std::left << std::setw(34) << "path" << std::right << std::setw(13) << "per tweet" << std::setw(13)
+              << "vs sync" << std::setw(12) << "tweets/s" << std::endl;
+
+    // Synchronous scoring on the calling thread
+    double sum = 0.0;
+    auto start = Clock::now();
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (const DSString& tweet : tweets) {
+            sum += classifier.scoreText(tweet, 0);
+        }
+    }
+    double syncSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double syncNanos = syncSeconds * 1e9 / total;
+    report("scoreText", syncSeconds, total, syncNanos);
+
+    // The coroutine machinery alone: awaiting a task that does not suspend
+    {
+        SingleThreadExecutor executor;
+        long long count = 10000000;
+        long long awaited = 0;
+        start = Clock::now();
+        executor.spawn(awaitImmediate(count, &awaited));
+        executor.run();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "Task await without suspension: " << std::setprecision(1) << seconds * 1e9 / count
+                  << " ns (checksum " << awaited << ")" << std::endl;
+    }
+
+    SingleThreadExecutor executor;
+    AsyncScorer scorer(classifier, executor);
+    double asyncSum = 0.0;
+
+    // One await at a time: every tweet pays the hand-off to a scoring thread and back
+    start = Clock::now();
+    executor.spawn(scoreSequence(&scorer, &views, 0, 1, &asyncSum));
+    executor.run();
+    report("scoreAsync, one at a time", std::chrono::duration<double>(Clock::now() - start).count(), total,
+           syncNanos);
+
+    // Many coroutines waiting at once: hand-offs are shared by micro-batches
+    start = Clock::now();
+    for (int t = 0; t < CONCURRENT_TASKS; t++) {
+        executor.spawn(scoreSequence(&scorer, &views, t, CONCURRENT_TASKS, &asyncSum));
+    }
+    executor.run();
+    report("scoreAsync, 256 coroutines", std::chrono::duration<double>(Clock::now() - start).count(), total,
+           syncNanos);
+
+    // One await per batch of texts
+    start = Clock::now();
+    executor.spawn(scoreBatches(&scorer, &views, &asyncSum));
+    executor.run();
+    report("scoreBatchAsync, 64 per await", std::chrono::duration<double>(Clock::now() - start).count(), total,
+           syncNanos);
+
+    if (asyncSum != 3.0 * sum) {
+        std::cerr << "Error: Asynchronous scores differ from synchronous ones" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,459 @@
+/**
+ * AsyncFileReader.cpp
+ *
+ * Implementation of the queued block reader declared in AsyncFileReader.h.
+ *
+ * The io_uring backend talks to the kernel directly: io_uring_setup creates
+ * the submission and completion rings, both are mapped into the process,
+ * and io_uring_enter submits reads and waits for completions. Ring indices
+ * are shared with the kernel, so they are read with acquire and written with
+ * release semantics.
+ */
+
+#include "../include/AsyncFileReader.h"
+#include <cerrno>
+#include <cstring>      // For memset
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define SENTIMENT_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+// Constructor
+AsyncFileReader::AsyncFileReader(int queueDepth, size_t blockSize)
+    : queueDepth(queueDepth < 1 ? 1 : queueDepth), blockSize(blockSize == 0 ? DEFAULT_BLOCK_SIZE : blockSize),
+      backend(ASYNC_PREAD_POOL), fd(-1),
+      ringFd(-1), sqRing(nullptr), cqRing(nullptr), sqes(nullptr),
+      sqRingBytes(0), cqRingBytes(0), sqesBytes(0),
+      sqHead(nullptr), sqTail(nullptr), sqMask(nullptr), sqArray(nullptr),
+      cqHead(nullptr), cqTail(nullptr), cqMask(nullptr), cqes(nullptr), inFlight(0), draining(false),
+      poolStopping(false) {
+}
+
+// Destructor
+AsyncFileReader::~AsyncFileReader() {
+    stopPool();
+    teardownUring();
+}
+
+// Name of a backend
+const char* AsyncFileReader::backendName(AsyncBackend backend) {
+    return backend == ASYNC_IO_URING ? "io_uring" : "pread";
+}
+
+// Reads bytes [begin, end) of a file into the ring, one block per buffer, in order
+bool AsyncFileReader::run(int fd, size_t begin, size_t end, BufferRing& ring) {
+    this->fd = fd;
+    pending.assign(queueDepth, Pending());
+
+    // Prefer io_uring; fall back to the thread pool if the kernel refuses it
+    if (setupUring(static_cast<unsigned int>(queueDepth))) {
+        backend = ASYNC_IO_URING;
+    } else {
+        backend = ASYNC_PREAD_POOL;
+        startPool(fd);
+    }
+
+    size_t rangeBytes = (end > begin) ? end - begin : 0;
+    unsigned long long numBlocks = (rangeBytes + blockSize - 1) / blockSize;
+    unsigned long long nextSubmit = 0;
+    unsigned long long nextPublish = 0;
+    bool ok = true;
+    bool cancelled = false;
+
+    // Keep queueDepth reads in flight; publish strictly in file order.
+    // After an error or cancellation, keep waiting until nothing is in flight
+    // so no read can still be writing into a buffer when we return.
+    while (nextPublish < nextSubmit || (ok && !cancelled && nextPublish < numBlocks)) {
+        while (ok && !cancelled && nextSubmit < numBlocks &&
+               nextSubmit - nextPublish < static_cast<unsigned long long>(queueDepth)) {
+            RingBuffer* buffer = ring.acquireEmpty();
+            if (buffer == nullptr) {
+                cancelled = true;
+                break;
+            }
+
+            unsigned long long slot = nextSubmit % queueDepth;
+            Pending& read = pending[slot];
+            read.buffer = buffer;
+            read.offset = begin + nextSubmit * blockSize;
+            read.length = (end - read.offset < blockSize) ? end - read.offset : blockSize;
+            read.done = 0;
+            read.complete = false;
+            read.failed = false;
+            if (!submit(slot)) {
+                ring.releaseEmpty(buffer);
+                read.buffer = nullptr; // Never submitted: nothing to cancel
+                ok = false;
+                break;
+            }
+            nextSubmit++;
+        }
+
+        if (nextPublish == nextSubmit) {
+            break;
+        }
+
+        unsigned long long slot = nextPublish % queueDepth;
+        if (!waitFor(slot)) {
+            // Waiting itself failed: cancel the reads in flight and wait until
+            // the kernel is done with their buffers before handing them back
+            ok = false;
+            drainUring();
+            for (; nextPublish < nextSubmit; nextPublish++) {
+                ring.releaseEmpty(pending[nextPublish % queueDepth].buffer);
+            }
+            break;
+        }
+        Pending& read = pending[slot];
+        if (read.failed) {
+            ok = false;
+        }
+        if (ok && !cancelled) {
+            read.buffer->size = read.done;
+            ring.publishFull(read.buffer);
+        } else {
+            ring.releaseEmpty(read.buffer);
+        }
+        nextPublish++;
+    }
+
+    stopPool();
+    teardownUring();
+    return ok;
+}
+
+// Submits (or resubmits the unread remainder of) one block read
+bool AsyncFileReader::submit(unsigned long long slot) {
+    if (backend == ASYNC_IO_URING) {
+        return submitUring(slot);
+    }
+    submitPool(slot);
+    return true;
+}
+
+// Waits until the read in the given slot has completed
+bool AsyncFileReader::waitFor(unsigned long long slot) {
+    if (backend == ASYNC_IO_URING) {
+        while (!pending[slot].complete) {
+            if (!reapUring(true)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    std::unique_lock<std::mutex> guard(poolLock);
+    completionReady.wait(guard, [this, slot] { return pending[slot].complete; });
+    return true;
+}
+
+//=== io_uring backend ===//
+
+#if defined(SENTIMENT_HAVE_IO_URING)
+
+// Marks the completions of cancel requests, which belong to no slot
+static const unsigned long long CANCEL_TAG = 1ull << 63;
+
+// Creates the rings and maps them into the process
+bool AsyncFileReader::setupUring(unsigned int entries) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    long result = syscall(__NR_io_uring_setup, entries, &params);
+    if (result < 0) {
+        return false; // ENOSYS, EPERM (seccomp, sysctl) ...
+    }
+    ringFd = static_cast<int>(result);
+
+    sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        if (cqRingBytes > sqRingBytes) {
+            sqRingBytes = cqRingBytes;
+        }
+        cqRingBytes = sqRingBytes;
+    }
+
+    sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        teardownUring();
+        return false;
+    }
+    if (singleMap) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            teardownUring();
+            return false;
+        }
+    }
+    sqesBytes = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        sqes = nullptr;
+        teardownUring();
+        return false;
+    }
+
+    char* sq = static_cast<char*>(sqRing);
+    char* cq = static_cast<char*>(cqRing);
+    sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+    cqes = cq + params.cq_off.cqes;
+    inFlight = 0;
+    draining = false;
+    return true;
+}
+
+// Unmaps the rings and closes the io_uring instance
+void AsyncFileReader::teardownUring() {
+    if (sqes != nullptr) {
+        munmap(sqes, sqesBytes);
+        sqes = nullptr;
+    }
+    if (cqRing != nullptr && cqRing != sqRing) {
+        munmap(cqRing, cqRingBytes);
+    }
+    cqRing = nullptr;
+    if (sqRing != nullptr) {
+        munmap(sqRing, sqRingBytes);
+        sqRing = nullptr;
+    }
+    if (ringFd >= 0) {
+        close(ringFd);
+        ringFd = -1;
+    }
+}
+
+// Queues one READV for the unread part of a slot and submits it
+bool AsyncFileReader::submitUring(unsigned long long slot) {
+    Pending& read = pending[slot];
+    read.vector.iov_base = read.buffer->data.get() + read.done;
+    read.vector.iov_len = read.length - read.done;
+
+    unsigned int tail = *sqTail; // Only this thread writes the tail
+    unsigned int index = tail & *sqMask;
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->off = read.offset + read.done;
+    sqe->addr = reinterpret_cast<unsigned long long>(&read.vector);
+    sqe->len = 1;
+    sqe->user_data = slot;
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    long result;
+    do {
+        result = syscall(__NR_io_uring_enter, ringFd, 1, 0, 0, nullptr, 0);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0) {
+        // The kernel consumed nothing: take the entry back, so a later
+        // enter cannot start a read into a buffer the caller releases
+        __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+        return false;
+    }
+    inFlight++;
+    return true;
+}
+
+// Processes completed reads, optionally blocking until at least one arrives
+bool AsyncFileReader::reapUring(bool wait) {
+    if (wait) {
+        long result = syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (result < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+
+    unsigned int head = *cqHead;
+    unsigned int tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const struct io_uring_cqe* cqe = static_cast<const struct io_uring_cqe*>(cqes) + (head & *cqMask);
+        head++;
+        if (cqe->user_data & CANCEL_TAG) {
+            continue;
+        }
+        Pending& read = pending[cqe->user_data];
+        int result = cqe->res;
+        inFlight--;
+
+        if (result < 0 && result != -EAGAIN && result != -EINTR) {
+            read.failed = true;
+            read.complete = true;
+        } else {
+            read.done += (result > 0) ? static_cast<size_t>(result) : 0;
+            // A zero-byte read means the file shrank; keep what was read
+            if (read.done >= read.length || result == 0 || draining) {
+                read.complete = true;
+            } else if (!submitUring(cqe->user_data)) {
+                read.failed = true;
+                read.complete = true;
+            }
+        }
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Cancels the reads in flight and reaps until none is left
+void AsyncFileReader::drainUring() {
+    draining = true;
+
+    // One ASYNC_CANCEL per submitted, unfinished slot (the submission ring
+    // has been consumed, so there is room for all of them)
+    unsigned int tail = *sqTail;
+    unsigned int queued = 0;
+    for (size_t slot = 0; slot < pending.size(); slot++) {
+        if (pending[slot].buffer == nullptr || pending[slot].complete) {
+            continue;
+        }
+        unsigned int index = (tail + queued) & *sqMask;
+        struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes) + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = slot;
+        sqe->user_data = slot | CANCEL_TAG;
+        sqArray[index] = index;
+        queued++;
+    }
+    if (queued > 0) {
+        __atomic_store_n(sqTail, tail + queued, __ATOMIC_RELEASE);
+        long result;
+        do {
+            result = syscall(__NR_io_uring_enter, ringFd, queued, 0, 0, nullptr, 0);
+        } while (result < 0 && errno == EINTR);
+        // If submitting fails, the reads still complete on their own
+        if (result < 0) {
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+        }
+    }
+
+    // Every read ends (cancelled or not) with a completion; if waiting for
+    // one is refused, poll the completion ring, which the kernel fills anyway
+    while (inFlight > 0) {
+        if (!reapUring(true)) {
+            usleep(1000);
+            reapUring(false);
+        }
+    }
+    draining = false;
+}
+
+#else
+
+bool AsyncFileReader::setupUring(unsigned int) {
+    return false;
+}
+
+void AsyncFileReader::teardownUring() {
+}
+
+bool AsyncFileReader::submitUring(unsigned long long) {
+    return false;
+}
+
+bool AsyncFileReader::reapUring(bool) {
+    return false;
+}
+
+void AsyncFileReader::drainUring() {
+}
+
+#endif
+
+//=== pread pool backend ===//
+
+// Starts one worker per queue slot
+void AsyncFileReader::startPool(int fd) {
+    poolStopping = false;
+    requests.clear();
+    for (int i = 0; i < queueDepth; i++) {
+        workers.emplace_back(&AsyncFileReader::poolWorker, this, fd);
+    }
+}
+
+// Stops and joins the workers (reads already started finish first)
+void AsyncFileReader::stopPool() {
+    if (workers.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(poolLock);
+        poolStopping = true;
+    }
+    requestReady.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+// Hands a slot to the workers
+void AsyncFileReader::submitPool(unsigned long long slot) {
+    {
+        std::lock_guard<std::mutex> guard(poolLock);
+        requests.push_back(slot);
+    }
+    requestReady.notify_one();
+}
+
+// Worker loop: blocking pread() of whole blocks
+void AsyncFileReader::poolWorker(int fd) {
+    while (true) {
+        unsigned long long slot;
+        Pending read;
+        {
+            std::unique_lock<std::mutex> guard(poolLock);
+            requestReady.wait(guard, [this] { return poolStopping || !requests.empty(); });
+            if (requests.empty()) {
+                return;
+            }
+            slot = requests.front();
+            requests.pop_front();
+            read = pending[slot];
+        }
+
+        bool failed = false;
+        while (read.done < read.length) {
+            ssize_t n = pread(fd, read.buffer->data.get() + read.done, read.length - read.done,
+                              static_cast<off_t>(read.offset + read.done));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                failed = true;
+                break;
+            }
+            if (n == 0) {
+                break; // The file shrank; keep what was read
+            }
+            read.done += static_cast<size_t>(n);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(poolLock);
+            pending[slot].done = read.done;
+            pending[slot].failed = failed;
+            pending[slot].complete = true;
+        }
+        completionReady.notify_all();
+    }
+}
@@ -0,0 +1,163 @@
+/**
+ * AsyncScorer.cpp
+ *
+ * Implementation of the coroutine scoring interface declared in
+ * AsyncScorer.h. Needs C++20; in a C++17 build of the tree this file
+ * compiles to nothing.
+ */
+
+#if defined(__cpp_impl_coroutine)
+
+#include "../include/AsyncScorer.h"
+#include <limits>
+
+/**
+ * Coroutine started by the executor for a spawned task; it frees itself
+ * when it finishes
+ */
+struct SingleThreadExecutor::Spawned {
+    struct promise_type {
+        Spawned get_return_object() { return Spawned{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> coroutine;
+};
+
+// Schedules a suspended coroutine to be resumed on the executor
+void SingleThreadExecutor::post(std::coroutine_handle<> coroutine) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ready.push_back(coroutine);
+    }
+    posted.notify_one();
+}
+
+// Awaits a spawned task and then counts it as finished
+SingleThreadExecutor::Spawned SingleThreadExecutor::runSpawned(Task<void> task, SingleThreadExecutor* executor) {
+    co_await std::move(task);
+    executor->running--;
+}
+
+// Starts a task on this executor when run() is called
+void SingleThreadExecutor::spawn(Task<void> task) {
+    running++;
+    post(runSpawned(std::move(task), this).coroutine);
+}
+
+// Resumes posted coroutines until every spawned task has finished
+void SingleThreadExecutor::run() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (running > 0) {
+        if (ready.empty()) {
+            posted.wait(guard);
+            continue;
+        }
+        std::coroutine_handle<> coroutine = ready.front();
+        ready.pop_front();
+        guard.unlock();
+        coroutine.resume();
+        guard.lock();
+    }
+}
+
+// Constructor - starts one scoring thread per worker slot
+AsyncScorer::AsyncScorer(SentimentClassifier& model, Executor& resumer, size_t maxBatch, int maxDelayMicros,
+                         int latencyTargetMicros, size_t queueLimit)
+    : classifier(model), executor(resumer),
+      batcher(maxBatch, maxDelayMicros, latencyTargetMicros, queueLimit, queueLimit) {
+    for (int slot = 0; slot < classifier.getNumThreads(); slot++) {
+        scorers.push_back(std::thread(&AsyncScorer::scoreLoop, this, slot));
+    }
+}
+
+// Destructor - scores what is queued, then stops the scoring threads
+AsyncScorer::~AsyncScorer() {
+    batcher.stop();
+    for (std::thread& scorer : scorers) {
+        scorer.join();
+    }
+}
+
+// Scores batches from the batcher until it is stopped
+void AsyncScorer::scoreLoop(int slot) {
+    std::vector<ScoreRequest*> batch;
+    std::vector<const DSString*> texts;
+    std::vector<int> scores;
+    while (batcher.takeBatch(batch)) {
+        texts.clear();
+        for (const ScoreRequest* request : batch) {
+            texts.push_back(&request->text);
+        }
+        scores.resize(batch.size());
+        classifier.scoreTexts(texts.data(), texts.size(), scores.data(), slot);
+        for (size_t i = 0; i < batch.size(); i++) {
+            batch[i]->score = scores[i];
+        }
+        batcher.complete(batch);
+    }
+}
+
+// Queues the requests; the coroutine is resumed through resume() once all are scored
+bool AsyncScorer::Submission::await_suspend(std::coroutine_handle<> coroutine) {
+    awaiting = coroutine;
+    group.remaining = count;
+    group.onComplete = &Submission::resume;
+    group.context = this;
+    for (size_t i = 0; i < count; i++) {
+        requests[i]->group = &group;
+    }
+
+    // Once every request is accepted the coroutine may already be running
+    // again on the executor, so this awaiter is only touched if some were
+    // refused (then the group cannot complete before they are taken off)
+    size_t accepted = scorer->batcher.submit(queue, requests, count, false);
+    if (accepted == count) {
+        return true;
+    }
+    std::lock_guard<std::mutex> guard(group.lock);
+    refused = count - accepted;
+    group.remaining -= refused;
+    return group.remaining > 0;     // False resumes the coroutine right away
+}
+
+// Posts the awaiting coroutine to the executor
+void AsyncScorer::Submission::resume(void* context) {
+    Submission* submission = static_cast<Submission*>(context);
+    Executor& executor = submission->scorer->executor;
+    std::coroutine_handle<> awaiting = submission->awaiting;
+    executor.post(awaiting);
+}
+
+// Scores one text
+Task<float> AsyncScorer::scoreAsync(DSStringView text) {
+    ScoreRequest request;
+    request.text = text.toDSString();
+    request.score = 0;
+    ScoreRequest* requests[1] = {&request};
+    size_t accepted = co_await Submission(this, requests, 1);
+    co_return (accepted == 1) ? static_cast<float>(request.score) : std::numeric_limits<float>::quiet_NaN();
+}
+
+// Scores several texts as one submission
+Task<std::vector<float>> AsyncScorer::scoreBatchAsync(const DSStringView* texts, size_t count) {
+    std::vector<ScoreRequest> requests(count);
+    std::vector<ScoreRequest*> pointers(count);
+    for (size_t i = 0; i < count; i++) {
+        requests[i].text = texts[i].toDSString();
+        requests[i].score = 0;
+        pointers[i] = &requests[i];
+    }
+    size_t accepted = co_await Submission(this, pointers.data(), count);
+
+    std::vector<float> scores(count, std::numeric_limits<float>::quiet_NaN());
+    for (size_t i = 0; i < accepted; i++) {
+        scores[i] = static_cast<float>(requests[i].score);
+    }
+    co_return scores;
+}
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,177 @@
+/**
+ * AsyncScorerTest.cpp
+ *
+ * A simple test program for the coroutine scoring interface.
+ * Runs tasks on a single-threaded executor and checks that awaited
+ * scores match synchronous scoring and that every coroutine resumes on
+ * the executor's thread. Needs C++20 (-std=c++20).
+ */
+
+#include "../include/AsyncScorer.h"
+#include "../include/SentimentClassifier.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Helper function to check if an assertion passed
+void testPassed(const char* testName) {
+    std::cout << "✓ " << testName << " passed" << std::endl;
+}
+
+// Helper coroutines for the task tests
+Task<int> answer() {
+    co_return 42;
+}
+
+Task<int> doubledAnswer() {
+    int value = co_await answer();
+    co_return value * 2;
+}
+
+Task<int> failing() {
+    throw std::runtime_error("failed");
+    co_return 0;
+}
+
+// Spawned tasks are plain functions: parameters are copied into the
+// coroutine, while a lambda's captures would die with the lambda
+Task<void> chainTask(int* value, bool* caught) {
+    *value = co_await doubledAnswer();
+    try {
+        co_await failing();
+    } catch (const std::runtime_error&) {
+        *caught = true;
+    }
+}
+
+Task<void> scoreEachTask(AsyncScorer* scorer, const std::vector<DSStringView>* views, std::vector<float>* scores,
+                         int* resumedElsewhere, std::thread::id executorThread) {
+    for (size_t i = 0; i < views->size(); i++) {
+        (*scores)[i] = co_await scorer->scoreAsync((*views)[i]);
+        if (std::this_thread::get_id() != executorThread) {
+            (*resumedElsewhere)++;
+        }
+    }
+}
+
+Task<void> scoreOneTask(AsyncScorer* scorer, DSStringView view, float* score, int* resumedElsewhere,
+                        std::thread::id executorThread) {
+    *score = co_await scorer->scoreAsync(view);
+    if (std::this_thread::get_id() != executorThread) {
+        (*resumedElsewhere)++;
+    }
+}
+
+Task<void> scoreBatchTask(AsyncScorer* scorer, const std::vector<DSStringView>* views, std::vector<float>* scores,
+                          std::vector<float>* none) {
+    *scores = co_await scorer->scoreBatchAsync(views->data(), views->size());
+    *none = co_await scorer->scoreBatchAsync(views->data(), 0);
+}
+
+int main() {
+    std::cout << "Running AsyncScorer tests..." << std::endl;
+
+    // A small training set written to a temporary file
+    char trainingFile[] = "/tmp/asyncscorertestXXXXXX";
+    int fd = mkstemp(trainingFile);
+    assert(fd >= 0);
+    close(fd);
+    {
+        std::ofstream out(trainingFile);
+        out << "Sentiment,id,Date,Query,User,Tweet\n";
+        const char* positive[] = {"i love this great day", "what a happy sunny morning", "great fun with friends",
+                                  "love the new song so good", "happy happy joy"};
+        const char* negative[] = {"i hate this awful day", "so sad and tired today", "terrible rain again",
+                                  "worst traffic ever so bad", "sad awful news"};
+        for (int i = 0; i < 5; i++) {
+            out << "4," << (2 * i) << ",Mon,NO_QUERY,user," << positive[i] << "\n";
+            out << "0," << (2 * i + 1) << ",Mon,NO_QUERY,user," << negative[i] << "\n";
+        }
+    }
+    SentimentClassifier classifier;
+    classifier.setNumThreads(2);
+    bool trained = classifier.train(DSString(trainingFile));
+    std::remove(trainingFile);
+    assert(trained);
+
+    std::vector<DSString> texts = {DSString("love this happy morning"), DSString("awful sad rain"),
+                                   DSString("great traffic"), DSString("nothing known here"), DSString("")};
+    std::vector<DSStringView> views(texts.begin(), texts.end());
+
+    // Test 1: Tasks chain and pass values and exceptions to their awaiters
+    {
+        SingleThreadExecutor executor;
+        int value = 0;
+        bool caught = false;
+        executor.spawn(chainTask(&value, &caught));
+        executor.run();
+        assert(value == 84);
+        assert(caught);
+        testPassed("Task chaining");
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        // Second pass: the frozen model with its batched lookup
+        if (pass == 1) {
+            FreezeOptions options;
+            options.weightBits = 16;
+            bool frozen = classifier.freezeModel(options);
+            assert(frozen);
+        }
+        std::vector<float> expected;
+        for (const DSString& text : texts) {
+            expected.push_back(static_cast<float>(classifier.scoreText(text, 0)));
+        }
+
+        SingleThreadExecutor executor;
+        AsyncScorer scorer(classifier, executor);
+        std::thread::id executorThread = std::this_thread::get_id();
+
+        // Test 2: Awaited scores match synchronous scoring, resumed on the executor thread
+        {
+            std::vector<float> scores(texts.size(), -1.0f);
+            int resumedElsewhere = 0;
+            executor.spawn(scoreEachTask(&scorer, &views, &scores, &resumedElsewhere, executorThread));
+            executor.run();
+            assert(scores == expected);
+            assert(resumedElsewhere == 0);
+            testPassed(pass == 0 ? "scoreAsync" : "scoreAsync (frozen)");
+        }
+
+        // Test 3: Many coroutines waiting at once all complete
+        {
+            const int numTasks = 1000;
+            std::vector<float> scores(numTasks, -1.0f);
+            int resumedElsewhere = 0;
+            for (int t = 0; t < numTasks; t++) {
+                executor.spawn(scoreOneTask(&scorer, views[t % views.size()], &scores[t], &resumedElsewhere,
+                                            executorThread));
+            }
+            executor.run();
+            for (int t = 0; t < numTasks; t++) {
+                assert(scores[t] == expected[t % views.size()]);
+            }
+            assert(resumedElsewhere == 0);
+            testPassed(pass == 0 ? "Concurrent awaits" : "Concurrent awaits (frozen)");
+        }
+
+        // Test 4: Batched scoring, including an empty batch
+        {
+            std::vector<float> scores;
+            std::vector<float> none(1, 0.0f);
+            executor.spawn(scoreBatchTask(&scorer, &views, &scores, &none));
+            executor.run();
+            assert(scores == expected);
+            assert(none.empty());
+            testPassed(pass == 0 ? "scoreBatchAsync" : "scoreBatchAsync (frozen)");
+        }
+    }
+
+    std::cout << "\nAll AsyncScorer tests passed successfully!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * BloomFilter.cpp
+ *
+ * Implementation of the blocked Bloom filter declared in BloomFilter.h.
+ */
+
+#include "../include/BloomFilter.h"
+#include <cmath>
+
+// Default constructor
+BlockedBloomFilter::BlockedBloomFilter() : numBlocks(0), numHashes(0) {
+}
+
+// Sizes the filter to a fixed memory budget
+void BlockedBloomFilter::initWithMemory(size_t memoryBytes, int numHashes) {
+    size_t blockBytes = BLOCK_WORDS * sizeof(uint64_t);
+    numBlocks = (memoryBytes + blockBytes - 1) / blockBytes;
+    if (numBlocks == 0) {
+        numBlocks = 1;
+    }
+    this->numHashes = (numHashes < 1) ? 1 : (numHashes > 16) ? 16 : numHashes;
+
+    size_t numWords = numBlocks * BLOCK_WORDS;
+    words.reset(new std::atomic<uint64_t>[numWords]);
+    for (size_t i = 0; i < numWords; i++) {
+        words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// Sizes the filter for a number of keys and a target false-positive rate
+void BlockedBloomFilter::initForKeys(size_t expectedKeys, double falsePositiveRate) {
+    if (falsePositiveRate <= 0.0 || falsePositiveRate >= 1.0) {
+        falsePositiveRate = 0.01;
+    }
+    if (expectedKeys == 0) {
+        expectedKeys = 1;
+    }
+
+    // Classic sizing: m/n = -ln(p) / ln(2)^2 bits per key, k = (m/n) ln(2).
+    // Blocking raises the false-positive rate slightly, so add 10% more bits.
+    double ln2 = std::log(2.0);
+    double bitsPerKey = -std::log(falsePositiveRate) / (ln2 * ln2) * 1.1;
+    int k = static_cast<int>(std::lround(bitsPerKey / 1.1 * ln2));
+    initWithMemory(static_cast<size_t>(bitsPerKey * expectedKeys / 8.0) + 1, k);
+}
+
+// Inserts a key
+bool BlockedBloomFilter::insert(uint64_t key) {
+    std::atomic<uint64_t>* block = &words[blockFor(key, numBlocks) * BLOCK_WORDS];
+
+    // Double hashing inside the 512-bit block using the low half of the key
+    uint32_t h1 = static_cast<uint32_t>(key);
+    uint32_t h2 = static_cast<uint32_t>(key >> 17) | 1u;
+    bool allSet = true;
+    for (int i = 0; i < numHashes; i++) {
+        uint32_t bit = (h1 + i * h2) & 511u;
+        uint64_t mask = 1ull << (bit & 63u);
+        uint64_t previous = block[bit >> 6].fetch_or(mask, std::memory_order_relaxed);
+        if ((previous & mask) == 0) {
+            allSet = false;
+        }
+    }
+    return allSet;
+}
+
+// Tests for a key
+bool BlockedBloomFilter::mayContain(uint64_t key) const {
+    if (numBlocks == 0) {
+        return false;
+    }
+    const std::atomic<uint64_t>* block = &words[blockFor(key, numBlocks) * BLOCK_WORDS];
+
+    uint32_t h1 = static_cast<uint32_t>(key);
+    uint32_t h2 = static_cast<uint32_t>(key >> 17) | 1u;
+    for (int i = 0; i < numHashes; i++) {
+        uint32_t bit = (h1 + i * h2) & 511u;
+        if ((block[bit >> 6].load(std::memory_order_relaxed) & (1ull << (bit & 63u))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copies the bit array out
+void BlockedBloomFilter::copyBits(uint64_t* out) const {
+    size_t numWords = numBlocks * BLOCK_WORDS;
+    for (size_t i = 0; i < numWords; i++) {
+        out[i] = words[i].load(std::memory_order_relaxed);
+    }
+}
+
+// Tests for a key in a copied bit array (same probe sequence as the member version)
+bool BlockedBloomFilter::mayContain(const uint64_t* bits, size_t numBlocks, int numHashes, uint64_t key) {
+    if (numBlocks == 0) {
+        return false;
+    }
+    const uint64_t* block = &bits[blockFor(key, numBlocks) * BLOCK_WORDS];
+
+    uint32_t h1 = static_cast<uint32_t>(key);
+    uint32_t h2 = static_cast<uint32_t>(key >> 17) | 1u;
+    for (int i = 0; i < numHashes; i++) {
+        uint32_t bit = (h1 + i * h2) & 511u;
+        if ((block[bit >> 6] & (1ull << (bit & 63u))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Expected false-positive rate after inserting the given number of keys
+double BlockedBloomFilter::estimatedFalsePositiveRate(size_t insertedKeys) const {
+    if (numBlocks == 0) {
+        return 1.0;
+    }
+    // Standard approximation (1 - e^(-kn/m))^k over the whole bit array
+    double bits = static_cast<double>(numBlocks) * BLOCK_WORDS * 64.0;
+    double fill = 1.0 - std::exp(-numHashes * static_cast<double>(insertedKeys) / bits);
+    return std::pow(fill, numHashes);
+}
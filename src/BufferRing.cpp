@@ -0,0 +1,104 @@
+/**
+ * BufferRing.cpp
+ *
+ * Implementation of the producer/consumer buffer ring declared in BufferRing.h.
+ */
+
+#include "../include/BufferRing.h"
+#include <new>     // For std::bad_alloc
+
+// Default constructor
+BufferRing::BufferRing() : finished(false), failed(false), cancelled(false) {
+}
+
+// Allocates the buffers and resets the ring
+void BufferRing::init(int numBuffers, size_t bufferSize) {
+    buffers.clear();
+    buffers.resize(numBuffers < 2 ? 2 : numBuffers);
+    emptyQueue.clear();
+    fullQueue.clear();
+    bufferSize = (bufferSize + RING_BUFFER_ALIGNMENT - 1) & ~(RING_BUFFER_ALIGNMENT - 1);
+    if (bufferSize == 0) {
+        bufferSize = RING_BUFFER_ALIGNMENT;
+    }
+    for (RingBuffer& buffer : buffers) {
+        buffer.data.reset(static_cast<char*>(std::aligned_alloc(RING_BUFFER_ALIGNMENT, bufferSize)));
+        if (!buffer.data) {
+            throw std::bad_alloc();
+        }
+        buffer.capacity = bufferSize;
+        buffer.size = 0;
+        emptyQueue.push_back(&buffer);
+    }
+    finished = false;
+    failed = false;
+    cancelled = false;
+}
+
+// Producer: waits for an empty buffer
+RingBuffer* BufferRing::acquireEmpty() {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] { return cancelled || !emptyQueue.empty(); });
+    if (cancelled) {
+        return nullptr;
+    }
+    RingBuffer* buffer = emptyQueue.front();
+    emptyQueue.pop_front();
+    buffer->size = 0;
+    return buffer;
+}
+
+// Producer: hands a filled buffer to the consumer
+void BufferRing::publishFull(RingBuffer* buffer) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        fullQueue.push_back(buffer);
+    }
+    changed.notify_all();
+}
+
+// Producer: signals that no more buffers will be published
+void BufferRing::finish(bool failed) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        finished = true;
+        this->failed = failed;
+    }
+    changed.notify_all();
+}
+
+// Consumer: waits for the next filled buffer
+RingBuffer* BufferRing::acquireFull() {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] { return finished || !fullQueue.empty(); });
+    if (fullQueue.empty()) {
+        return nullptr;
+    }
+    RingBuffer* buffer = fullQueue.front();
+    fullQueue.pop_front();
+    return buffer;
+}
+
+// Consumer: returns a consumed buffer to the producer
+void BufferRing::releaseEmpty(RingBuffer* buffer) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        emptyQueue.push_back(buffer);
+    }
+    changed.notify_all();
+}
+
+// Consumer: stops the producer early
+void BufferRing::cancel() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        cancelled = true;
+    }
+    changed.notify_all();
+}
+
+// True if the producer reported an error
+bool BufferRing::hasFailed() {
+    std::lock_guard<std::mutex> guard(lock);
+    return failed;
+}
@@ -0,0 +1,186 @@
+/**
+ * ConcurrentVocabulary.cpp
+ *
+ * Implementation of the lock-free shared word count table declared in
+ * ConcurrentVocabulary.h.
+ */
+
+#include "../include/ConcurrentVocabulary.h"
+#include "../include/Hash64.h"
+#include <cstring>      // For memcpy and memcmp
+#include <new>          // For placement new and std::bad_alloc
+
+// Size of each arena block; words longer than this get a block of their own.
+// With huge pages every block is one huge page.
+static const size_t ARENA_BLOCK_BYTES = 64 * 1024;
+
+// Linear probes before an insert gives up and counts the word as overflow
+static const size_t MAX_PROBES = 64;
+
+// Count added to the packed counts word by one occurrence
+static const uint64_t POSITIVE_ONE = static_cast<uint64_t>(1) << 32;
+static const uint64_t NEGATIVE_ONE = 1;
+
+/**
+ * Helper function: compares a stored key with a word
+ */
+static inline bool sameKey(uint64_t storedHash, uint32_t storedLength, const char* storedText,
+                           uint64_t hash, const char* text, int length) {
+    return storedHash == hash && storedLength == static_cast<uint32_t>(length) &&
+           std::memcmp(storedText, text, length) == 0;
+}
+
+// Default constructor
+ConcurrentVocabulary::ConcurrentVocabulary()
+    : slots(nullptr), capacity(0), maxCount(0), count(0), hugePages(HUGE_PAGES_OFF),
+      arenaBlockBytes(ARENA_BLOCK_BYTES) {
+}
+
+// Sizes the table and creates one arena per thread
+void ConcurrentVocabulary::reserve(size_t expectedWords, int numThreads, HugePageMode hugePages) {
+    size_t size = 16;
+    while (size < expectedWords * 2) {
+        size <<= 1;
+    }
+
+    // Slots are trivially destructible, so unmapping the memory is enough
+    if (!slotMemory.allocate(size * sizeof(Slot), hugePages)) {
+        throw std::bad_alloc();
+    }
+    slots = reinterpret_cast<Slot*>(slotMemory.data());
+    for (size_t i = 0; i < size; i++) {
+        Slot* slot = new (&slots[i]) Slot;
+        slot->key.store(nullptr, std::memory_order_relaxed);
+        slot->counts.store(0, std::memory_order_relaxed);
+    }
+    capacity = size;
+    maxCount = size - size / 4;     // Keep probe sequences short
+    count.store(0, std::memory_order_relaxed);
+
+    arenas.clear();
+    arenas.resize(numThreads < 1 ? 1 : numThreads);
+    this->hugePages = hugePages;
+    arenaBlockBytes = (hugePages == HUGE_PAGES_OFF) ? ARENA_BLOCK_BYTES : LargePageBuffer::HUGE_PAGE_BYTES;
+}
+
+// Copies a key into the thread's arena
+ConcurrentVocabulary::KeyRecord* ConcurrentVocabulary::allocateKey(ThreadArena& arena, uint64_t hash,
+                                                                   const char* text, int length) {
+    // Round up so every record stays 8-byte aligned
+    size_t bytes = (offsetof(KeyRecord, text) + length + 7) & ~static_cast<size_t>(7);
+    if (bytes > arena.remaining) {
+        size_t blockBytes = (bytes > arenaBlockBytes) ? bytes : arenaBlockBytes;
+        LargePageBuffer block;
+        if (!block.allocate(blockBytes, hugePages)) {
+            throw std::bad_alloc();
+        }
+        arena.blocks.push_back(std::move(block));
+        arena.next = arena.blocks.back().data();
+        arena.remaining = blockBytes;
+    }
+
+    KeyRecord* record = reinterpret_cast<KeyRecord*>(arena.next);
+    record->hash = hash;
+    record->length = static_cast<uint32_t>(length);
+    std::memcpy(record->text, text, length);
+    arena.next += bytes;
+    arena.remaining -= bytes;
+    arena.usedBytes += bytes;
+    return record;
+}
+
+// Returns the most recent allocation of the thread's arena
+void ConcurrentVocabulary::releaseKey(ThreadArena& arena, KeyRecord* record) {
+    size_t bytes = static_cast<size_t>(arena.next - reinterpret_cast<char*>(record));
+    arena.next = reinterpret_cast<char*>(record);
+    arena.remaining += bytes;
+    arena.usedBytes -= bytes;
+}
+
+// Counts one occurrence of a word
+void ConcurrentVocabulary::add(int thread, const char* text, int length, bool positive) {
+    ThreadArena& arena = arenas[thread];
+    uint64_t hash = hash64(text, length);
+    uint64_t increment = positive ? POSITIVE_ONE : NEGATIVE_ONE;
+    size_t mask = capacity - 1;
+    KeyRecord* mine = nullptr;      // Our copy of the key, once allocated
+
+    for (size_t probe = 0, i = hash & mask; probe < MAX_PROBES && probe < capacity; probe++, i = (i + 1) & mask) {
+        Slot& slot = slots[i];
+        KeyRecord* current = slot.key.load(std::memory_order_acquire);
+
+        if (current == nullptr) {
+            // Reserve room before claiming the slot so the load limit is respected
+            if (mine == nullptr) {
+                if (count.fetch_add(1, std::memory_order_relaxed) >= maxCount) {
+                    count.fetch_sub(1, std::memory_order_relaxed);
+                    break;
+                }
+                mine = allocateKey(arena, hash, text, length);
+            }
+            if (slot.key.compare_exchange_strong(current, mine, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire)) {
+                slot.counts.fetch_add(increment, std::memory_order_relaxed);
+                return;
+            }
+            // Lost the race: current is now the winner's key, check whether it is ours
+        }
+
+        if (sameKey(current->hash, current->length, current->text, hash, text, length)) {
+            slot.counts.fetch_add(increment, std::memory_order_relaxed);
+            if (mine != nullptr) {
+                releaseKey(arena, mine);
+                count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+    }
+
+    // Table full (or probe sequence too long): count the word on the side
+    if (mine != nullptr) {
+        releaseKey(arena, mine);
+        count.fetch_sub(1, std::memory_order_relaxed);
+    }
+    auto& counts = arena.overflow[DSString(text, length)];
+    if (positive) {
+        counts.first++;
+    } else {
+        counts.second++;
+    }
+}
+
+// Calls visit(word, positive, negative) for every word counted
+void ConcurrentVocabulary::forEach(const std::function<void(const DSString&, int, int)>& visit) const {
+    for (size_t i = 0; i < capacity; i++) {
+        const KeyRecord* key = slots[i].key.load(std::memory_order_acquire);
+        if (key == nullptr) {
+            continue;
+        }
+        uint64_t counts = slots[i].counts.load(std::memory_order_relaxed);
+        visit(DSString(key->text, static_cast<int>(key->length)),
+              static_cast<int>(counts >> 32), static_cast<int>(counts & 0xFFFFFFFFu));
+    }
+    for (const ThreadArena& arena : arenas) {
+        for (const auto& entry : arena.overflow) {
+            visit(entry.first, entry.second.first, entry.second.second);
+        }
+    }
+}
+
+// Number of distinct words counted in the overflow maps
+size_t ConcurrentVocabulary::overflowWords() const {
+    size_t total = 0;
+    for (const ThreadArena& arena : arenas) {
+        total += arena.overflow.size();
+    }
+    return total;
+}
+
+// Bytes used by the slot array and the key arenas
+size_t ConcurrentVocabulary::memoryBytes() const {
+    size_t total = capacity * sizeof(Slot);
+    for (const ThreadArena& arena : arenas) {
+        total += arena.usedBytes;
+    }
+    return total;
+}
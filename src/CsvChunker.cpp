@@ -0,0 +1,134 @@
+/**
+ * CsvChunker.cpp
+ *
+ * Implementation of the record-aligned CSV splitter declared in CsvChunker.h.
+ */
+
+#include "../include/CsvChunker.h"
+#include <cstring>      // For memchr
+#include <thread>
+
+// Constructor
+CsvChunker::CsvChunker(int numThreads) : numThreads(numThreads < 1 ? 1 : numThreads) {
+}
+
+// Scans one chunk under both starting assumptions
+void CsvChunker::scanChunk(const char* data, size_t begin, size_t end, ChunkScan& scan) {
+    scan.firstBreak[0] = NO_BOUNDARY;
+    scan.firstBreak[1] = NO_BOUNDARY;
+
+    // q is the quote parity since the chunk start, so a newline seen with
+    // parity q ends a record exactly when the chunk started in state q
+    int q = 0;
+    size_t i = begin;
+    while (i < end && (scan.firstBreak[0] == NO_BOUNDARY || scan.firstBreak[1] == NO_BOUNDARY)) {
+        if (scan.firstBreak[q] != NO_BOUNDARY) {
+            // Nothing more to learn until the next quote flips the state
+            const void* quote = std::memchr(data + i, '"', end - i);
+            if (quote == nullptr) {
+                i = end;
+                break;
+            }
+            i = static_cast<size_t>(static_cast<const char*>(quote) - data) + 1;
+            q ^= 1;
+            continue;
+        }
+        char c = data[i];
+        if (c == '"') {
+            q ^= 1;
+        } else if (c == '\n') {
+            scan.firstBreak[q] = i;
+        }
+        i++;
+    }
+
+    // Both boundaries known: only the parity of the remaining quotes matters
+    size_t quotes = 0;
+    for (; i < end; i++) {
+        quotes += (data[i] == '"');
+    }
+    scan.oddQuotes = ((q ^ static_cast<int>(quotes & 1)) != 0);
+}
+
+// Finds the offset just past the last record-ending newline
+size_t CsvChunker::lastRecordEnd(const char* data, size_t length, bool insideAtEnd) {
+    // Walk backwards, undoing quote toggles to recover the state at each byte
+    bool inside = insideAtEnd;
+    for (size_t i = length; i > 0; i--) {
+        char c = data[i - 1];
+        if (c == '\n' && !inside) {
+            return i;
+        }
+        if (c == '"') {
+            inside = !inside;
+        }
+    }
+    return 0;
+}
+
+// Finds the end of the record starting at position
+size_t CsvChunker::recordEnd(const char* data, size_t position, size_t end) {
+    bool inside = false;
+    size_t i = position;
+    while (true) {
+        const void* newline = std::memchr(data + i, '\n', end - i);
+        size_t stop = (newline != nullptr) ? static_cast<size_t>(static_cast<const char*>(newline) - data) : end;
+        for (size_t j = i; j < stop; j++) {
+            inside ^= (data[j] == '"');
+        }
+        if (!inside || stop == end) {
+            return stop;
+        }
+        i = stop + 1; // Newline inside a quoted field: keep going
+    }
+}
+
+// Splits data into up to numChunks record-aligned chunks
+void CsvChunker::split(const char* data, size_t length, int numChunks, bool atEnd,
+                       std::vector<size_t>& boundaries) const {
+    if (numChunks < 1) {
+        numChunks = 1;
+    }
+    if (static_cast<size_t>(numChunks) > length) {
+        numChunks = (length > 0) ? static_cast<int>(length) : 1;
+    }
+    boundaries.assign(numChunks + 1, 0);
+    if (length == 0) {
+        return;
+    }
+
+    // Pass 1: speculative scan of every chunk, spread over the threads
+    size_t step = length / numChunks;
+    std::vector<ChunkScan> scans(numChunks);
+    auto scanSome = [&](int first) {
+        for (int c = first; c < numChunks; c += numThreads) {
+            size_t begin = c * step;
+            size_t end = (c == numChunks - 1) ? length : begin + step;
+            scanChunk(data, begin, end, scans[c]);
+        }
+    };
+    int threadsUsed = (numThreads < numChunks) ? numThreads : numChunks;
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threadsUsed; t++) {
+        workers.emplace_back(scanSome, t);
+    }
+    scanSome(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Pass 2: prefix XOR of the parities gives each chunk's true start state
+    std::vector<unsigned char> startsInside(numChunks);
+    bool inside = false;
+    for (int c = 0; c < numChunks; c++) {
+        startsInside[c] = inside ? 1 : 0;
+        inside ^= scans[c].oddQuotes;
+    }
+
+    boundaries[numChunks] = atEnd ? length : lastRecordEnd(data, length, inside);
+    for (int c = numChunks - 1; c >= 1; c--) {
+        size_t firstBreak = scans[c].firstBreak[startsInside[c]];
+        size_t boundary = (firstBreak == NO_BOUNDARY) ? boundaries[c + 1] : firstBreak + 1;
+        boundaries[c] = (boundary < boundaries[c + 1]) ? boundary : boundaries[c + 1];
+    }
+}
@@ -0,0 +1,182 @@
+/**
+ * CsvChunkerTest.cpp
+ *
+ * A simple test program for the speculative CSV splitter.
+ * Splits random CSV text with multi-line quoted fields and "" escapes at
+ * every chunk and thread count, and checks that the records of the chunks
+ * parse to the same fields as a sequential scan of the whole text.
+ */
+
+#include "../include/CsvChunker.h"
+#include "../include/SentimentClassifier.h"
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Helper function to check if an assertion passed
+void testPassed(const char* testName) {
+    std::cout << "✓ " << testName << " passed" << std::endl;
+}
+
+// Random training CSV; quoted texts may hold commas, newlines and "" escapes
+std::string randomCsv(std::mt19937& random, int numRecords, bool endWithNewline) {
+    const char* pieces[] = {"good", "bad", "day", ",", "\n", "\"\"", " ", "\r\n", "x"};
+    std::string csv;
+    for (int r = 0; r < numRecords; r++) {
+        csv += (random() % 2 == 0) ? "0," : "4,";
+        csv += std::to_string(r) + ",Mon Apr 06,NO_QUERY,user" + std::to_string(random() % 50) + ",";
+        bool quoted = (random() % 3 != 0);
+        if (quoted) {
+            csv += '"';
+        }
+        int numPieces = static_cast<int>(random() % 12);
+        for (int p = 0; p < numPieces; p++) {
+            const char* piece = pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+            // Only a quoted field may hold separators and quotes
+            if (!quoted && (piece[0] == ',' || piece[0] == '\n' || piece[0] == '"' || piece[0] == '\r')) {
+                piece = "w";
+            }
+            csv += piece;
+        }
+        if (quoted) {
+            csv += '"';
+        }
+        if (r + 1 < numRecords || endWithNewline) {
+            csv += '\n';
+        }
+    }
+    return csv;
+}
+
+// Records of text, scanned one byte at a time
+std::vector<std::string> sequentialRecords(const std::string& text, size_t length, bool keepTail) {
+    std::vector<std::string> records;
+    bool inside = false;
+    size_t start = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '"') {
+            inside = !inside;
+        } else if (text[i] == '\n' && !inside) {
+            records.push_back(text.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    if (keepTail && start < length) {
+        records.push_back(text.substr(start, length - start));
+    }
+    return records;
+}
+
+// Records of the chunks, read the way the training pipeline reads them
+std::vector<std::string> chunkedRecords(const std::string& text, const std::vector<size_t>& boundaries) {
+    std::vector<std::string> records;
+    for (size_t chunk = 0; chunk + 1 < boundaries.size(); chunk++) {
+        size_t position = boundaries[chunk];
+        size_t end = boundaries[chunk + 1];
+        while (position < end) {
+            size_t recordEnd = CsvChunker::recordEnd(text.data(), position, end);
+            records.push_back(text.substr(position, recordEnd - position));
+            position = recordEnd + 1;
+        }
+    }
+    return records;
+}
+
+// Checks that both sets of records parse to the same fields
+void assertSameFields(const SentimentClassifier& parser, const std::vector<std::string>& expected,
+                      const std::vector<std::string>& actual) {
+    assert(expected.size() == actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        assert(expected[i] == actual[i]);
+        std::vector<DSString> expectedFields =
+            parser.parseCSVLine(DSString(expected[i].data(), static_cast<int>(expected[i].size())), true);
+        std::vector<DSString> actualFields =
+            parser.parseCSVLine(DSString(actual[i].data(), static_cast<int>(actual[i].size())), true);
+        assert(expectedFields.size() == actualFields.size());
+        for (size_t f = 0; f < expectedFields.size(); f++) {
+            assert(expectedFields[f] == actualFields[f]);
+        }
+    }
+}
+
+int main() {
+    std::cout << "Running CsvChunker tests..." << std::endl;
+    SentimentClassifier parser;
+    std::mt19937 random(5393);
+
+    // Test 1: recordEnd skips newlines inside quotes and stops at the limit
+    {
+        std::string text = "4,1,d,q,u,\"a\nb\"\"\nc\"\n0,2,d,q,u,x";
+        size_t first = CsvChunker::recordEnd(text.data(), 0, text.size());
+        assert(text[first] == '\n' && text.compare(first + 1, 2, "0,") == 0);
+        assert(CsvChunker::recordEnd(text.data(), first + 1, text.size()) == text.size());
+        assert(CsvChunker::recordEnd(text.data(), 0, 12) == 12);
+        testPassed("recordEnd");
+    }
+
+    // Test 2: Complete input at every chunk and thread count
+    {
+        for (int round = 0; round < 25; round++) {
+            std::string text = randomCsv(random, 1 + static_cast<int>(random() % 60), round % 2 == 0);
+            std::vector<std::string> expected = sequentialRecords(text, text.size(), true);
+            for (int threads = 1; threads <= 8; threads++) {
+                CsvChunker chunker(threads);
+                for (int numChunks = 1; numChunks <= 24; numChunks++) {
+                    std::vector<size_t> boundaries;
+                    chunker.split(text.data(), text.size(), numChunks, true, boundaries);
+                    assert(boundaries.front() == 0 && boundaries.back() == text.size());
+                    for (size_t b = 1; b < boundaries.size(); b++) {
+                        assert(boundaries[b - 1] <= boundaries[b]);
+                    }
+                    assertSameFields(parser, expected, chunkedRecords(text, boundaries));
+                }
+            }
+        }
+        testPassed("Split of complete input");
+    }
+
+    // Test 3: A batch cut anywhere leaves its incomplete last record out
+    {
+        for (int round = 0; round < 20; round++) {
+            std::string text = randomCsv(random, 1 + static_cast<int>(random() % 30), true);
+            for (size_t cut = 0; cut <= text.size(); cut += 1 + random() % 7) {
+                std::vector<std::string> expected = sequentialRecords(text, cut, false);
+                size_t consumed = 0;
+                for (const std::string& record : expected) {
+                    consumed += record.size() + 1;
+                }
+                for (int threads = 1; threads <= 4; threads++) {
+                    CsvChunker chunker(threads);
+                    for (int numChunks = 1; numChunks <= 9; numChunks += 2) {
+                        std::vector<size_t> boundaries;
+                        chunker.split(text.data(), cut, numChunks, false, boundaries);
+                        assert(boundaries.back() == consumed);
+                        assertSameFields(parser, expected, chunkedRecords(text, boundaries));
+                    }
+                }
+            }
+        }
+        testPassed("Split of partial batches");
+    }
+
+    // Test 4: Chunk boundaries that all fall inside one long quoted field
+    {
+        std::string text = "4,1,d,q,u,\"" + std::string(200, '\n') + "\"\"\"\n0,2,d,q,u,\"a\nb\"\n";
+        std::vector<std::string> expected = sequentialRecords(text, text.size(), true);
+        assert(expected.size() == 2);
+        for (int threads = 1; threads <= 8; threads++) {
+            CsvChunker chunker(threads);
+            for (int numChunks = 1; numChunks <= 64; numChunks++) {
+                std::vector<size_t> boundaries;
+                chunker.split(text.data(), text.size(), numChunks, true, boundaries);
+                assertSameFields(parser, expected, chunkedRecords(text, boundaries));
+            }
+        }
+        testPassed("Boundaries inside quotes");
+    }
+
+    std::cout << "\nAll CsvChunker tests passed successfully!" << std::endl;
+    return 0;
+}
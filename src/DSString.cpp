@@ -6,6 +6,7 @@
  */
 
 #include "../include/DSString.h"
+#include "../include/Utf8.h"
 
 /**
  * Helper function: Calculate the length of a C-string
@@ -108,6 +109,23 @@ DSString::DSString(const char* str) {
     stringCopy(data, str, length);
 }
 
+// Constructor from a character range
+DSString::DSString(const char* str, int len) {
+    // Treat a null pointer or negative length as an empty range
+    if (str == nullptr || len < 0) {
+        len = 0;
+    }
+    
+    length = len;
+    data = new char[length + 1];
+    
+    // Copy exactly len characters and terminate
+    for (int i = 0; i < length; i++) {
+        data[i] = str[i];
+    }
+    data[length] = '\0';
+}
+
 // Copy constructor
 DSString::DSString(const DSString& other) {
     // Allocate new memory for the copy
@@ -269,19 +287,34 @@ DSString DSString::substring(int start, int numChars) const {
 
 // Converts string to lowercase
 DSString DSString::toLowerCase() const {
-    // Create a new character array
+    // Create a new character array (lowercasing never changes the byte length)
     char* lowerData = new char[length + 1];
     
-    // Copy characters, converting uppercase to lowercase
-    for (int i = 0; i < length; i++) {
-        // Check if character is uppercase (ASCII 'A' = 65, 'Z' = 90)
-        if (data[i] >= 'A' && data[i] <= 'Z') {
-            // Convert to lowercase (ASCII difference between upper and lower is 32)
-            lowerData[i] = data[i] + 32;
-        } else {
-            // Copy character as is
+    int i = 0;
+    while (i < length) {
+        // Fast path: convert 16 ASCII bytes at a time
+        if (i + UTF8_BLOCK_SIZE <= length && lowerAsciiBlock(data + i, lowerData + i)) {
+            i += UTF8_BLOCK_SIZE;
+            continue;
+        }
+        
+        // Slow path: one character, decoding multi-byte UTF-8 sequences
+        int codePoint;
+        int numBytes = utf8Decode(data + i, length - i, codePoint);
+        if (codePoint < 0) {
+            // Malformed byte: copy as is
             lowerData[i] = data[i];
+        } else {
+            int lower = utf8ToLower(codePoint);
+            if (lower == codePoint) {
+                for (int b = 0; b < numBytes; b++) {
+                    lowerData[i + b] = data[i + b];
+                }
+            } else {
+                utf8Encode(lower, lowerData + i);
+            }
         }
+        i += numBytes;
     }
     
     // Add null terminator
@@ -6,6 +6,7 @@
  */
 
 #include "../include/DSString.h"
+#include "../include/DSStringView.h"
 #include <iostream>
 #include <cassert>
 
@@ -133,6 +134,43 @@ int main() {
         testPassed("Self assignment");
     }
     
+    // Test 13: Constructor from a character range
+    {
+        const char* text = "hello world";
+        DSString s(text + 6, 5);
+        assert(s.size() == 5);
+        assert(s == DSString("world"));
+        assert(s.c_str()[5] == '\0');
+        testPassed("Range constructor");
+    }
+    
+    // Test 14: DSStringView over part of a DSString
+    {
+        DSString s("good morning");
+        DSStringView view(s);
+        DSStringView word = view.substring(5, 7);
+        assert(word.size() == 7);
+        assert(word == DSStringView("morning", 7));
+        assert(word.toDSString() == DSString("morning"));
+        testPassed("DSStringView substring");
+    }
+    
+    // Test 15: toLowerCase on long ASCII text (16-byte fast path plus tail)
+    {
+        DSString s("THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG @ 10 PM!");
+        assert(s.toLowerCase() == DSString("the quick brown fox jumps over the lazy dog @ 10 pm!"));
+        testPassed("toLowerCase ASCII fast path");
+    }
+    
+    // Test 16: toLowerCase on UTF-8 text keeps byte length and code points intact
+    {
+        DSString s("CAF\xC3\x89 \xC3\x9C\xC3\x9C" "BER \xD0\x9F\xD0\xA0\xD0\x98\xD0\x92\xD0\x95\xD0\xA2 \xF0\x9F\x98\x80 ALL DONE, THANKS");
+        DSString lower = s.toLowerCase();
+        assert(lower.size() == s.size());
+        assert(lower == DSString("caf\xC3\xA9 \xC3\xBC\xC3\xBC" "ber \xD0\xBF\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xF0\x9F\x98\x80 all done, thanks"));
+        testPassed("toLowerCase UTF-8");
+    }
+    
     std::cout << "\nAll DSString tests passed successfully!" << std::endl;
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,72 @@
+/**
+ * DSStringView.cpp
+ *
+ * Implementation of the DSStringView class declared in DSStringView.h.
+ */
+
+#include "../include/DSStringView.h"
+
+// Default constructor - creates an empty view
+DSStringView::DSStringView() {
+    data = "";
+    length = 0;
+}
+
+// Constructor from a character range
+DSStringView::DSStringView(const char* str, int len) {
+    // Treat a null pointer or negative length as an empty view
+    if (str == nullptr || len < 0) {
+        data = "";
+        length = 0;
+        return;
+    }
+    data = str;
+    length = len;
+}
+
+// Constructor from a DSString
+DSStringView::DSStringView(const DSString& str) {
+    data = str.c_str();
+    length = str.size();
+}
+
+// Equality operator
+bool DSStringView::operator==(const DSStringView& other) const {
+    // If lengths differ, views are not equal
+    if (length != other.length) {
+        return false;
+    }
+
+    // Compare each character
+    for (int i = 0; i < length; i++) {
+        if (data[i] != other.data[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns a sub-view of this view
+DSStringView DSStringView::substring(int start, int numChars) const {
+    // Check bounds to prevent invalid memory access
+    if (start < 0 || start >= length || numChars <= 0) {
+        return DSStringView();
+    }
+
+    // Clamp numChars to the end of the view
+    if (start + numChars > length) {
+        numChars = length - start;
+    }
+    return DSStringView(data + start, numChars);
+}
+
+// Copies the viewed characters into a new DSString
+DSString DSStringView::toDSString() const {
+    return DSString(data, length);
+}
+
+// Stream insertion operator
+std::ostream& operator<<(std::ostream& os, const DSStringView& view) {
+    os.write(view.data, view.length);
+    return os;
+}
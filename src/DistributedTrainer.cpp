@@ -0,0 +1,126 @@
+/**
+ * DistributedTrainer.cpp
+ *
+ * Implementation of the forking shard coordinator declared in
+ * DistributedTrainer.h.
+ */
+
+#include "../include/DistributedTrainer.h"
+#include "../include/ModelFile.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>       // For std::remove
+#include <cstdlib>      // For getenv and mkdtemp
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Constructor
+DistributedTrainer::DistributedTrainer(int numWorkers) : numWorkers(numWorkers < 1 ? 1 : numWorkers) {
+}
+
+// Creates a private directory for the partial models
+bool DistributedTrainer::makeWorkDirectory() {
+    const char* tmp = std::getenv("TMPDIR");
+    std::string pattern = (tmp != nullptr && tmp[0] != '\0') ? tmp : "/tmp";
+    pattern += "/sentiment-shards-XXXXXX";
+    std::vector<char> buffer(pattern.begin(), pattern.end());
+    buffer.push_back('\0');
+    if (mkdtemp(buffer.data()) == nullptr) {
+        std::cerr << "Error creating work directory " << pattern << std::endl;
+        return false;
+    }
+    workDirectory = DSString(buffer.data());
+    return true;
+}
+
+// Removes the partial models and the work directory
+void DistributedTrainer::cleanUp(const std::vector<DSString>& files) {
+    for (const DSString& file : files) {
+        std::remove(file.c_str());
+    }
+    rmdir(workDirectory.c_str());
+}
+
+// Trains the classifier with one worker process per shard
+bool DistributedTrainer::train(SentimentClassifier& classifier, const InputSet& inputs) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<InputSet> shards;
+    if (!classifier.planShards(inputs, numWorkers, shards)) {
+        return false;
+    }
+    if (!makeWorkDirectory()) {
+        return false;
+    }
+
+    std::vector<DSString> partFiles;
+    for (int i = 0; i < numWorkers; i++) {
+        partFiles.push_back(workDirectory + DSString("/part-") + DSString(std::to_string(i).c_str()) + DSString(".model"));
+    }
+    DSString mergedFile = workDirectory + DSString("/merged.model");
+
+    // Buffered output would otherwise be written once by every child
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<pid_t> children;
+    bool ok = true;
+    for (int i = 0; i < numWorkers; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "Error: could not fork training worker " << i << std::endl;
+            ok = false;
+            break;
+        }
+        if (pid == 0) {
+            // Worker: per-shard statistics would interleave, so only errors are shown
+            int devNull = ::open("/dev/null", O_WRONLY);
+            if (devNull >= 0) {
+                dup2(devNull, STDOUT_FILENO);
+                ::close(devNull);
+            }
+            bool trained = classifier.train(shards[i]) &&
+                           classifier.saveModel(partFiles[i]);
+            std::cout.flush();
+            std::cerr.flush();
+            _exit(trained ? 0 : 1);
+        }
+        children.push_back(pid);
+    }
+
+    // Wait for every worker, even after a failure, so none is left behind
+    for (size_t i = 0; i < children.size(); i++) {
+        int status = 0;
+        while (waitpid(children[i], &status, 0) < 0) {
+            if (errno != EINTR) {
+                status = -1;
+                break;
+            }
+        }
+        if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "Error: training worker " << i << " failed" << std::endl;
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        std::cout << "Trained " << numWorkers << " shards in worker processes:" << std::endl;
+        for (int i = 0; i < numWorkers; i++) {
+            std::cout << "  Shard " << i << ": " << shards[i].size() << (shards[i].size() == 1 ? " file, " : " files, ")
+                      << shards[i].totalBytes() << " bytes" << std::endl;
+        }
+        ok = mergeModelFiles(partFiles, mergedFile) && classifier.loadModel(mergedFile);
+    }
+
+    partFiles.push_back(mergedFile);
+    cleanUp(partFiles);
+
+    if (ok) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Distributed training complete in " << elapsed.count() << " s." << std::endl;
+    }
+    return ok;
+}
@@ -0,0 +1,50 @@
+/**
+ * EpochReclaimer.cpp
+ *
+ * Implementation of the epoch-based reclamation declared in
+ * EpochReclaimer.h.
+ */
+
+#include "../include/EpochReclaimer.h"
+#include <chrono>
+#include <thread>
+
+// Constructor - every reader starts idle, in epoch 1
+EpochReclaimer::EpochReclaimer(int numReaders)
+    : globalEpoch(1), readerCount((numReaders < 1) ? 1 : numReaders), readers(new ReaderSlot[readerCount]) {
+}
+
+// Marks a reader as active
+void EpochReclaimer::enter(int reader) {
+    // Sequentially consistent, so the store is ordered before the reader's
+    // load of the shared pointer: a writer that still sees the slot idle
+    // swapped the pointer before the reader loads it
+    readers[reader].epoch.store(globalEpoch.load());
+}
+
+// Marks a reader as idle
+void EpochReclaimer::exit(int reader) {
+    readers[reader].epoch.store(0, std::memory_order_release);
+}
+
+// Advances the epoch and waits for readers of the previous one
+double EpochReclaimer::synchronize() {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t epoch = globalEpoch.fetch_add(1) + 1;
+    for (int reader = 0; reader < readerCount; reader++) {
+        // Readers hold an epoch for one request, so spin briefly, then sleep
+        int spins = 0;
+        while (true) {
+            uint64_t seen = readers[reader].epoch.load();
+            if (seen == 0 || seen >= epoch) {
+                break;
+            }
+            if (++spins < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,92 @@
+/**
+ * FingerprintSet.cpp
+ *
+ * Implementation of the lock-free fingerprint set declared in FingerprintSet.h.
+ */
+
+#include "../include/FingerprintSet.h"
+
+/**
+ * Helper function: 0 marks an empty slot, so the (rare) zero key is remapped
+ */
+static inline uint64_t storedKey(uint64_t fingerprint) {
+    return fingerprint == 0 ? 1 : fingerprint;
+}
+
+// Default constructor
+FingerprintSet::FingerprintSet() : capacity(0), maxCount(0), count(0), overflows(0) {
+}
+
+// Sizes the set for an expected number of keys
+void FingerprintSet::reserve(size_t expectedKeys) {
+    size_t size = 16;
+    while (size < expectedKeys * 2) {
+        size <<= 1;
+    }
+
+    slots.reset(new std::atomic<uint64_t>[size]);
+    for (size_t i = 0; i < size; i++) {
+        slots[i].store(0, std::memory_order_relaxed);
+    }
+    capacity = size;
+    maxCount = size - size / 8;     // Keep probe sequences short
+    count.store(0, std::memory_order_relaxed);
+    overflows.store(0, std::memory_order_relaxed);
+}
+
+// Inserts a fingerprint
+bool FingerprintSet::insert(uint64_t fingerprint) {
+    uint64_t key = storedKey(fingerprint);
+    size_t mask = capacity - 1;
+
+    for (size_t probe = 0, i = key & mask; probe < capacity; probe++, i = (i + 1) & mask) {
+        uint64_t current = slots[i].load(std::memory_order_relaxed);
+        if (current == key) {
+            return false;
+        }
+        if (current != 0) {
+            continue;
+        }
+
+        // Reserve room before claiming the slot so the load limit is respected
+        if (count.fetch_add(1, std::memory_order_relaxed) >= maxCount) {
+            count.fetch_sub(1, std::memory_order_relaxed);
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        uint64_t expected = 0;
+        if (slots[i].compare_exchange_strong(expected, key, std::memory_order_relaxed)) {
+            return true;
+        }
+
+        // Lost the race for this slot: give the reservation back and re-check it
+        count.fetch_sub(1, std::memory_order_relaxed);
+        if (expected == key) {
+            return false;
+        }
+    }
+
+    overflows.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+// Checks whether a fingerprint has been inserted
+bool FingerprintSet::contains(uint64_t fingerprint) const {
+    if (capacity == 0) {
+        return false;
+    }
+    uint64_t key = storedKey(fingerprint);
+    size_t mask = capacity - 1;
+
+    for (size_t probe = 0, i = key & mask; probe < capacity; probe++, i = (i + 1) & mask) {
+        uint64_t current = slots[i].load(std::memory_order_relaxed);
+        if (current == key) {
+            return true;
+        }
+        if (current == 0) {
+            return false;
+        }
+    }
+    return false;
+}
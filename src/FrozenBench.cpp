@@ -0,0 +1,170 @@
+/**
+ * FrozenBench.cpp
+ *
+ * Benchmark of frozen model lookups on normal and huge pages. A synthetic
+ * vocabulary of several million words is frozen once per page mode and
+ * looked up in random order, the access pattern that defeats the TLB:
+ * with 4 KiB pages nearly every probe of a table this size needs a page
+ * walk. Lookup latency is timed, dTLB load misses are counted with
+ * perf_event_open where the kernel allows it, and the memory the kernel
+ * actually backed with transparent huge pages is read from
+ * /proc/self/smaps_rollup.
+ *
+ * Usage: ./frozenbench [words] [lookups]
+ * (defaults: 4000000 words, 10000000 lookups)
+ */
+
+#include "../include/DSString.h"
+#include "../include/FrozenModel.h"
+#include "../include/LargePageBuffer.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <map>
+#include <random>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+typedef std::map<DSString, std::pair<int, int>> CountMap;
+
+// Helper function: opens a dTLB load-miss counter for this thread, -1 if unavailable
+int openTlbCounter() {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+// Helper function: KiB of this process's anonymous memory on transparent huge pages
+long long anonHugeKiB() {
+    std::ifstream rollup("/proc/self/smaps_rollup");
+    std::string line;
+    while (std::getline(rollup, line)) {
+        if (line.compare(0, 14, "AnonHugePages:") == 0) {
+            return std::atoll(line.c_str() + 14);
+        }
+    }
+    return 0;
+}
+
+// Helper function: a distinct word for every rank
+DSString makeWord(int rank) {
+    char text[16];
+    int length = 0;
+    text[length++] = 'w';
+    for (unsigned int value = static_cast<unsigned int>(rank) * 2654435761u; value != 0; value /= 26) {
+        text[length++] = static_cast<char>('a' + value % 26);
+    }
+    text[length] = '\0';
+    return DSString(text);
+}
+
+int main(int argc, char** argv) {
+    int numWords = (argc > 1) ? std::atoi(argv[1]) : 4000000;
+    size_t numLookups = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+
+    // Vocabulary with random counts; a tenth of the lookups are unknown words
+    std::mt19937_64 random(42);
+    CountMap counts;
+    std::vector<DSString> words;
+    words.reserve(numWords);
+    for (int rank = 0; rank < numWords; rank++) {
+        words.push_back(makeWord(rank));
+        counts[words.back()] = std::make_pair(static_cast<int>(random() % 1000), static_cast<int>(random() % 1000));
+    }
+
+    // Queries laid out back to back so reading them does not touch the TLB much
+    std::vector<char> queryText;
+    std::vector<int> queryLength;
+    std::uniform_int_distribution<int> pick(0, numWords - 1);
+    for (size_t i = 0; i < numLookups; i++) {
+        DSString word = (i % 10 == 9) ? makeWord(numWords + pick(random)) : words[pick(random)];
+        queryText.insert(queryText.end(), word.c_str(), word.c_str() + word.size());
+        queryLength.push_back(word.size());
+    }
+
+    std::cout << "Frozen model benchmark: " << numWords << " words, " << numLookups << " random lookups" << std::endl;
+    std::cout << "mode       pages got                 model MiB   THP MiB   ns/lookup   dTLB misses/lookup" << std::endl;
+
+    const HugePageMode modes[] = {HUGE_PAGES_OFF, HUGE_PAGES_TRANSPARENT, HUGE_PAGES_EXPLICIT};
+    long long checksum = -1;
+    for (HugePageMode mode : modes) {
+        FrozenModel model;
+        FreezeOptions options;
+        options.hotWords = 0;                   // Measure the large table only
+        options.bloomFalsePositiveRate = 0.0;
+        options.hugePages = mode;
+        FreezeStats stats;
+        long long hugeBefore = anonHugeKiB();
+        model.build(counts, options, stats);
+
+        // One warm-up pass faults the pages in, the second is measured
+        FrozenProbeStats probes;
+        long long sum = 0;
+        int tlbCounter = openTlbCounter();
+        std::chrono::steady_clock::time_point start;
+        for (int pass = 0; pass < 2; pass++) {
+            if (pass == 1) {
+                sum = 0;
+                if (tlbCounter >= 0) {
+                    ioctl(tlbCounter, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(tlbCounter, PERF_EVENT_IOC_ENABLE, 0);
+                }
+                start = std::chrono::steady_clock::now();
+            }
+            const char* text = queryText.data();
+            for (size_t i = 0; i < numLookups; i++) {
+                int weight;
+                if (model.lookup(text, queryLength[i], weight, probes)) {
+                    sum += weight;
+                }
+                text += queryLength[i];
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long long hugeKiB = anonHugeKiB() - hugeBefore;
+
+        long long tlbMisses = -1;
+        if (tlbCounter >= 0) {
+            ioctl(tlbCounter, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(tlbCounter, &tlbMisses, sizeof(tlbMisses)) != sizeof(tlbMisses)) {
+                tlbMisses = -1;
+            }
+            close(tlbCounter);
+        }
+
+        // Every page mode must give the same answers
+        if (checksum != -1 && sum != checksum) {
+            std::cerr << "Error: lookups differ between page modes" << std::endl;
+            return 1;
+        }
+        checksum = sum;
+
+        std::cout << std::left << std::setw(11) << LargePageBuffer::modeName(mode)
+                  << std::setw(24) << LargePageBuffer::describeBacking(stats.pages) << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(11) << stats.totalBytes / 1048576.0
+                  << std::setw(10) << hugeKiB / 1024.0
+                  << std::setw(12) << seconds * 1e9 / numLookups;
+        if (tlbMisses >= 0) {
+            std::cout << std::setprecision(3) << std::setw(21) << static_cast<double>(tlbMisses) / numLookups;
+        } else {
+            std::cout << std::setw(21) << "n/a";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
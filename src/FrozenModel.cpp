@@ -0,0 +1,518 @@
+/**
+ * FrozenModel.cpp
+ *
+ * Implementation of the compact read-only word weight table declared in
+ * FrozenModel.h.
+ */
+
+#include "../include/FrozenModel.h"
+#include "../include/BloomFilter.h"
+#include "../include/Hash64.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>      // For llabs
+#include <cstring>      // For memcpy, memcmp and strerror
+#include <fcntl.h>      // For O_* flags
+#include <iostream>
+#include <new>          // For std::bad_alloc
+#include <sys/mman.h>   // For shm_open and mmap
+#include <sys/stat.h>   // For fstat
+#include <unistd.h>     // For ftruncate and close
+#include <vector>
+
+// Current blob layout version
+static const uint32_t FROZEN_FORMAT_VERSION = 5;
+
+// Every section starts on a cache line (the blob itself is page aligned)
+static const size_t FROZEN_ALIGNMENT = 64;
+
+// Fraction of weights that must fit the width when quantizing
+static const double QUANTILE_KEPT = 0.999;
+
+/**
+ * Helper function: rounds a size up to the section alignment
+ */
+static inline size_t alignUp(size_t bytes) {
+    return (bytes + FROZEN_ALIGNMENT - 1) & ~(FROZEN_ALIGNMENT - 1);
+}
+
+/**
+ * Helper function: smallest power-of-two slot count at most half full
+ */
+static inline uint32_t slotBitsFor(size_t words) {
+    uint32_t bits = 4;
+    while ((static_cast<size_t>(1) << bits) < words * 2) {
+        bits++;
+    }
+    return bits;
+}
+
+/**
+ * Helper function: inserts a word id into a slot table
+ */
+static inline void insertSlot(uint64_t* table, uint64_t mask, uint64_t hash, uint32_t id) {
+    uint64_t slot = hash & mask;
+    while (table[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    // The upper hash bits tag the slot so most mismatches skip the text compare
+    table[slot] = ((hash >> 32) << 32) | (static_cast<uint64_t>(id) + 1);
+}
+
+// Constructor - an empty model
+FrozenModel::FrozenModel()
+    : shared(nullptr), sharedBytes(0), base(nullptr), hotSlots(nullptr), slots(nullptr), entries(nullptr),
+      weights(nullptr), wide(nullptr), numWide(0), text(nullptr), hotSlotMask(0), slotMask(0), weightBits(32), guardBits(nullptr),
+      guardBlocks(0), guardHashes(0) {
+}
+
+// Destructor - unmaps a shared model
+FrozenModel::~FrozenModel() {
+    clear();
+}
+
+// Discards the frozen model
+void FrozenModel::clear() {
+    blob.release();
+    if (shared != nullptr) {
+        munmap(shared, sharedBytes);
+        shared = nullptr;
+        sharedBytes = 0;
+    }
+    base = nullptr;
+    hotSlots = nullptr;
+    slots = nullptr;
+    entries = nullptr;
+    weights = nullptr;
+    wide = nullptr;
+    numWide = 0;
+    text = nullptr;
+    hotSlotMask = 0;
+    slotMask = 0;
+    guardBits = nullptr;
+    guardBlocks = 0;
+    guardHashes = 0;
+}
+
+// Builds the frozen model from training counts
+bool FrozenModel::build(const std::map<DSString, std::pair<int, int>>& counts, const FreezeOptions& options,
+                        FreezeStats& stats) {
+    int weightBits = options.weightBits;
+    if (weightBits != 8 && weightBits != 16 && weightBits != 32) {
+        std::cerr << "Error: frozen weights must be 8, 16 or 32 bits, not " << weightBits << std::endl;
+        return false;
+    }
+    if (options.bloomFalsePositiveRate < 0.0 || options.bloomFalsePositiveRate >= 1.0) {
+        std::cerr << "Error: Bloom filter false-positive rate must be in [0, 1)" << std::endl;
+        return false;
+    }
+    clear();
+
+    // Word ids in descending training frequency (ties keep string order)
+    typedef std::map<DSString, std::pair<int, int>>::const_iterator Word;
+    std::vector<Word> order;
+    order.reserve(counts.size());
+    long long totalTokens = 0;
+    for (Word it = counts.begin(); it != counts.end(); ++it) {
+        order.push_back(it);
+        totalTokens += static_cast<long long>(it->second.first) + it->second.second;
+    }
+    std::stable_sort(order.begin(), order.end(), [](Word a, Word b) {
+        return static_cast<long long>(a->second.first) + a->second.second >
+               static_cast<long long>(b->second.first) + b->second.second;
+    });
+    size_t numWords = order.size();
+    size_t hotWords = std::min(options.hotWords, numWords);
+
+    // Choose the scale from the distribution of weight magnitudes
+    std::vector<long long> magnitudes;
+    magnitudes.reserve(numWords);
+    size_t textBytes = 0;
+    size_t hotTextBytes = 0;
+    long long hotTokens = 0;
+    for (size_t id = 0; id < numWords; id++) {
+        const auto& entry = *order[id];
+        magnitudes.push_back(std::llabs(static_cast<long long>(entry.second.first) - entry.second.second));
+        textBytes += entry.first.size();
+        if (id < hotWords) {
+            hotTextBytes += entry.first.size();
+            hotTokens += static_cast<long long>(entry.second.first) + entry.second.second;
+        }
+    }
+    long long maxQuantized = (static_cast<long long>(1) << (weightBits - 1)) - 1;
+    double scale = 1.0;
+    if (!magnitudes.empty()) {
+        std::vector<long long> sorted(magnitudes);
+        size_t quantile = static_cast<size_t>(QUANTILE_KEPT * (sorted.size() - 1));
+        std::nth_element(sorted.begin(), sorted.begin() + quantile, sorted.end());
+        long long largest = *std::max_element(magnitudes.begin(), magnitudes.end());
+        if (largest > maxQuantized) {
+            scale = std::max(1.0, static_cast<double>(sorted[quantile]) / maxQuantized);
+        }
+    }
+
+    // Weights still too large go to the side table (|quantized| <= |weight|, so they fit int32)
+    size_t numWide = 0;
+    for (long long magnitude : magnitudes) {
+        if (std::llround(magnitude / scale) > maxQuantized) {
+            numWide++;
+        }
+    }
+
+    // Hot table for the most frequent words, cold table for the rest
+    uint32_t hotSlotBits = (hotWords > 0) ? slotBitsFor(hotWords) : 0;
+    size_t numHotSlots = (hotWords > 0) ? static_cast<size_t>(1) << hotSlotBits : 0;
+    uint32_t slotBits = slotBitsFor(numWords - hotWords);
+    size_t numSlots = static_cast<size_t>(1) << slotBits;
+
+    // Guard over the cold words only: hot words are found before it is consulted
+    BlockedBloomFilter guard;
+    size_t guardBytes = 0;
+    if (options.bloomFalsePositiveRate > 0.0) {
+        guard.initForKeys(numWords - hotWords, options.bloomFalsePositiveRate);
+        guardBytes = guard.memoryBytes();
+    }
+
+    // Lay out the sections
+    size_t weightSize = static_cast<size_t>(weightBits / 8);
+    size_t hotSlotsOffset = alignUp(sizeof(FrozenHeader));
+    size_t slotsOffset = alignUp(hotSlotsOffset + numHotSlots * sizeof(uint64_t));
+    size_t entriesOffset = alignUp(slotsOffset + numSlots * sizeof(uint64_t));
+    size_t weightsOffset = alignUp(entriesOffset + numWords * sizeof(FrozenEntry));
+    size_t wideOffset = alignUp(weightsOffset + numWords * weightSize);
+    size_t textOffset = alignUp(wideOffset + numWide * sizeof(FrozenWide));
+    size_t guardOffset = alignUp(textOffset + textBytes);
+    size_t totalBytes = alignUp(guardOffset + guardBytes);
+
+    // Fresh mappings are zero-filled, so every slot starts empty
+    if (!blob.allocate(totalBytes, options.hugePages)) {
+        throw std::bad_alloc();
+    }
+    char* memory = blob.data();
+
+    FrozenHeader* frozen = reinterpret_cast<FrozenHeader*>(memory);
+    std::memcpy(frozen->magic, "SNTF", 4);
+    frozen->version = FROZEN_FORMAT_VERSION;
+    frozen->numWords = static_cast<uint32_t>(numWords);
+    frozen->weightBits = static_cast<uint32_t>(weightBits);
+    frozen->scale = static_cast<float>(scale);
+    frozen->slotBits = slotBits;
+    frozen->hotWords = static_cast<uint32_t>(hotWords);
+    frozen->hotSlotBits = hotSlotBits;
+    frozen->guardHashes = (guardBytes > 0) ? static_cast<uint32_t>(guard.getNumHashes()) : 0;
+    frozen->tokenizerFlags = options.tokenizerFlags;
+    frozen->numWide = static_cast<uint32_t>(numWide);
+    frozen->hotSlotsOffset = hotSlotsOffset;
+    frozen->slotsOffset = slotsOffset;
+    frozen->entriesOffset = entriesOffset;
+    frozen->weightsOffset = weightsOffset;
+    frozen->wideOffset = wideOffset;
+    frozen->textOffset = textOffset;
+    frozen->guardOffset = guardOffset;
+    frozen->guardBlocks = (guardBytes > 0) ? guard.getNumBlocks() : 0;
+    frozen->totalBytes = totalBytes;
+
+    uint64_t* hotSlotArray = reinterpret_cast<uint64_t*>(memory + hotSlotsOffset);
+    uint64_t* slotArray = reinterpret_cast<uint64_t*>(memory + slotsOffset);
+    FrozenEntry* entryArray = reinterpret_cast<FrozenEntry*>(memory + entriesOffset);
+    char* weightArea = memory + weightsOffset;
+    FrozenWide* wideArray = reinterpret_cast<FrozenWide*>(memory + wideOffset);
+    char* textArea = memory + textOffset;
+    uint64_t hotMask = (numHotSlots > 0) ? numHotSlots - 1 : 0;
+    uint64_t mask = numSlots - 1;
+
+    stats = FreezeStats();
+    size_t textPosition = 0;
+    for (uint32_t id = 0; id < numWords; id++) {
+        const DSString& word = order[id]->first;
+        const std::pair<int, int>& wordCounts = order[id]->second;
+
+        // Text and its location
+        entryArray[id].textOffset = static_cast<uint32_t>(textPosition);
+        entryArray[id].length = static_cast<uint32_t>(word.size());
+        std::memcpy(textArea + textPosition, word.c_str(), word.size());
+        textPosition += word.size();
+
+        // Quantized weight; one too large for the width is marked and kept
+        // in the side table (ids ascend, so the table is sorted by id)
+        long long weight = static_cast<long long>(wordCounts.first) - wordCounts.second;
+        long long quantized = std::llround(weight / scale);
+        if (quantized > maxQuantized || quantized < -maxQuantized) {
+            wideArray[stats.wide].id = id;
+            wideArray[stats.wide].weight = static_cast<int32_t>(quantized);
+            stats.wide++;
+            quantized = -maxQuantized - 1;
+        } else if (quantized == 0 && weight != 0) {
+            stats.zeroed++;
+        }
+        if (weightBits == 8) {
+            reinterpret_cast<int8_t*>(weightArea)[id] = static_cast<int8_t>(quantized);
+        } else if (weightBits == 16) {
+            reinterpret_cast<int16_t*>(weightArea)[id] = static_cast<int16_t>(quantized);
+        } else {
+            reinterpret_cast<int32_t*>(weightArea)[id] = static_cast<int32_t>(quantized);
+        }
+
+        uint64_t hash = hash64(word.c_str(), word.size());
+        if (id < hotWords) {
+            insertSlot(hotSlotArray, hotMask, hash, id);
+        } else {
+            insertSlot(slotArray, mask, hash, id);
+            if (guardBytes > 0) {
+                guard.insert(hash);
+            }
+        }
+    }
+    if (guardBytes > 0) {
+        guard.copyBits(reinterpret_cast<uint64_t*>(memory + guardOffset));
+    }
+    base = memory;
+    setViews();
+
+    stats.words = numWords;
+    stats.weightBits = weightBits;
+    stats.scale = static_cast<float>(scale);
+    stats.weightBytes = numWords * weightSize;
+    stats.fullWeightBytes = numWords * sizeof(std::pair<int, int>);
+    stats.totalBytes = totalBytes;
+    stats.pages = blob.backing();
+    stats.hotWords = hotWords;
+    stats.hotBytes = numHotSlots * sizeof(uint64_t) + hotWords * (sizeof(FrozenEntry) + weightSize) + hotTextBytes;
+    stats.hotShare = (totalTokens > 0) ? static_cast<double>(hotTokens) / totalTokens : 0.0;
+    if (guardBytes > 0) {
+        stats.bloomBytes = guardBytes;
+        stats.bloomHashes = guard.getNumHashes();
+        stats.bloomFalsePositiveRate = guard.estimatedFalsePositiveRate(numWords - hotWords);
+    }
+    return true;
+}
+
+// Makes this model a copy of another one in freshly mapped memory
+void FrozenModel::copyFrom(const FrozenModel& other, HugePageMode hugePages) {
+    clear();
+    if (!other.isFrozen()) {
+        return;
+    }
+    size_t totalBytes = other.sizeBytes();
+    if (!blob.allocate(totalBytes, hugePages)) {
+        throw std::bad_alloc();
+    }
+    // Offsets inside the blob stay valid wherever it is copied
+    std::memcpy(blob.data(), other.base, totalBytes);
+    base = blob.data();
+    setViews();
+}
+
+// Publishes the model in a POSIX shared memory segment
+bool FrozenModel::publish(const char* name) const {
+    if (!isFrozen()) {
+        std::cerr << "Error: no frozen model to publish" << std::endl;
+        return false;
+    }
+    size_t totalBytes = sizeBytes();
+
+    // Replace any old segment; its attached processes keep their own mapping
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: cannot create shared memory segment " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    void* target = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(totalBytes)) == 0) {
+        target = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (target == MAP_FAILED) {
+        std::cerr << "Error: cannot size shared memory segment " << name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(name);
+        return false;
+    }
+
+    // Everything but the magic first, so attach() refuses a partial copy
+    char* destination = static_cast<char*>(target);
+    std::memcpy(destination + sizeof(header()->magic), base + sizeof(header()->magic),
+                totalBytes - sizeof(header()->magic));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    std::memcpy(destination, header()->magic, sizeof(header()->magic));
+    munmap(target, totalBytes);
+    return true;
+}
+
+// Maps a published model read-only, replacing this one
+bool FrozenModel::attach(const char* name) {
+    clear();
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "Error: cannot open shared model " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    size_t bytes = 0;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(FrozenHeader)) {
+        bytes = static_cast<size_t>(info.st_size);
+        mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error: " << name << " is not a frozen model" << std::endl;
+        return false;
+    }
+
+    const FrozenHeader* frozen = static_cast<const FrozenHeader*>(mapping);
+    if (std::memcmp(frozen->magic, "SNTF", 4) != 0 || frozen->version != FROZEN_FORMAT_VERSION ||
+        frozen->totalBytes != bytes) {
+        std::cerr << "Error: " << name << " does not hold a complete frozen model of version "
+                  << FROZEN_FORMAT_VERSION << std::endl;
+        munmap(mapping, bytes);
+        return false;
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    shared = mapping;
+    sharedBytes = bytes;
+    base = static_cast<const char*>(mapping);
+    setViews();
+    return true;
+}
+
+// Removes a published segment
+bool FrozenModel::unpublish(const char* name) {
+    if (shm_unlink(name) != 0) {
+        std::cerr << "Error: cannot remove shared model " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Points the cached views at the sections of the blob
+void FrozenModel::setViews() {
+    const FrozenHeader* frozen = header();
+    const char* memory = base;
+    hotSlots = (frozen->hotWords > 0) ? reinterpret_cast<const uint64_t*>(memory + frozen->hotSlotsOffset) : nullptr;
+    slots = reinterpret_cast<const uint64_t*>(memory + frozen->slotsOffset);
+    entries = reinterpret_cast<const FrozenEntry*>(memory + frozen->entriesOffset);
+    weights = memory + frozen->weightsOffset;
+    wide = reinterpret_cast<const FrozenWide*>(memory + frozen->wideOffset);
+    numWide = frozen->numWide;
+    text = memory + frozen->textOffset;
+    hotSlotMask = (frozen->hotWords > 0) ? (static_cast<uint64_t>(1) << frozen->hotSlotBits) - 1 : 0;
+    slotMask = (static_cast<uint64_t>(1) << frozen->slotBits) - 1;
+    weightBits = static_cast<int>(frozen->weightBits);
+    guardBits = (frozen->guardHashes > 0) ? reinterpret_cast<const uint64_t*>(memory + frozen->guardOffset) : nullptr;
+    guardBlocks = static_cast<size_t>(frozen->guardBlocks);
+    guardHashes = static_cast<int>(frozen->guardHashes);
+}
+
+// Probes one slot table for a word
+uint32_t FrozenModel::probe(const uint64_t* table, uint64_t mask, uint64_t hash, const char* word, int length) const {
+    uint64_t tag = hash >> 32;
+    for (uint64_t i = hash & mask; ; i = (i + 1) & mask) {
+        uint64_t slot = table[i];
+        if (slot == 0) {
+            return 0;
+        }
+        if ((slot >> 32) != tag) {
+            continue;
+        }
+        uint32_t id = static_cast<uint32_t>(slot) - 1;
+        const FrozenEntry& entry = entries[id];
+        if (entry.length == static_cast<uint32_t>(length) &&
+            std::memcmp(text + entry.textOffset, word, length) == 0) {
+            return id + 1;
+        }
+    }
+}
+
+// Reads the quantized weight of a word id
+int FrozenModel::weightOf(uint32_t id) const {
+    int weight;
+    if (weightBits == 8) {
+        weight = static_cast<const int8_t*>(weights)[id];
+    } else if (weightBits == 16) {
+        weight = static_cast<const int16_t*>(weights)[id];
+    } else {
+        return static_cast<const int32_t*>(weights)[id];
+    }
+    if (weight != -(1 << (weightBits - 1))) {
+        return weight;
+    }
+
+    // The most negative value marks a weight kept in the side table
+    const FrozenWide* entry = std::lower_bound(wide, wide + numWide, id, [](const FrozenWide& wideEntry, uint32_t key) {
+        return wideEntry.id < key;
+    });
+    return entry->weight;
+}
+
+// Looks up the quantized weight of a word
+bool FrozenModel::lookup(const char* word, int length, int& weight, FrozenProbeStats& probes) const {
+    if (slots == nullptr) {
+        return false;
+    }
+    return lookupHashed(word, length, hash64(word, length), weight, probes);
+}
+
+// Looks up the quantized weights of many words
+void FrozenModel::lookupBatch(const char* const* words, const int* lengths, size_t count, int* weights,
+                              uint8_t* found, FrozenProbeStats& probes) const {
+    if (slots == nullptr) {
+        std::fill(weights, weights + count, 0);
+        std::fill(found, found + count, 0);
+        return;
+    }
+
+    // Enough words per group to keep the core's outstanding misses busy
+    const size_t GROUP = 16;
+    uint64_t hashes[GROUP];
+    for (size_t first = 0; first < count; first += GROUP) {
+        size_t groupSize = std::min(GROUP, count - first);
+        for (size_t i = 0; i < groupSize; i++) {
+            uint64_t hash = hash64(words[first + i], lengths[first + i]);
+            hashes[i] = hash;
+            if (hotSlots != nullptr) {
+                __builtin_prefetch(&hotSlots[hash & hotSlotMask]);
+            }
+            if (guardBits != nullptr) {
+                BlockedBloomFilter::prefetch(guardBits, guardBlocks, hash);
+            } else {
+                __builtin_prefetch(&slots[hash & slotMask]);
+            }
+        }
+        for (size_t i = 0; i < groupSize; i++) {
+            int weight = 0;
+            found[first + i] = lookupHashed(words[first + i], lengths[first + i], hashes[i], weight, probes) ? 1 : 0;
+            weights[first + i] = weight;
+        }
+    }
+}
+
+// Looks up a word whose hash is already known
+bool FrozenModel::lookupHashed(const char* word, int length, uint64_t hash, int& weight,
+                               FrozenProbeStats& probes) const {
+    if (hotSlots != nullptr) {
+        uint32_t found = probe(hotSlots, hotSlotMask, hash, word, length);
+        if (found != 0) {
+            probes.hotHits++;
+            weight = weightOf(found - 1);
+            return true;
+        }
+    }
+    if (guardBits != nullptr) {
+        if (!BlockedBloomFilter::mayContain(guardBits, guardBlocks, guardHashes, hash)) {
+            probes.bloomSkipped++;
+            probes.misses++;
+            return false;
+        }
+        probes.bloomPassed++;
+    }
+    uint32_t found = probe(slots, slotMask, hash, word, length);
+    if (found != 0) {
+        probes.coldHits++;
+        weight = weightOf(found - 1);
+        return true;
+    }
+    probes.misses++;
+    return false;
+}
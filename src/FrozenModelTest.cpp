@@ -0,0 +1,161 @@
+/**
+ * FrozenModelTest.cpp
+ *
+ * A simple test program for the frozen serving model.
+ * Freezes a count map with weights beyond the int8 and int16 ranges at
+ * every width and checks that each looked-up weight is within half a
+ * quantization step of the exact one (side-table weights included), and
+ * that scores from a 32-bit frozen model equal the unfrozen scores.
+ */
+
+#include "../include/FrozenModel.h"
+#include "../include/SentimentClassifier.h"
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Helper function to check if an assertion passed
+void testPassed(const char* testName) {
+    std::cout << "✓ " << testName << " passed" << std::endl;
+}
+
+// Helper function: true if a quantized weight is within half a step of the exact one
+bool withinHalfStep(int quantized, float scale, long long exact) {
+    double error = std::fabs(quantized * static_cast<double>(scale) - static_cast<double>(exact));
+    // The scale is stored as a float; allow for its rounding
+    return error <= scale / 2.0 + 1e-6 * std::fabs(static_cast<double>(exact)) + 1e-9;
+}
+
+int main() {
+    std::cout << "Running FrozenModel tests..." << std::endl;
+
+    // 3000 ordinary words plus a few far beyond the int8 and int16 ranges
+    std::map<DSString, std::pair<int, int>> counts;
+    for (int i = 0; i < 3000; i++) {
+        int weight = (i * 37) % 601 - 300;
+        int common = 1 + i % 13;
+        std::string word = "w" + std::to_string(i);
+        counts[DSString(word.c_str())] = (weight >= 0) ? std::make_pair(common + weight, common)
+                                                       : std::make_pair(common, common - weight);
+    }
+    counts[DSString("love")] = std::make_pair(70000, 0);
+    counts[DSString("hate")] = std::make_pair(2000, 42000);
+    counts[DSString("good")] = std::make_pair(40000, 7000);
+    counts[DSString("sad")] = std::make_pair(10, 5010);
+    counts[DSString("meh")] = std::make_pair(100, 1100);
+    counts[DSString("even")] = std::make_pair(500, 500);
+
+    // Words to look up: every model word, then some that are not in it
+    std::vector<std::string> queries;
+    for (const auto& entry : counts) {
+        queries.push_back(std::string(entry.first.c_str(), entry.first.size()));
+    }
+    const size_t numKnown = queries.size();
+    queries.push_back("unknown");
+    queries.push_back("w3000");
+    queries.push_back("");
+
+    // Test 1: Every width keeps every weight within half a step
+    const int widths[] = {8, 16, 32};
+    for (int bits : widths) {
+        FreezeOptions options;
+        options.weightBits = bits;
+        options.hotWords = 64;
+        options.hugePages = HUGE_PAGES_OFF;
+        FrozenModel model;
+        FreezeStats stats;
+        bool built = model.build(counts, options, stats);
+        assert(built);
+        assert(model.numWords() == counts.size());
+        float scale = model.getScale();
+        if (bits == 8) {
+            // 70000, 42000 - 2000, 40000 - 7000 and 5000 do not fit int8 at this scale
+            assert(scale > 1.0f && stats.wide == 4);
+        } else if (bits == 16) {
+            // Only the three beyond int16 go to the side table, at scale 1
+            assert(scale == 1.0f && stats.wide == 3);
+        } else {
+            assert(scale == 1.0f && stats.wide == 0);
+        }
+
+        std::vector<const char*> words;
+        std::vector<int> lengths;
+        for (const std::string& query : queries) {
+            words.push_back(query.c_str());
+            lengths.push_back(static_cast<int>(query.size()));
+        }
+        std::vector<int> batchWeights(queries.size(), -1);
+        std::vector<uint8_t> found(queries.size(), 2);
+        FrozenProbeStats probes;
+        model.lookupBatch(words.data(), lengths.data(), queries.size(), batchWeights.data(), found.data(), probes);
+
+        size_t i = 0;
+        for (const auto& entry : counts) {
+            long long exact = static_cast<long long>(entry.second.first) - entry.second.second;
+            int weight = 0;
+            bool present = model.lookup(words[i], lengths[i], weight, probes);
+            assert(present && found[i] == 1);
+            assert(weight == batchWeights[i]);
+            assert(withinHalfStep(weight, scale, exact));
+            if (bits == 32) {
+                assert(weight == exact);
+            }
+            i++;
+        }
+        for (; i < queries.size(); i++) {
+            int weight = 0;
+            assert(!model.lookup(words[i], lengths[i], weight, probes));
+            assert(found[i] == 0 && batchWeights[i] == 0);
+        }
+        assert(i == numKnown + 3);
+    }
+    testPassed("Quantized weights within half a step");
+
+    // Test 2: 32-bit frozen scores equal the unfrozen scores
+    {
+        char trainingFile[] = "/tmp/frozenmodeltestXXXXXX";
+        int fd = mkstemp(trainingFile);
+        assert(fd >= 0);
+        close(fd);
+        {
+            std::ofstream out(trainingFile);
+            out << "Sentiment,id,Date,Query,User,Tweet\n";
+            const char* positive[] = {"i love this great day", "what a happy sunny morning", "great fun with friends"};
+            const char* negative[] = {"i hate this awful day", "so sad and tired today", "terrible rain again"};
+            for (int i = 0; i < 60; i++) {
+                out << "4," << (2 * i) << ",Mon,NO_QUERY,user," << positive[i % 3] << "\n";
+                out << "0," << (2 * i + 1) << ",Mon,NO_QUERY,user," << negative[i % 3] << (i % 5) << "\n";
+            }
+        }
+        SentimentClassifier classifier;
+        classifier.setNumThreads(1);
+        bool trained = classifier.train(DSString(trainingFile));
+        std::remove(trainingFile);
+        assert(trained);
+
+        std::vector<DSString> texts = {DSString("love this happy morning"), DSString("awful sad rain"),
+                                       DSString("great traffic"), DSString("nothing known here"), DSString("")};
+        std::vector<int> unfrozen;
+        for (const DSString& text : texts) {
+            unfrozen.push_back(classifier.scoreText(text, 0));
+        }
+        FreezeOptions options;
+        options.weightBits = 32;
+        bool frozen = classifier.freezeModel(options);
+        assert(frozen);
+        for (size_t t = 0; t < texts.size(); t++) {
+            assert(classifier.scoreText(texts[t], 0) == unfrozen[t]);
+        }
+        testPassed("32-bit frozen scores");
+    }
+
+    std::cout << "\nAll FrozenModel tests passed successfully!" << std::endl;
+    return 0;
+}
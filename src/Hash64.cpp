@@ -0,0 +1,44 @@
+/**
+ * Hash64.cpp
+ *
+ * Implementation of the 64-bit hash functions declared in Hash64.h.
+ */
+
+#include "../include/Hash64.h"
+#include <cstring> // For memcpy (unaligned 8-byte loads)
+
+static const uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+// Mixes a 64-bit value (MurmurHash3 fmix64)
+uint64_t mix64(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+// Hashes a range of bytes
+uint64_t hash64(const char* data, int length, uint64_t seed) {
+    uint64_t hash = seed ^ (static_cast<uint64_t>(length) * HASH_MULTIPLIER);
+
+    // Full 8-byte words
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ mix64(word)) * HASH_MULTIPLIER;
+    }
+
+    // Remaining 0-7 bytes packed into one word
+    if (i < length) {
+        uint64_t word = 0;
+        for (int shift = 0; i < length; i++, shift += 8) {
+            word |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << shift;
+        }
+        hash = (hash ^ mix64(word)) * HASH_MULTIPLIER;
+    }
+
+    return mix64(hash);
+}
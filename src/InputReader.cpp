@@ -0,0 +1,413 @@
+/**
+ * InputReader.cpp
+ *
+ * Implementation of the decompressing line reader declared in InputReader.h.
+ */
+
+#include "../include/InputReader.h"
+#include <cstring>      // For memchr, memcpy
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__has_include)
+#if __has_include(<zlib.h>)
+#include <zlib.h>
+#define SENTIMENT_HAVE_ZLIB 1
+#endif
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define SENTIMENT_HAVE_ZSTD 1
+#endif
+#endif
+
+// Size of the compressed-input staging buffer used by the decompressors
+static const size_t COMPRESSED_CHUNK = 256 * 1024;
+
+// Constructor
+InputReader::InputReader(int queueDepth, size_t blockSize)
+    : fd(-1), queueDepth(queueDepth < 1 ? 1 : queueDepth), blockSize(blockSize == 0 ? AsyncFileReader::DEFAULT_BLOCK_SIZE : blockSize),
+      fileBytes(0), rangeBegin(0), rangeEnd(WHOLE_FILE), regularFile(false), method("read"), format(INPUT_PLAIN), sizeEstimate(0), magicLength(0), magicPosition(0),
+      current(nullptr), position(0), endOfInput(true) {
+}
+
+// Destructor
+InputReader::~InputReader() {
+    close();
+}
+
+// Name of a format
+const char* InputReader::formatName(InputFormat format) {
+    switch (format) {
+        case INPUT_GZIP: return "gzip";
+        case INPUT_ZSTD: return "zstd";
+        default: return "plain";
+    }
+}
+
+// Detects the format from the first bytes of a file
+InputFormat InputReader::detectFormat(const char* magic, int length) {
+    const unsigned char* m = reinterpret_cast<const unsigned char*>(magic);
+    if (length >= 2 && m[0] == 0x1F && m[1] == 0x8B) {
+        return INPUT_GZIP;
+    }
+    if (length >= 4 && m[0] == 0x28 && m[1] == 0xB5 && m[2] == 0x2F && m[3] == 0xFD) {
+        return INPUT_ZSTD;
+    }
+    return INPUT_PLAIN;
+}
+
+// Opens a file, detects its format and starts the producer thread
+bool InputReader::open(const DSString& path, size_t rangeBegin, size_t rangeEnd) {
+    close();
+
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Peek at the magic bytes (kept in magic[] because pipes cannot seek back)
+    magicLength = 0;
+    magicPosition = 0;
+    while (magicLength < 4) {
+        long n = ::read(fd, magic + magicLength, 4 - magicLength);
+        if (n <= 0) {
+            break;
+        }
+        magicLength += static_cast<int>(n);
+    }
+
+    format = detectFormat(magic, magicLength);
+
+#if !defined(SENTIMENT_HAVE_ZLIB)
+    if (format == INPUT_GZIP) {
+        std::cerr << "Error: " << path << " is gzip compressed but this build has no zlib support" << std::endl;
+        close();
+        return false;
+    }
+#endif
+#if !defined(SENTIMENT_HAVE_ZSTD)
+    if (format == INPUT_ZSTD) {
+        std::cerr << "Error: " << path << " is zstd compressed but this build has no zstd support" << std::endl;
+        close();
+        return false;
+    }
+#endif
+
+    // Compressed tweet text typically shrinks 3-4x; assume 5x as an upper bound
+    struct stat info;
+    regularFile = (fstat(fd, &info) == 0 && S_ISREG(info.st_mode));
+    fileBytes = regularFile ? static_cast<size_t>(info.st_size) : 0;
+    sizeEstimate = fileBytes * (format == INPUT_PLAIN ? 1 : 5);
+
+    // Byte ranges (training shards) need random access to uncompressed bytes
+    bool wholeFile = (rangeBegin == 0 && rangeEnd == WHOLE_FILE);
+    if (!wholeFile && (!regularFile || format != INPUT_PLAIN)) {
+        std::cerr << "Error: a byte range of " << path
+                  << " can only be read from an uncompressed regular file" << std::endl;
+        close();
+        return false;
+    }
+    this->rangeBegin = (rangeBegin < fileBytes) ? rangeBegin : fileBytes;
+    this->rangeEnd = (rangeEnd < fileBytes) ? rangeEnd : fileBytes;
+    if (this->rangeEnd < this->rangeBegin) {
+        this->rangeEnd = this->rangeBegin;
+    }
+    if (!wholeFile) {
+        sizeEstimate = this->rangeEnd - this->rangeBegin;
+    }
+
+    ring.init(queueDepth + 2, blockSize);
+    method = "read";
+    current = nullptr;
+    position = 0;
+    endOfInput = false;
+    producer = std::thread(&InputReader::produce, this);
+    return true;
+}
+
+// Stops the producer thread and closes the file
+void InputReader::close() {
+    if (producer.joinable()) {
+        ring.cancel();
+        producer.join();
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    current = nullptr;
+    endOfInput = true;
+}
+
+// True if reading stopped because of an error
+bool InputReader::hasError() {
+    return ring.hasFailed();
+}
+
+// Reads raw file bytes, draining the peeked magic bytes first
+long InputReader::readRaw(char* destination, size_t length) {
+    if (magicPosition < magicLength) {
+        size_t n = static_cast<size_t>(magicLength - magicPosition);
+        if (n > length) {
+            n = length;
+        }
+        std::memcpy(destination, magic + magicPosition, n);
+        magicPosition += static_cast<int>(n);
+        return static_cast<long>(n);
+    }
+    return static_cast<long>(::read(fd, destination, length));
+}
+
+// Producer thread body
+void InputReader::produce() {
+    bool ok;
+    switch (format) {
+        case INPUT_GZIP: ok = produceGzip(); break;
+        case INPUT_ZSTD: ok = produceZstd(); break;
+        default:
+            if (regularFile) {
+                // Block reads at absolute offsets; the peeked magic bytes are re-read
+                AsyncFileReader reader(queueDepth, blockSize);
+                ok = reader.run(fd, rangeBegin, rangeEnd, ring);
+                method = AsyncFileReader::backendName(reader.getBackend());
+            } else {
+                ok = producePlain();
+            }
+            break;
+    }
+    ring.finish(!ok);
+}
+
+// Copies the file into ring buffers unchanged
+bool InputReader::producePlain() {
+    while (true) {
+        RingBuffer* buffer = ring.acquireEmpty();
+        if (buffer == nullptr) {
+            return true; // Cancelled
+        }
+        while (buffer->size < buffer->capacity) {
+            long n = readRaw(buffer->data.get() + buffer->size, buffer->capacity - buffer->size);
+            if (n < 0) {
+                ring.publishFull(buffer);
+                return false;
+            }
+            if (n == 0) {
+                break;
+            }
+            buffer->size += static_cast<size_t>(n);
+        }
+        bool atEnd = buffer->size < buffer->capacity;
+        ring.publishFull(buffer);
+        if (atEnd) {
+            return true;
+        }
+    }
+}
+
+// Inflates a gzip file (including multi-member files) into ring buffers
+bool InputReader::produceGzip() {
+#if defined(SENTIMENT_HAVE_ZLIB)
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        return false;
+    }
+
+    std::unique_ptr<char[]> input(new char[COMPRESSED_CHUNK]);
+    bool ok = true;
+    bool inputDone = false;
+    bool memberEnded = false;   // True between the end of one gzip member and the next
+    RingBuffer* buffer = nullptr;
+
+    while (ok) {
+        // Refill compressed input; a single byte left after a member is
+        // kept, since it has to be checked together with the next one
+        if ((stream.avail_in == 0 || (memberEnded && stream.avail_in == 1)) && !inputDone) {
+            size_t kept = stream.avail_in;
+            if (kept > 0) {
+                input[0] = static_cast<char>(*stream.next_in);
+            }
+            long n = readRaw(input.get() + kept, COMPRESSED_CHUNK - kept);
+            if (n < 0) {
+                ok = false;
+                break;
+            }
+            if (n == 0) {
+                inputDone = true;
+            }
+            stream.next_in = reinterpret_cast<Bytef*>(input.get());
+            stream.avail_in = static_cast<uInt>(kept + n);
+        }
+        if (stream.avail_in == 0 && inputDone) {
+            // A file that ends mid-member is truncated
+            ok = memberEnded;
+            break;
+        }
+        if (memberEnded && (stream.avail_in < 2 || stream.next_in[0] != 0x1f || stream.next_in[1] != 0x8b)) {
+            // Not another member: trailing garbage such as tar padding, ignored as gzip -d does
+            std::cerr << "Warning: Ignored trailing garbage after the gzip data" << std::endl;
+            break;
+        }
+
+        if (buffer == nullptr) {
+            buffer = ring.acquireEmpty();
+            if (buffer == nullptr) {
+                break; // Cancelled
+            }
+        }
+
+        stream.next_out = reinterpret_cast<Bytef*>(buffer->data.get() + buffer->size);
+        stream.avail_out = static_cast<uInt>(buffer->capacity - buffer->size);
+        int status = inflate(&stream, Z_NO_FLUSH);
+        buffer->size = buffer->capacity - stream.avail_out;
+        memberEnded = false;
+
+        if (status == Z_STREAM_END) {
+            // Another gzip member may follow (e.g. concatenated archives)
+            memberEnded = true;
+            inflateReset(&stream);
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            ok = false;
+        }
+
+        if (buffer->size == buffer->capacity) {
+            ring.publishFull(buffer);
+            buffer = nullptr;
+        }
+    }
+
+    if (buffer != nullptr) {
+        ring.publishFull(buffer);
+    }
+    inflateEnd(&stream);
+    return ok;
+#else
+    return false;
+#endif
+}
+
+// Decompresses a zstd file (including multi-frame files) into ring buffers
+bool InputReader::produceZstd() {
+#if defined(SENTIMENT_HAVE_ZSTD)
+    ZSTD_DStream* stream = ZSTD_createDStream();
+    if (stream == nullptr) {
+        return false;
+    }
+    ZSTD_initDStream(stream);
+
+    std::unique_ptr<char[]> input(new char[COMPRESSED_CHUNK]);
+    ZSTD_inBuffer in = {input.get(), 0, 0};
+    bool ok = true;
+    bool inputDone = false;
+    size_t lastResult = 0;
+    RingBuffer* buffer = nullptr;
+
+    while (ok) {
+        // Refill compressed input
+        if (in.pos == in.size && !inputDone) {
+            long n = readRaw(input.get(), COMPRESSED_CHUNK);
+            if (n < 0) {
+                ok = false;
+                break;
+            }
+            if (n == 0) {
+                inputDone = true;
+            }
+            in.size = static_cast<size_t>(n);
+            in.pos = 0;
+        }
+        if (in.pos == in.size && inputDone) {
+            // lastResult != 0 means the final frame was incomplete
+            ok = (lastResult == 0);
+            break;
+        }
+
+        if (buffer == nullptr) {
+            buffer = ring.acquireEmpty();
+            if (buffer == nullptr) {
+                break; // Cancelled
+            }
+        }
+
+        ZSTD_outBuffer out = {buffer->data.get(), buffer->capacity, buffer->size};
+        lastResult = ZSTD_decompressStream(stream, &out, &in);
+        buffer->size = out.pos;
+        if (ZSTD_isError(lastResult)) {
+            ok = false;
+        }
+
+        if (buffer->size == buffer->capacity) {
+            ring.publishFull(buffer);
+            buffer = nullptr;
+        }
+    }
+
+    if (buffer != nullptr) {
+        ring.publishFull(buffer);
+    }
+    ZSTD_freeDStream(stream);
+    return ok;
+#else
+    return false;
+#endif
+}
+
+// Reads the next line, without the trailing newline
+bool InputReader::readLine(std::string& line) {
+    line.clear();
+    bool haveData = false;
+
+    while (!endOfInput) {
+        if (current == nullptr) {
+            current = ring.acquireFull();
+            position = 0;
+            if (current == nullptr) {
+                endOfInput = true;
+                break;
+            }
+        }
+
+        const char* start = current->data.get() + position;
+        size_t available = current->size - position;
+        const char* newline = static_cast<const char*>(std::memchr(start, '\n', available));
+
+        if (newline != nullptr) {
+            line.append(start, static_cast<size_t>(newline - start));
+            position += static_cast<size_t>(newline - start) + 1;
+            return true;
+        }
+
+        // No newline in the rest of this buffer: keep the partial line
+        line.append(start, available);
+        haveData = haveData || available > 0;
+        ring.releaseEmpty(current);
+        current = nullptr;
+    }
+
+    return haveData;
+}
+
+// Appends the next block of raw bytes
+bool InputReader::readBytes(std::string& out) {
+    while (!endOfInput) {
+        if (current == nullptr) {
+            current = ring.acquireFull();
+            position = 0;
+            if (current == nullptr) {
+                endOfInput = true;
+                break;
+            }
+        }
+
+        size_t available = current->size - position;
+        out.append(current->data.get() + position, available);
+        ring.releaseEmpty(current);
+        current = nullptr;
+        if (available > 0) {
+            return true;
+        }
+    }
+    return false;
+}
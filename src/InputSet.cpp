@@ -0,0 +1,251 @@
+/**
+ * InputSet.cpp
+ *
+ * Implementation of the input argument expansion declared in InputSet.h.
+ */
+
+#include "../include/InputSet.h"
+#include "../include/InputReader.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <dirent.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Manifests may list other manifests, up to this depth
+static const int MAX_MANIFEST_DEPTH = 8;
+
+// Compressed tweet text typically shrinks 3-4x; schedule it as 5x its size
+static const size_t COMPRESSED_SIZE_FACTOR = 5;
+
+// Constructor
+InputSet::InputSet() {
+}
+
+// Expands an input argument and appends its files
+bool InputSet::add(const DSString& spec) {
+    size_t before = files.size();
+    if (!addSpec(spec, 0)) {
+        return false;
+    }
+    if (files.size() == before) {
+        std::cerr << "Error: no input files found for " << spec << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Expands one argument
+bool InputSet::addSpec(const DSString& spec, int depth) {
+    if (spec.size() > 1 && spec[0] == '@') {
+        return addManifest(spec.substring(1, spec.size() - 1), depth);
+    }
+
+    struct stat info;
+    if (stat(spec.c_str(), &info) == 0) {
+        return S_ISDIR(info.st_mode) ? addDirectory(spec) : addFile(spec);
+    }
+
+    // Not an existing path: try it as a pattern
+    std::string text(spec.c_str());
+    if (text.find_first_of("*?[") != std::string::npos) {
+        return addPattern(spec);
+    }
+    std::cerr << "Error opening input: " << spec << std::endl;
+    return false;
+}
+
+// Appends one file after checking it can be opened
+bool InputSet::addFile(const DSString& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error opening input: " << path << std::endl;
+        return false;
+    }
+
+    InputFile file;
+    file.path = path;
+    file.bytes = 0;
+    file.begin = 0;
+    file.end = InputReader::WHOLE_FILE;
+
+    // Only regular files have a size and can be peeked without consuming input
+    struct stat info;
+    bool compressed = false;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        file.bytes = static_cast<size_t>(info.st_size);
+        char magic[4];
+        long n = pread(fd, magic, sizeof(magic), 0);
+        compressed = (n > 0 && InputReader::detectFormat(magic, static_cast<int>(n)) != INPUT_PLAIN);
+    }
+    ::close(fd);
+
+    file.estimate = file.bytes * (compressed ? COMPRESSED_SIZE_FACTOR : 1);
+    files.push_back(file);
+    return true;
+}
+
+// Appends a byte range of an uncompressed file
+void InputSet::addRange(const DSString& path, size_t begin, size_t end) {
+    InputFile file;
+    file.path = path;
+    file.bytes = (end > begin) ? end - begin : 0;
+    file.estimate = file.bytes;
+    file.begin = begin;
+    file.end = end;
+    files.push_back(file);
+}
+
+// Appends every regular file in a directory, in name order
+bool InputSet::addDirectory(const DSString& path) {
+    DIR* directory = opendir(path.c_str());
+    if (directory == nullptr) {
+        std::cerr << "Error opening input directory: " << path << std::endl;
+        return false;
+    }
+
+    // Hidden files (editor backups, .DS_Store, ...) are skipped
+    std::vector<std::string> names;
+    while (struct dirent* entry = readdir(directory)) {
+        if (entry->d_name[0] != '.') {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(directory);
+    std::sort(names.begin(), names.end());
+
+    std::string prefix(path.c_str());
+    if (prefix.empty() || prefix.back() != '/') {
+        prefix += '/';
+    }
+    for (const std::string& name : names) {
+        std::string filePath = prefix + name;
+        struct stat info;
+        if (stat(filePath.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+            if (!addFile(DSString(filePath.c_str()))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Appends every file matching a glob pattern, in name order
+bool InputSet::addPattern(const DSString& pattern) {
+    glob_t matches;
+    int result = glob(pattern.c_str(), 0, nullptr, &matches);
+    if (result == GLOB_NOMATCH) {
+        std::cerr << "Error: no files match " << pattern << std::endl;
+        return false;
+    }
+    if (result != 0) {
+        std::cerr << "Error expanding pattern " << pattern << std::endl;
+        return false;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < matches.gl_pathc && ok; i++) {
+        struct stat info;
+        if (stat(matches.gl_pathv[i], &info) == 0 && S_ISREG(info.st_mode)) {
+            ok = addFile(DSString(matches.gl_pathv[i]));
+        }
+    }
+    globfree(&matches);
+    return ok;
+}
+
+// Expands every line of a manifest file
+bool InputSet::addManifest(const DSString& path, int depth) {
+    if (depth >= MAX_MANIFEST_DEPTH) {
+        std::cerr << "Error: manifests nested too deeply at " << path << std::endl;
+        return false;
+    }
+    std::ifstream manifest(path.c_str());
+    if (!manifest.is_open()) {
+        std::cerr << "Error opening manifest: " << path << std::endl;
+        return false;
+    }
+
+    // Relative entries are resolved against the manifest's directory
+    std::string manifestPath(path.c_str());
+    size_t slash = manifestPath.rfind('/');
+    std::string base = (slash == std::string::npos) ? "" : manifestPath.substr(0, slash + 1);
+
+    std::string line;
+    while (std::getline(manifest, line)) {
+        // Trim surrounding whitespace (including a Windows \r)
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        size_t last = line.find_last_not_of(" \t\r");
+        std::string entry = line.substr(first, last - first + 1);
+
+        bool nested = (entry[0] == '@');
+        std::string target = nested ? entry.substr(1) : entry;
+        if (target[0] != '/') {
+            target = base + target;
+        }
+        if (!addSpec(DSString(((nested ? "@" : "") + target).c_str()), depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Orders the files by decreasing estimated size
+void InputSet::sortLargestFirst() {
+    std::stable_sort(files.begin(), files.end(), [](const InputFile& a, const InputFile& b) {
+        if (a.estimate != b.estimate) {
+            return a.estimate > b.estimate;
+        }
+        return a.path < b.path;
+    });
+}
+
+// Splits the files into numShards sets of similar total size
+void InputSet::assignShards(int numShards, std::vector<InputSet>& shards) const {
+    if (numShards < 1) {
+        numShards = 1;
+    }
+    shards.assign(numShards, InputSet());
+
+    InputSet ordered = *this;
+    ordered.sortLargestFirst();
+
+    // Greedy LPT: the next largest file goes to the least loaded shard
+    // (lowest index on ties, so the result is deterministic)
+    std::vector<size_t> load(numShards, 0);
+    for (const InputFile& file : ordered.files) {
+        int target = 0;
+        for (int s = 1; s < numShards; s++) {
+            if (load[s] < load[target]) {
+                target = s;
+            }
+        }
+        shards[target].files.push_back(file);
+        load[target] += file.estimate;
+    }
+}
+
+// Sum of the estimated uncompressed sizes
+size_t InputSet::totalEstimate() const {
+    size_t total = 0;
+    for (const InputFile& file : files) {
+        total += file.estimate;
+    }
+    return total;
+}
+
+// Sum of the bytes read from disk
+size_t InputSet::totalBytes() const {
+    size_t total = 0;
+    for (const InputFile& file : files) {
+        total += file.bytes;
+    }
+    return total;
+}
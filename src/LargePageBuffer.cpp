@@ -0,0 +1,168 @@
+/**
+ * LargePageBuffer.cpp
+ *
+ * Implementation of the huge-page backed buffers declared in
+ * LargePageBuffer.h.
+ */
+
+#include "../include/LargePageBuffer.h"
+#include <cstdint>
+#include <cstring>      // For strcmp
+#include <sys/mman.h>
+#include <unistd.h>     // For sysconf
+#include <utility>
+
+/**
+ * Helper function: rounds a size up to a multiple of a power of two
+ */
+static inline size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) & ~(multiple - 1);
+}
+
+/**
+ * Helper function: maps anonymous memory, nullptr on failure
+ */
+static inline void* mapAnonymous(size_t length, int extraFlags) {
+    void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+    return (address == MAP_FAILED) ? nullptr : address;
+}
+
+// Default constructor - no buffer
+LargePageBuffer::LargePageBuffer()
+    : memory(nullptr), bytes(0), mapping(nullptr), mappedBytes(0), pages(HUGE_PAGES_OFF) {
+}
+
+// Destructor - unmaps the buffer
+LargePageBuffer::~LargePageBuffer() {
+    release();
+}
+
+// Move constructor - takes over the mapping
+LargePageBuffer::LargePageBuffer(LargePageBuffer&& other) noexcept
+    : memory(other.memory), bytes(other.bytes), mapping(other.mapping), mappedBytes(other.mappedBytes),
+      pages(other.pages) {
+    other.memory = nullptr;
+    other.mapping = nullptr;
+    other.bytes = 0;
+    other.mappedBytes = 0;
+}
+
+// Move assignment - releases our mapping and takes over the other one
+LargePageBuffer& LargePageBuffer::operator=(LargePageBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        std::swap(memory, other.memory);
+        std::swap(bytes, other.bytes);
+        std::swap(mapping, other.mapping);
+        std::swap(mappedBytes, other.mappedBytes);
+        std::swap(pages, other.pages);
+    }
+    return *this;
+}
+
+// Unmaps the buffer
+void LargePageBuffer::release() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappedBytes);
+    }
+    memory = nullptr;
+    bytes = 0;
+    mapping = nullptr;
+    mappedBytes = 0;
+    pages = HUGE_PAGES_OFF;
+}
+
+// Maps a zero-filled buffer, replacing any previous one
+bool LargePageBuffer::allocate(size_t requestedBytes, HugePageMode mode) {
+    release();
+    if (requestedBytes == 0) {
+        requestedBytes = 1;
+    }
+    if (requestedBytes < HUGE_PAGE_BYTES) {
+        mode = HUGE_PAGES_OFF;
+    }
+
+    // Explicit huge pages from the hugetlbfs pool
+    if (mode == HUGE_PAGES_EXPLICIT) {
+        size_t length = roundUp(requestedBytes, HUGE_PAGE_BYTES);
+        void* address = mapAnonymous(length, MAP_HUGETLB);
+        if (address != nullptr) {
+            mapping = address;
+            mappedBytes = length;
+            memory = static_cast<char*>(address);
+            bytes = requestedBytes;
+            pages = HUGE_PAGES_EXPLICIT;
+            return true;
+        }
+        mode = HUGE_PAGES_TRANSPARENT;     // Pool empty or not configured
+    }
+
+    // Transparent huge pages: over-map, then trim to a 2 MiB aligned range
+    if (mode == HUGE_PAGES_TRANSPARENT) {
+        size_t length = roundUp(requestedBytes, HUGE_PAGE_BYTES);
+        void* address = mapAnonymous(length + HUGE_PAGE_BYTES, 0);
+        if (address != nullptr) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(address);
+            uintptr_t aligned = roundUp(start, HUGE_PAGE_BYTES);
+            size_t head = aligned - start;
+            size_t tail = HUGE_PAGE_BYTES - head;
+            if (head > 0) {
+                munmap(address, head);
+            }
+            if (tail > 0) {
+                munmap(reinterpret_cast<void*>(aligned + length), tail);
+            }
+            mapping = reinterpret_cast<void*>(aligned);
+            mappedBytes = length;
+            memory = static_cast<char*>(mapping);
+            bytes = requestedBytes;
+            pages = (madvise(mapping, length, MADV_HUGEPAGE) == 0) ? HUGE_PAGES_TRANSPARENT : HUGE_PAGES_OFF;
+            return true;
+        }
+    }
+
+    // Ordinary pages
+    size_t length = roundUp(requestedBytes, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+    void* address = mapAnonymous(length, 0);
+    if (address == nullptr) {
+        return false;
+    }
+    mapping = address;
+    mappedBytes = length;
+    memory = static_cast<char*>(address);
+    bytes = requestedBytes;
+    pages = HUGE_PAGES_OFF;
+    return true;
+}
+
+// Parses a mode name
+bool LargePageBuffer::parseMode(const char* name, HugePageMode& mode) {
+    if (std::strcmp(name, "off") == 0) {
+        mode = HUGE_PAGES_OFF;
+    } else if (std::strcmp(name, "thp") == 0) {
+        mode = HUGE_PAGES_TRANSPARENT;
+    } else if (std::strcmp(name, "hugetlb") == 0) {
+        mode = HUGE_PAGES_EXPLICIT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Returns the name of a mode
+const char* LargePageBuffer::modeName(HugePageMode mode) {
+    switch (mode) {
+        case HUGE_PAGES_TRANSPARENT: return "thp";
+        case HUGE_PAGES_EXPLICIT: return "hugetlb";
+        default: return "off";
+    }
+}
+
+// Describes the pages behind a buffer
+const char* LargePageBuffer::describeBacking(HugePageMode pages) {
+    switch (pages) {
+        case HUGE_PAGES_TRANSPARENT: return "transparent huge pages";
+        case HUGE_PAGES_EXPLICIT: return "hugetlb pages";
+        default: return "normal pages";
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * LatencyHistogram.cpp
+ *
+ * Implementation of the HDR-style latency histogram declared in
+ * LatencyHistogram.h.
+ */
+
+#include "../include/LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+// Constructor - empty histogram
+LatencyHistogram::LatencyHistogram() : counts(new Counts) {
+    reset();
+}
+
+// Bucket of a value: linear below 2 * SUB_BUCKETS, then SUB_BUCKETS per power of two
+int LatencyHistogram::bucketOf(uint64_t nanos) {
+    if (nanos >= (1ull << MAX_BITS)) {
+        return NUM_BUCKETS - 1;
+    }
+    if (nanos < 2 * SUB_BUCKETS) {
+        return static_cast<int>(nanos);
+    }
+    int shift = (63 - __builtin_clzll(nanos)) - SUB_BUCKET_BITS;
+    return shift * SUB_BUCKETS + static_cast<int>(nanos >> shift);
+}
+
+// Largest value that falls into a bucket
+uint64_t LatencyHistogram::highestInBucket(int bucket) {
+    if (bucket < 2 * SUB_BUCKETS) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t mantissa = static_cast<uint64_t>(bucket - shift * SUB_BUCKETS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+// Records one latency (single writer: a plain load and store is enough)
+void LatencyHistogram::record(uint64_t nanos) {
+    std::atomic<uint64_t>& bucket = counts->buckets[bucketOf(nanos)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    counts->total.store(counts->total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (nanos > counts->max.load(std::memory_order_relaxed)) {
+        counts->max.store(nanos, std::memory_order_relaxed);
+    }
+}
+
+// Adds another histogram's counts to this one
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    uint64_t added = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        uint64_t value = other.counts->buckets[i].load(std::memory_order_relaxed);
+        if (value != 0) {
+            counts->buckets[i].store(counts->buckets[i].load(std::memory_order_relaxed) + value,
+                                     std::memory_order_relaxed);
+            added += value;
+        }
+    }
+
+    // The total is derived from the buckets read, so percentiles stay consistent
+    counts->total.store(count() + added, std::memory_order_relaxed);
+    counts->max.store(std::max(maxValue(), other.maxValue()), std::memory_order_relaxed);
+}
+
+// Clears all counts
+void LatencyHistogram::reset() {
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        counts->buckets[i].store(0, std::memory_order_relaxed);
+    }
+    counts->total.store(0, std::memory_order_relaxed);
+    counts->max.store(0, std::memory_order_relaxed);
+}
+
+// Value below which the given percentage of recorded values lie
+uint64_t LatencyHistogram::valueAtPercentile(double percent) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percent / 100.0 * total));
+    rank = std::min(std::max<uint64_t>(rank, 1), total);
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        seen += counts->buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(highestInBucket(i), maxValue());
+        }
+    }
+    return maxValue();
+}
+
+// Formats p50, p90, p99, p99.9 and max in microseconds
+std::string LatencyHistogram::summary() const {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1) << "p50 " << valueAtPercentile(50.0) / 1000.0 << " us, p90 "
+         << valueAtPercentile(90.0) / 1000.0 << " us, p99 " << valueAtPercentile(99.0) / 1000.0 << " us, p99.9 "
+         << valueAtPercentile(99.9) / 1000.0 << " us, max " << maxValue() / 1000.0 << " us";
+    return text.str();
+}
@@ -0,0 +1,308 @@
+/**
+ * LoadBench.cpp
+ *
+ * Load-test client for the scoring server (./sentiment serve). Offers SCORE
+ * requests at a fixed rate for a few seconds, then at a higher rate, and
+ * so on past the server's capacity, and prints for every step the
+ * throughput achieved, the share of requests refused (UNAVAILABLE, with
+ * --shed) and the latency percentiles.
+ *
+ * Load is open-loop: every connection sends on a schedule no matter how
+ * fast replies come back, and latency is measured from the time a request
+ * was due to be sent, not the time it was written. A server that pushes
+ * back (stops reading) therefore shows its queueing delay in the
+ * percentiles instead of hiding it by slowing the client down.
+ *
+ * Usage: ./loadbench <tweets.csv> [port] [connections] [start_rate] [max_rate] [step_seconds]
+ * (defaults: port 7878, 16 connections, 2000 to 256000 requests/s, 2 s per step;
+ * the rate grows by half each step, and the ramp ends two steps after the
+ * server first falls clearly behind)
+ */
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Longest wait for outstanding replies after a step
+static const int DRAIN_SECONDS = 10;
+
+/**
+ * State of one connection during one step
+ */
+struct LoadConnection {
+    int socket;
+    std::mutex lock;
+    std::deque<Clock::time_point> due;      // Due times of requests awaiting replies, in order
+    std::atomic<long long> sent;
+    std::atomic<bool> sending;
+    long long ok;
+    long long unavailable;
+    long long errors;
+    std::vector<double> latencies;          // Seconds, of answered requests
+    Clock::time_point lastReply;
+
+    LoadConnection() : socket(-1), sent(0), sending(true), ok(0), unavailable(0), errors(0) {}
+};
+
+// Helper function: the tweet column of every data row (text after the fourth comma)
+std::vector<std::string> readTweets(const char* path) {
+    std::ifstream file(path);
+    std::vector<std::string> tweets;
+    std::string line;
+    std::getline(file, line);   // Header
+    while (std::getline(file, line)) {
+        size_t position = 0;
+        for (int comma = 0; comma < 4 && position != std::string::npos; comma++) {
+            position = line.find(',', position);
+            if (position != std::string::npos) {
+                position++;
+            }
+        }
+        if (position == std::string::npos) {
+            continue;
+        }
+        std::string text = line.substr(position);
+        if (!text.empty() && text.back() == '\r') {
+            text.pop_back();
+        }
+        tweets.push_back("SCORE " + text + "\n");
+    }
+    return tweets;
+}
+
+// Helper function: connects to the server on the loopback interface, -1 on failure
+int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+// Helper function: sends requests on schedule until the step ends
+void sendLoop(LoadConnection& connection, const std::vector<std::string>& tweets, size_t firstTweet,
+              double rate, Clock::time_point start, Clock::time_point end) {
+    std::chrono::duration<double> interval(1.0 / rate);
+    std::string out;
+    long long next = 0;
+    while (true) {
+        Clock::time_point now = Clock::now();
+        if (now >= end) {
+            break;
+        }
+
+        // Everything that is due goes out in one write
+        out.clear();
+        {
+            std::lock_guard<std::mutex> guard(connection.lock);
+            while (true) {
+                Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(interval * next);
+                if (due > now || due >= end) {
+                    break;
+                }
+                connection.due.push_back(due);
+                out += tweets[(firstTweet + next) % tweets.size()];
+                next++;
+            }
+        }
+        size_t written = 0;
+        while (written < out.size()) {
+            ssize_t result = send(connection.socket, out.data() + written, out.size() - written, MSG_NOSIGNAL);
+            if (result <= 0) {
+                connection.sending.store(false);
+                shutdown(connection.socket, SHUT_WR);
+                return;
+            }
+            written += static_cast<size_t>(result);
+        }
+        connection.sent.store(next);
+
+        Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(interval * next);
+        std::this_thread::sleep_until(std::min(due, end));
+    }
+    // The server answers what it has read, then sees EOF and closes, which
+    // ends the receive loop as soon as the last reply is in
+    connection.sending.store(false);
+    shutdown(connection.socket, SHUT_WR);
+}
+
+// Helper function: reads replies until every sent request is answered
+void receiveLoop(LoadConnection& connection) {
+    std::string pending;
+    char buffer[65536];
+    long long answered = 0;
+    while (connection.sending.load() || answered < connection.sent.load()) {
+        ssize_t received = recv(connection.socket, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break;
+        }
+        Clock::time_point now = Clock::now();
+        pending.append(buffer, static_cast<size_t>(received));
+        size_t lineStart = 0;
+        size_t newline;
+        while ((newline = pending.find('\n', lineStart)) != std::string::npos) {
+            Clock::time_point due;
+            bool expected;
+            {
+                std::lock_guard<std::mutex> guard(connection.lock);
+                expected = !connection.due.empty();
+                if (expected) {
+                    due = connection.due.front();
+                    connection.due.pop_front();
+                }
+            }
+            if (!expected) {
+                connection.errors++;
+            } else if (pending.compare(lineStart, 2, "OK") == 0) {
+                connection.ok++;
+                connection.latencies.push_back(std::chrono::duration<double>(now - due).count());
+            } else if (pending.compare(lineStart, 11, "UNAVAILABLE") == 0) {
+                connection.unavailable++;
+            } else {
+                connection.errors++;
+            }
+            answered++;
+            lineStart = newline + 1;
+        }
+        pending.erase(0, lineStart);
+        connection.lastReply = now;
+    }
+}
+
+// Helper function: latency percentile of sorted samples, in milliseconds
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[rank] * 1000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: ./loadbench <tweets.csv> [port] [connections] [start_rate] [max_rate] [step_seconds]"
+                  << std::endl;
+        return 1;
+    }
+    std::vector<std::string> tweets = readTweets(argv[1]);
+    int port = (argc > 2) ? std::atoi(argv[2]) : 7878;
+    int numConnections = (argc > 3) ? std::atoi(argv[3]) : 16;
+    double rate = (argc > 4) ? std::atof(argv[4]) : 2000.0;
+    double maxRate = (argc > 5) ? std::atof(argv[5]) : 256000.0;
+    double stepSeconds = (argc > 6) ? std::atof(argv[6]) : 2.0;
+    if (tweets.empty() || numConnections < 1 || rate <= 0.0 || stepSeconds <= 0.0) {
+        std::cerr << "Error: need tweets, at least one connection and positive rates" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Load test: " << numConnections << " connections to port " << port << ", " << stepSeconds
+              << " s per step, " << tweets.size() << " distinct tweets" << std::endl;
+    std::cout << "   offered/s   achieved/s  refused      p50 ms      p99 ms    p99.9 ms      max ms" << std::endl;
+
+    int stepsPastCapacity = 0;
+    size_t firstTweet = 0;
+    for (; rate <= maxRate && stepsPastCapacity < 2; rate *= 1.5) {
+        std::vector<LoadConnection> connections(numConnections);
+        for (LoadConnection& connection : connections) {
+            connection.socket = connectTo(port);
+            if (connection.socket < 0) {
+                std::cerr << "Error: Could not connect to port " << port << std::endl;
+                return 1;
+            }
+        }
+
+        // Connections start a fraction of an interval apart so sends interleave
+        Clock::time_point start = Clock::now() + std::chrono::milliseconds(20);
+        Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(stepSeconds));
+        double connectionRate = rate / numConnections;
+        std::vector<std::thread> threads;
+        for (int c = 0; c < numConnections; c++) {
+            Clock::time_point offset = start + std::chrono::duration_cast<Clock::duration>(
+                                                   std::chrono::duration<double>(c / rate));
+            threads.push_back(std::thread(sendLoop, std::ref(connections[c]), std::cref(tweets),
+                                          firstTweet + c * 997, connectionRate, offset, end));
+            threads.push_back(std::thread(receiveLoop, std::ref(connections[c])));
+        }
+
+        // Stop waiting for replies that are far too late
+        std::atomic<bool> finished(false);
+        std::thread watchdog([&]() {
+            Clock::time_point deadline = end + std::chrono::seconds(DRAIN_SECONDS);
+            while (!finished.load() && Clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            for (LoadConnection& connection : connections) {
+                shutdown(connection.socket, SHUT_RDWR);
+            }
+        });
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        finished.store(true);
+        watchdog.join();
+
+        long long ok = 0;
+        long long unavailable = 0;
+        long long sent = 0;
+        long long errors = 0;
+        Clock::time_point lastReply = end;
+        std::vector<double> latencies;
+        for (LoadConnection& connection : connections) {
+            ok += connection.ok;
+            unavailable += connection.unavailable;
+            errors += connection.errors;
+            sent += connection.sent.load();
+            lastReply = std::max(lastReply, connection.lastReply);
+            latencies.insert(latencies.end(), connection.latencies.begin(), connection.latencies.end());
+            close(connection.socket);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        long long lost = sent - ok - unavailable - errors;
+
+        // Throughput over the time it took to answer the step's requests
+        double seconds = std::chrono::duration<double>(lastReply - start).count();
+        double achieved = (seconds > 0.0) ? ok / seconds : 0.0;
+        double refused = (sent > 0) ? 100.0 * (unavailable + lost) / sent : 0.0;
+        std::cout << std::fixed << std::setprecision(0) << std::setw(12) << rate << std::setw(13) << achieved
+                  << std::setprecision(1) << std::setw(8) << refused << "%" << std::setprecision(2)
+                  << std::setw(12) << percentile(latencies, 0.50) << std::setw(12) << percentile(latencies, 0.99)
+                  << std::setw(12) << percentile(latencies, 0.999)
+                  << std::setw(12) << (latencies.empty() ? 0.0 : latencies.back() * 1000.0);
+        if (errors > 0 || lost > 0) {
+            std::cout << "  (" << errors << " errors, " << lost << " unanswered)";
+        }
+        std::cout << std::endl;
+
+        // Behind: answered requests fell short of the offered load, or were refused
+        if (achieved < 0.9 * rate || refused > 1.0) {
+            stepsPastCapacity++;
+        }
+        firstTweet += static_cast<size_t>(sent);
+    }
+    return 0;
+}
@@ -0,0 +1,218 @@
+/**
+ * MicroBatcher.cpp
+ *
+ * Implementation of the adaptive request batching declared in
+ * MicroBatcher.h.
+ */
+
+#include "../include/MicroBatcher.h"
+#include <algorithm>
+#include <cmath>
+
+// Defined here as well: std::chrono binds it by reference
+const int MicroBatcher::TUNE_WINDOW_MS;
+
+// Latency samples kept per tuning window
+static const size_t MAX_SAMPLES = 8192;
+
+// Smallest step when raising the delay
+static const int DELAY_STEP_MICROS = 10;
+
+// Blocks until every request of the group has completed
+void RequestGroup::wait() {
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this] { return remaining == 0; });
+}
+
+// Constructor - starts at the largest delay and a target of one request
+MicroBatcher::MicroBatcher(size_t maxBatchSize, int maxDelay, int latencyTarget, size_t maxQueued,
+                           size_t maxClientQueued)
+    : maxBatch(std::max<size_t>(maxBatchSize, 1)), maxDelayMicros(std::max(maxDelay, 0)),
+      latencyTargetMicros(std::max(latencyTarget, 1)), queueLimit(std::max<size_t>(maxQueued, 1)),
+      clientLimit(std::max<size_t>(maxClientQueued, 1)), queued(0), stopping(false), targetBatch(1),
+      delayMicros(maxDelayMicros), windowStart(std::chrono::steady_clock::now()), windowArrivals(0), requests(0),
+      batches(0), shed(0), blocked(0), arrivalRate(0.0), p99Micros(0) {
+    windowLatencies.reserve(MAX_SAMPLES);
+}
+
+// Queues a client's requests
+size_t MicroBatcher::submit(ClientQueue& client, ScoreRequest* const* submitted, size_t count, bool shedding) {
+    size_t accepted = 0;
+    std::unique_lock<std::mutex> guard(lock);
+    while (accepted < count && !stopping) {
+        size_t room = std::min(queueLimit - std::min(queued, queueLimit),
+                               clientLimit - std::min(client.requests.size(), clientLimit));
+        if (room == 0) {
+            if (shedding) {
+                break;
+            }
+            blocked++;
+            spaceFreed.wait(guard);
+            continue;
+        }
+
+        size_t take = std::min(room, count - accepted);
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < take; i++) {
+            submitted[accepted + i]->arrival = now;
+            client.requests.push_back(submitted[accepted + i]);
+        }
+        if (!client.scheduled) {
+            client.scheduled = true;
+            clients.push_back(&client);
+        }
+        queued += take;
+        accepted += take;
+        windowArrivals += static_cast<long long>(take);
+        if (take > 1) {
+            arrived.notify_all();
+        } else {
+            arrived.notify_one();
+        }
+    }
+    shed += static_cast<long long>(count - accepted);
+    return accepted;
+}
+
+// Arrival time of the oldest waiting request
+std::chrono::steady_clock::time_point MicroBatcher::oldestArrival() const {
+    std::chrono::steady_clock::time_point oldest = clients.front()->requests.front()->arrival;
+    for (const ClientQueue* client : clients) {
+        oldest = std::min(oldest, client->requests.front()->arrival);
+    }
+    return oldest;
+}
+
+// Waits for the next batch
+bool MicroBatcher::takeBatch(std::vector<ScoreRequest*>& batch) {
+    batch.clear();
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        if (queued == 0) {
+            if (stopping) {
+                return false;
+            }
+            arrived.wait(guard);
+            continue;
+        }
+
+        // Dispatch when the batch is full enough or the oldest request is due
+        auto due = oldestArrival() + std::chrono::microseconds(delayMicros);
+        if (queued >= targetBatch || stopping || std::chrono::steady_clock::now() >= due) {
+            break;
+        }
+        arrived.wait_until(guard, due);
+    }
+
+    // One request per client in turn
+    size_t size = std::min(queued, maxBatch);
+    while (batch.size() < size) {
+        ClientQueue* client = clients.front();
+        clients.pop_front();
+        batch.push_back(client->requests.front());
+        client->requests.pop_front();
+        if (client->requests.empty()) {
+            client->scheduled = false;
+        } else {
+            clients.push_back(client);
+        }
+    }
+    queued -= size;
+    bool more = (queued > 0);
+    guard.unlock();
+    spaceFreed.notify_all();
+    if (more) {
+        arrived.notify_one();       // Another thread can start on the rest
+    }
+    return true;
+}
+
+// Completes a scored batch
+void MicroBatcher::complete(const std::vector<ScoreRequest*>& batch) {
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (const ScoreRequest* request : batch) {
+            if (windowLatencies.size() < MAX_SAMPLES) {
+                windowLatencies.push_back(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - request->arrival).count());
+            }
+        }
+        requests += static_cast<long long>(batch.size());
+        batches++;
+        if (now - windowStart >= std::chrono::milliseconds(TUNE_WINDOW_MS)) {
+            retune(now);
+        }
+    }
+
+    // Wake the submitters once their last request is done; a woken
+    // submitter may destroy its group, so it is not touched afterwards
+    for (ScoreRequest* request : batch) {
+        RequestGroup* group = request->group;
+        std::unique_lock<std::mutex> guard(group->lock);
+        if (--group->remaining != 0) {
+            continue;
+        }
+        if (group->onComplete == nullptr) {
+            group->done.notify_all();
+            continue;
+        }
+        void (*onComplete)(void*) = group->onComplete;
+        void* context = group->context;
+        guard.unlock();
+        onComplete(context);
+    }
+}
+
+// Adapts the delay and the batch target at the end of a window
+void MicroBatcher::retune(std::chrono::steady_clock::time_point now) {
+    double seconds = std::chrono::duration<double>(now - windowStart).count();
+    arrivalRate = windowArrivals / seconds;
+    if (!windowLatencies.empty()) {
+        size_t rank = (windowLatencies.size() * 99) / 100;
+        std::nth_element(windowLatencies.begin(), windowLatencies.begin() + rank, windowLatencies.end());
+        p99Micros = windowLatencies[rank];
+
+        // Back off quickly when over the target, creep up while well under it
+        if (p99Micros > latencyTargetMicros) {
+            delayMicros /= 2;
+        } else if (p99Micros < latencyTargetMicros / 2) {
+            delayMicros = std::min(maxDelayMicros, delayMicros + std::max(delayMicros / 4, DELAY_STEP_MICROS));
+        }
+    }
+
+    // Requests expected within one delay: waiting longer than that cannot fill a batch
+    double expected = arrivalRate * delayMicros / 1e6;
+    targetBatch = static_cast<size_t>(std::min(static_cast<double>(maxBatch), std::max(1.0, std::floor(expected))));
+
+    windowStart = now;
+    windowArrivals = 0;
+    windowLatencies.clear();
+}
+
+// Lets takeBatch() return false once the queue is drained
+void MicroBatcher::stop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    arrived.notify_all();
+    spaceFreed.notify_all();
+}
+
+// Current batching policy and counters
+BatcherStats MicroBatcher::stats() {
+    std::lock_guard<std::mutex> guard(lock);
+    BatcherStats current;
+    current.requests = requests;
+    current.batches = batches;
+    current.queued = queued;
+    current.queueLimit = queueLimit;
+    current.shed = shed;
+    current.blocked = blocked;
+    current.targetBatch = targetBatch;
+    current.delayMicros = delayMicros;
+    current.arrivalRate = arrivalRate;
+    current.p99Micros = p99Micros;
+    return current;
+}
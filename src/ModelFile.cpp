@@ -0,0 +1,322 @@
+/**
+ * ModelFile.cpp
+ *
+ * Implementation of the binary model reader, writer and k-way merge
+ * declared in ModelFile.h.
+ */
+
+#include "../include/ModelFile.h"
+#include <cstdio>   // For std::remove
+#include <iostream>
+#include <memory>
+#include <queue>
+
+static_assert(sizeof(std::pair<int, int>) == 2 * sizeof(int32_t),
+              "subword counts are written as raw int32 pairs");
+
+// Largest word accepted when reading, to reject corrupt length fields
+static const uint32_t MAX_WORD_BYTES = 1 << 20;
+
+// Largest subword table accepted when reading (2^26 buckets = 512 MB)
+static const uint32_t MAX_BUCKET_BITS = 26;
+
+// Constructor - an empty model
+ModelHeader::ModelHeader()
+    : version(MODEL_FORMAT_VERSION), flags(0), reserved(0),
+      totalPositive(0), totalNegative(0), numWords(0) {
+    magic[0] = 'S';
+    magic[1] = 'N';
+    magic[2] = 'T';
+    magic[3] = 'M';
+}
+
+//=== ModelWriter ===//
+
+ModelWriter::ModelWriter() {
+}
+
+// Creates the file and writes a provisional header
+bool ModelWriter::open(const DSString& path, const ModelHeader& header) {
+    this->path = path;
+    this->header = header;
+    this->header.numWords = 0;
+    out.open(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error creating model file: " << path << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&this->header), sizeof(this->header));
+    return true;
+}
+
+// Appends one word record
+void ModelWriter::writeWord(const DSString& word, int positive, int negative) {
+    uint32_t length = static_cast<uint32_t>(word.size());
+    int32_t counts[2] = {positive, negative};
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+    out.write(word.c_str(), length);
+    header.numWords++;
+}
+
+// Appends the subword section
+void ModelWriter::writeSubword(unsigned int bucketBits, int minN, int maxN,
+                               const std::vector<std::pair<int, int>>& counts) {
+    uint32_t bits = bucketBits;
+    int32_t range[2] = {minN, maxN};
+    out.write(reinterpret_cast<const char*>(&bits), sizeof(bits));
+    out.write(reinterpret_cast<const char*>(range), sizeof(range));
+
+    // Untrained features have no buckets allocated: write zeros
+    size_t numBuckets = static_cast<size_t>(1) << bucketBits;
+    if (counts.size() == numBuckets) {
+        out.write(reinterpret_cast<const char*>(counts.data()), numBuckets * sizeof(counts[0]));
+    } else {
+        std::vector<std::pair<int, int>> zeros(numBuckets, std::make_pair(0, 0));
+        out.write(reinterpret_cast<const char*>(zeros.data()), numBuckets * sizeof(zeros[0]));
+    }
+}
+
+// Rewrites the header with the final word count and closes the file
+bool ModelWriter::close() {
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    bool ok = out.good();
+    out.close();
+    if (!ok) {
+        std::cerr << "Error writing model file: " << path << std::endl;
+    }
+    return ok;
+}
+
+// Closes and deletes a partly written file
+void ModelWriter::discard() {
+    if (out.is_open()) {
+        out.close();
+    }
+    std::remove(path.c_str());
+}
+
+//=== ModelReader ===//
+
+ModelReader::ModelReader() : wordsRead(0), failed(false) {
+}
+
+// Opens a model file and validates its header
+bool ModelReader::open(const DSString& path) {
+    this->path = path;
+    wordsRead = 0;
+    failed = false;
+    in.open(path.c_str(), std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Error opening model file: " << path << std::endl;
+        failed = true;
+        return false;
+    }
+
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    ModelHeader expected;
+    if (!in || header.magic[0] != expected.magic[0] || header.magic[1] != expected.magic[1] ||
+        header.magic[2] != expected.magic[2] || header.magic[3] != expected.magic[3]) {
+        std::cerr << "Error: " << path << " is not a model file" << std::endl;
+        failed = true;
+        return false;
+    }
+    if (header.version != MODEL_FORMAT_VERSION) {
+        std::cerr << "Error: " << path << " has unsupported model version " << header.version << std::endl;
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+// Reads the next word record
+bool ModelReader::nextWord(DSString& word, int& positive, int& negative) {
+    if (failed || wordsRead == header.numWords) {
+        return false;
+    }
+
+    uint32_t length;
+    int32_t counts[2];
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    in.read(reinterpret_cast<char*>(counts), sizeof(counts));
+    if (!in || length > MAX_WORD_BYTES) {
+        std::cerr << "Error: model file " << path << " is truncated or corrupt" << std::endl;
+        failed = true;
+        return false;
+    }
+    buffer.resize(length + 1);
+    in.read(buffer.data(), length);
+    if (!in) {
+        std::cerr << "Error: model file " << path << " is truncated or corrupt" << std::endl;
+        failed = true;
+        return false;
+    }
+
+    word = DSString(buffer.data(), static_cast<int>(length));
+    positive = counts[0];
+    negative = counts[1];
+    wordsRead++;
+    return true;
+}
+
+// Reads the subword section
+bool ModelReader::readSubword(unsigned int& bucketBits, int& minN, int& maxN,
+                              std::vector<std::pair<int, int>>& counts) {
+    uint32_t bits = 0;
+    int32_t range[2];
+    in.read(reinterpret_cast<char*>(&bits), sizeof(bits));
+    in.read(reinterpret_cast<char*>(range), sizeof(range));
+    if (!in || bits == 0 || bits > MAX_BUCKET_BITS) {
+        std::cerr << "Error: model file " << path << " has no valid subword section" << std::endl;
+        failed = true;
+        return false;
+    }
+
+    size_t numBuckets = static_cast<size_t>(1) << bits;
+    counts.resize(numBuckets);
+    in.read(reinterpret_cast<char*>(counts.data()), numBuckets * sizeof(counts[0]));
+    if (!in) {
+        std::cerr << "Error: model file " << path << " is truncated or corrupt" << std::endl;
+        failed = true;
+        return false;
+    }
+    bucketBits = bits;
+    minN = range[0];
+    maxN = range[1];
+    return true;
+}
+
+//=== k-way merge ===//
+
+/**
+ * Helper struct: the current word of one input in the merge heap
+ */
+struct MergeEntry {
+    DSString word;
+    int positive;
+    int negative;
+    size_t input;
+
+    // Inverted so std::priority_queue yields the smallest word first
+    bool operator<(const MergeEntry& other) const {
+        return other.word < word;
+    }
+};
+
+// Merges partial models into one by summing the counts of equal words
+bool mergeModelFiles(const std::vector<DSString>& inputs, const DSString& output) {
+    if (inputs.empty()) {
+        std::cerr << "Error: no models to merge" << std::endl;
+        return false;
+    }
+
+    // Open every input and check that they were trained the same way
+    std::vector<std::unique_ptr<ModelReader>> readers;
+    ModelHeader merged;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        readers.emplace_back(new ModelReader());
+        if (!readers[i]->open(inputs[i])) {
+            return false;
+        }
+        const ModelHeader& header = readers[i]->getHeader();
+        if (i == 0) {
+            merged.flags = header.flags;
+        } else if (header.flags != merged.flags) {
+            std::cerr << "Error: " << inputs[i] << " was trained with different tokenizer settings than "
+                      << inputs[0] << std::endl;
+            return false;
+        }
+        merged.totalPositive += header.totalPositive;
+        merged.totalNegative += header.totalNegative;
+    }
+
+    ModelWriter writer;
+    if (!writer.open(output, merged)) {
+        return false;
+    }
+
+    // Prime the heap with the first word of every input
+    std::priority_queue<MergeEntry> heap;
+    for (size_t i = 0; i < readers.size(); i++) {
+        MergeEntry entry;
+        entry.input = i;
+        if (readers[i]->nextWord(entry.word, entry.positive, entry.negative)) {
+            heap.push(entry);
+        }
+    }
+
+    // Pop words in order, summing runs of equal words across inputs
+    while (!heap.empty()) {
+        MergeEntry smallest = heap.top();
+        heap.pop();
+        DSString word = smallest.word;
+        int positive = 0;
+        int negative = 0;
+
+        while (true) {
+            positive += smallest.positive;
+            negative += smallest.negative;
+            MergeEntry next;
+            next.input = smallest.input;
+            if (readers[next.input]->nextWord(next.word, next.positive, next.negative)) {
+                heap.push(next);
+            }
+            if (heap.empty() || !(heap.top().word == word)) {
+                break;
+            }
+            smallest = heap.top();
+            heap.pop();
+        }
+        writer.writeWord(word, positive, negative);
+    }
+
+    for (size_t i = 0; i < readers.size(); i++) {
+        if (readers[i]->hasError()) {
+            writer.discard();
+            return false;
+        }
+    }
+
+    // Subword buckets are summed element by element
+    if (merged.flags & MODEL_SUBWORD) {
+        unsigned int bucketBits = 0;
+        int minN = 0;
+        int maxN = 0;
+        std::vector<std::pair<int, int>> total;
+        for (size_t i = 0; i < readers.size(); i++) {
+            unsigned int bits;
+            int lo;
+            int hi;
+            std::vector<std::pair<int, int>> counts;
+            if (!readers[i]->readSubword(bits, lo, hi, counts)) {
+                writer.discard();
+                return false;
+            }
+            if (i == 0) {
+                bucketBits = bits;
+                minN = lo;
+                maxN = hi;
+                total.swap(counts);
+                continue;
+            }
+            if (bits != bucketBits || lo != minN || hi != maxN) {
+                std::cerr << "Error: " << inputs[i] << " uses different subword parameters than "
+                          << inputs[0] << std::endl;
+                writer.discard();
+                return false;
+            }
+            for (size_t b = 0; b < total.size(); b++) {
+                total[b].first += counts[b].first;
+                total[b].second += counts[b].second;
+            }
+        }
+        writer.writeSubword(bucketBits, minN, maxN, total);
+    }
+
+    if (!writer.close()) {
+        writer.discard();
+        return false;
+    }
+    return true;
+}
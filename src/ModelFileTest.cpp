@@ -0,0 +1,230 @@
+/**
+ * ModelFileTest.cpp
+ *
+ * A simple test program for the model file format and the k-way merge.
+ * Round-trips a model through ModelWriter and ModelReader, merges
+ * overlapping partial models, and checks that a model trained on two
+ * shards and merged is byte-identical to one trained in one process.
+ */
+
+#include "../include/ModelFile.h"
+#include "../include/InputSet.h"
+#include "../include/SentimentClassifier.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Helper function to check if an assertion passed
+void testPassed(const char* testName) {
+    std::cout << "✓ " << testName << " passed" << std::endl;
+}
+
+// One word record of a test model
+struct WordCounts {
+    const char* word;
+    int positive;
+    int negative;
+};
+
+// Helper function: a fresh temporary file name
+std::string temporaryPath() {
+    char path[] = "/tmp/modelfiletestXXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    return path;
+}
+
+// Helper function: writes a model with the given words (already sorted)
+void writeModel(const std::string& path, uint32_t flags, long long positive, long long negative,
+                const std::vector<WordCounts>& words, const std::vector<std::pair<int, int>>& buckets) {
+    ModelHeader header;
+    header.flags = flags;
+    header.totalPositive = positive;
+    header.totalNegative = negative;
+    ModelWriter writer;
+    bool opened = writer.open(DSString(path.c_str()), header);
+    assert(opened);
+    for (const WordCounts& entry : words) {
+        writer.writeWord(DSString(entry.word), entry.positive, entry.negative);
+    }
+    if (flags & MODEL_SUBWORD) {
+        writer.writeSubword(2, 3, 5, buckets);
+    }
+    bool closed = writer.close();
+    assert(closed);
+}
+
+// Helper function: reads every word record of a model
+std::vector<std::pair<std::string, std::pair<int, int>>> readWords(ModelReader& reader) {
+    std::vector<std::pair<std::string, std::pair<int, int>>> words;
+    DSString word;
+    int positive;
+    int negative;
+    while (reader.nextWord(word, positive, negative)) {
+        words.push_back(std::make_pair(std::string(word.c_str(), word.size()), std::make_pair(positive, negative)));
+    }
+    assert(!reader.hasError());
+    return words;
+}
+
+// Helper function: whole contents of a file
+std::string fileBytes(const std::string& path) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Helper function: true if the path exists
+bool fileExists(const std::string& path) {
+    return access(path.c_str(), F_OK) == 0;
+}
+
+int main() {
+    std::cout << "Running ModelFile tests..." << std::endl;
+
+    std::vector<std::pair<int, int>> bucketsA = {{1, 0}, {0, 2}, {3, 3}, {0, 0}};
+    std::vector<std::pair<int, int>> bucketsB = {{5, 1}, {0, 0}, {1, 1}, {2, 0}};
+
+    // Test 1: A model survives a round trip through the writer and reader
+    {
+        std::string path = temporaryPath();
+        writeModel(path, MODEL_STEMMED | MODEL_SUBWORD, 7, 9,
+                   {{"apple", 1, 2}, {"cat", 3, 0}, {"zebra", 0, 1}}, bucketsA);
+        ModelReader reader;
+        bool opened = reader.open(DSString(path.c_str()));
+        assert(opened);
+        assert(reader.getHeader().flags == (MODEL_STEMMED | MODEL_SUBWORD));
+        assert(reader.getHeader().totalPositive == 7 && reader.getHeader().totalNegative == 9);
+        assert(reader.getHeader().numWords == 3);
+        auto words = readWords(reader);
+        assert(words.size() == 3);
+        assert(words[0].first == "apple" && words[0].second == std::make_pair(1, 2));
+        assert(words[1].first == "cat" && words[1].second == std::make_pair(3, 0));
+        assert(words[2].first == "zebra" && words[2].second == std::make_pair(0, 1));
+        unsigned int bits;
+        int minN;
+        int maxN;
+        std::vector<std::pair<int, int>> buckets;
+        bool subword = reader.readSubword(bits, minN, maxN, buckets);
+        assert(subword && bits == 2 && minN == 3 && maxN == 5 && buckets == bucketsA);
+        std::remove(path.c_str());
+        testPassed("Round trip");
+    }
+
+    // Test 2: Overlapping partial models merge into sorted, summed counts
+    {
+        std::string a = temporaryPath();
+        std::string b = temporaryPath();
+        std::string c = temporaryPath();
+        std::string merged = temporaryPath();
+        writeModel(a, MODEL_SUBWORD, 3, 2, {{"apple", 1, 2}, {"cat", 3, 0}, {"zebra", 0, 1}}, bucketsA);
+        writeModel(b, MODEL_SUBWORD, 1, 4, {{"banana", 2, 0}, {"cat", 1, 1}, {"zebra", 2, 2}}, bucketsB);
+        writeModel(c, MODEL_SUBWORD, 0, 1, {{"apple", 0, 5}, {"dog", 4, 4}}, bucketsA);
+        bool ok = mergeModelFiles({DSString(a.c_str()), DSString(b.c_str()), DSString(c.c_str())},
+                                  DSString(merged.c_str()));
+        assert(ok);
+
+        ModelReader reader;
+        bool opened = reader.open(DSString(merged.c_str()));
+        assert(opened);
+        assert(reader.getHeader().totalPositive == 4 && reader.getHeader().totalNegative == 7);
+        auto words = readWords(reader);
+        std::vector<std::pair<std::string, std::pair<int, int>>> expected = {
+            {"apple", {1, 7}}, {"banana", {2, 0}}, {"cat", {4, 1}}, {"dog", {4, 4}}, {"zebra", {2, 3}}};
+        assert(words == expected);
+        assert(reader.getHeader().numWords == expected.size());
+        unsigned int bits;
+        int minN;
+        int maxN;
+        std::vector<std::pair<int, int>> buckets;
+        bool subword = reader.readSubword(bits, minN, maxN, buckets);
+        assert(subword);
+        for (size_t i = 0; i < buckets.size(); i++) {
+            assert(buckets[i].first == 2 * bucketsA[i].first + bucketsB[i].first);
+            assert(buckets[i].second == 2 * bucketsA[i].second + bucketsB[i].second);
+        }
+        std::remove(a.c_str());
+        std::remove(b.c_str());
+        std::remove(c.c_str());
+        std::remove(merged.c_str());
+        testPassed("Merge of overlapping models");
+    }
+
+    // Test 3: A failed merge leaves no output behind
+    {
+        std::string a = temporaryPath();
+        std::string b = temporaryPath();
+        std::string merged = temporaryPath();
+        std::remove(merged.c_str());
+        writeModel(a, 0, 1, 1, {{"apple", 1, 2}, {"cat", 3, 0}}, {});
+        writeModel(b, MODEL_STEMMED, 1, 1, {{"cat", 1, 1}}, {});
+        assert(!mergeModelFiles({DSString(a.c_str()), DSString(b.c_str())}, DSString(merged.c_str())));
+        assert(!fileExists(merged));
+
+        // Truncated input: the merge fails after the output was created
+        writeModel(b, 0, 1, 1, {{"banana", 2, 0}, {"cat", 1, 1}, {"zebra", 2, 2}}, {});
+        std::string bytes = fileBytes(b);
+        std::ofstream(b.c_str(), std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size() - 3);
+        assert(!mergeModelFiles({DSString(a.c_str()), DSString(b.c_str())}, DSString(merged.c_str())));
+        assert(!fileExists(merged));
+        std::remove(a.c_str());
+        std::remove(b.c_str());
+        testPassed("Failed merge cleanup");
+    }
+
+    // Test 4: Two shards merged give the same file as single-process training
+    {
+        std::string training = temporaryPath();
+        {
+            std::ofstream out(training.c_str());
+            out << "Sentiment,id,Date,Query,User,Tweet\n";
+            const char* texts[] = {"i love this great day", "so sad and tired today", "\"great fun, with\nfriends\"",
+                                   "worst traffic ever so bad", "happy happy joy", "terrible rain again"};
+            for (int i = 0; i < 300; i++) {
+                out << ((i % 3 == 0) ? "0," : "4,") << i << ",Mon,NO_QUERY,user" << (i % 7) << ","
+                    << texts[i % 6] << " " << (i % 11) << "x\n";
+            }
+        }
+        std::string single = temporaryPath();
+        std::string shard0 = temporaryPath();
+        std::string shard1 = temporaryPath();
+        std::string merged = temporaryPath();
+
+        SentimentClassifier whole;
+        whole.setNumThreads(2);
+        InputSet inputs;
+        bool ok = inputs.add(DSString(training.c_str())) && whole.train(inputs) &&
+                  whole.saveModel(DSString(single.c_str()));
+        assert(ok);
+
+        std::vector<InputSet> shards;
+        ok = whole.planShards(inputs, 2, shards);
+        assert(ok && shards.size() == 2);
+        std::string shardPaths[2] = {shard0, shard1};
+        for (int s = 0; s < 2; s++) {
+            SentimentClassifier part;
+            part.setNumThreads(2);
+            ok = part.train(shards[s]) && part.saveModel(DSString(shardPaths[s].c_str()));
+            assert(ok);
+        }
+        ok = mergeModelFiles({DSString(shard0.c_str()), DSString(shard1.c_str())}, DSString(merged.c_str()));
+        assert(ok);
+        assert(fileBytes(shard0) != fileBytes(single) && fileBytes(shard1) != fileBytes(single));
+        assert(fileBytes(merged) == fileBytes(single));
+
+        std::remove(training.c_str());
+        std::remove(single.c_str());
+        std::remove(shard0.c_str());
+        std::remove(shard1.c_str());
+        std::remove(merged.c_str());
+        testPassed("Sharded training matches single process");
+    }
+
+    std::cout << "\nAll ModelFile tests passed successfully!" << std::endl;
+    return 0;
+}
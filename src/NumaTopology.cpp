@@ -0,0 +1,165 @@
+/**
+ * NumaTopology.cpp
+ *
+ * Implementation of the sysfs-based NUMA topology declared in
+ * NumaTopology.h.
+ */
+
+#include "../include/NumaTopology.h"
+#include <algorithm>
+#include <cctype>       // For isdigit
+#include <cstdlib>      // For strtol and atoi
+#include <cstring>      // For strcmp and strncmp
+#include <dirent.h>
+#include <fstream>
+#include <string>
+
+// Where the kernel describes NUMA nodes
+static const char* NODE_DIRECTORY = "/sys/devices/system/node";
+
+// Constructor - reads the topology of the calling process's allowed CPUs
+NumaTopology::NumaTopology() {
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &allowed);
+        }
+    }
+
+    // One nodeN directory per node, each listing its CPUs
+    std::vector<int> found;
+    DIR* directory = opendir(NODE_DIRECTORY);
+    if (directory != nullptr) {
+        while (struct dirent* entry = readdir(directory)) {
+            if (std::strncmp(entry->d_name, "node", 4) == 0 && std::isdigit(static_cast<unsigned char>(entry->d_name[4]))) {
+                found.push_back(std::atoi(entry->d_name + 4));
+            }
+        }
+        closedir(directory);
+    }
+    std::sort(found.begin(), found.end());
+
+    for (int id : found) {
+        std::ifstream file(std::string(NODE_DIRECTORY) + "/node" + std::to_string(id) + "/cpulist");
+        std::string text;
+        std::vector<int> nodeList;
+        if (!std::getline(file, text) || !parseCpuList(text.c_str(), nodeList)) {
+            continue;
+        }
+
+        // Keep only the CPUs we may run on; memory-only nodes drop out here
+        std::vector<int> usable;
+        for (int cpu : nodeList) {
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+                usable.push_back(cpu);
+            }
+        }
+        if (!usable.empty()) {
+            nodeIds.push_back(id);
+            cpus.push_back(usable);
+        }
+    }
+
+    // No NUMA information: one node holding every allowed CPU
+    if (nodeIds.empty()) {
+        std::vector<int> all;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                all.push_back(cpu);
+            }
+        }
+        nodeIds.push_back(0);
+        cpus.push_back(all);
+    }
+}
+
+// Node a thread slot is placed on
+int NumaTopology::nodeOfSlot(int slot, int numSlots) const {
+    if (nodeIds.size() == 1 || numSlots <= 0) {
+        return 0;
+    }
+
+    // Give each node a share of the slots proportional to its CPU count
+    size_t totalCpus = 0;
+    for (const std::vector<int>& list : cpus) {
+        totalCpus += list.size();
+    }
+    size_t position = static_cast<size_t>(slot % numSlots) * totalCpus / numSlots;
+    for (size_t node = 0; node < cpus.size(); node++) {
+        if (position < cpus[node].size()) {
+            return static_cast<int>(node);
+        }
+        position -= cpus[node].size();
+    }
+    return numNodes() - 1;
+}
+
+// Restricts the calling thread to the CPUs of one node
+bool NumaTopology::pinCurrentThread(int node) const {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus[node]) {
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+// Gives the calling thread back the process's original CPU set
+void NumaTopology::unpinCurrentThread() const {
+    sched_setaffinity(0, sizeof(allowed), &allowed);
+}
+
+// Parses a sysfs CPU list such as "0-3,8-11"
+bool NumaTopology::parseCpuList(const char* text, std::vector<int>& cpuList) {
+    cpuList.clear();
+    const char* position = text;
+    while (*position != '\0' && *position != '\n') {
+        char* end;
+        long first = std::strtol(position, &end, 10);
+        if (end == position || first < 0) {
+            return false;
+        }
+        long last = first;
+        if (*end == '-') {
+            position = end + 1;
+            last = std::strtol(position, &end, 10);
+            if (end == position || last < first) {
+                return false;
+            }
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpuList.push_back(static_cast<int>(cpu));
+        }
+        if (*end == ',') {
+            position = end + 1;
+        } else if (*end == '\0' || *end == '\n') {
+            position = end;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Parses a mode name
+bool NumaTopology::parseMode(const char* name, NumaMode& mode) {
+    if (std::strcmp(name, "off") == 0) {
+        mode = NUMA_OFF;
+    } else if (std::strcmp(name, "pin") == 0) {
+        mode = NUMA_PIN;
+    } else if (std::strcmp(name, "replicate") == 0) {
+        mode = NUMA_REPLICATE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Returns the name of a mode
+const char* NumaTopology::modeName(NumaMode mode) {
+    switch (mode) {
+        case NUMA_PIN: return "pin";
+        case NUMA_REPLICATE: return "replicate";
+        default: return "off";
+    }
+}
@@ -0,0 +1,419 @@
+/**
+ * PorterStemmer.cpp
+ *
+ * Implementation of the Porter stemming algorithm and the stem cache
+ * declared in PorterStemmer.h.
+ *
+ * The algorithm follows M.F. Porter, "An algorithm for suffix stripping",
+ * Program 14(3), 1980. The word is copied into the output buffer and the
+ * suffix rules shorten it in place, so k always indexes the last character
+ * of the current stem.
+ */
+
+#include "../include/PorterStemmer.h"
+
+/**
+ * Helper function: Length of a null-terminated suffix literal
+ */
+static int suffixLength(const char* s) {
+    int n = 0;
+    while (s[n] != '\0') {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Helper function: FNV-1a hash of a word, never 0 so 0 can mark an empty slot
+ */
+static unsigned int hashWord(const DSStringView& word) {
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < word.size(); i++) {
+        h ^= static_cast<unsigned char>(word[i]);
+        h *= 16777619u;
+    }
+    return h == 0 ? 1 : h;
+}
+
+//=== PorterStemmer ===//
+
+// True if b[i] is a consonant ('y' counts as a consonant after a vowel or at the start)
+bool PorterStemmer::isConsonant(int i) const {
+    switch (b[i]) {
+        case 'a': case 'e': case 'i': case 'o': case 'u':
+            return false;
+        case 'y':
+            return (i == 0) ? true : !isConsonant(i - 1);
+        default:
+            return true;
+    }
+}
+
+// Number of vowel-consonant sequences in b[0..j] (the "m" of the paper)
+int PorterStemmer::measure() const {
+    int n = 0;
+    int i = 0;
+
+    // Skip the optional leading consonants
+    while (true) {
+        if (i > j) return n;
+        if (!isConsonant(i)) break;
+        i++;
+    }
+    i++;
+
+    while (true) {
+        // Skip vowels
+        while (true) {
+            if (i > j) return n;
+            if (isConsonant(i)) break;
+            i++;
+        }
+        i++;
+        n++;
+
+        // Skip consonants
+        while (true) {
+            if (i > j) return n;
+            if (!isConsonant(i)) break;
+            i++;
+        }
+        i++;
+    }
+}
+
+// True if b[0..j] contains a vowel
+bool PorterStemmer::vowelInStem() const {
+    for (int i = 0; i <= j; i++) {
+        if (!isConsonant(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// True if b[i-1..i] is a double consonant
+bool PorterStemmer::doubleConsonant(int i) const {
+    if (i < 1) return false;
+    if (b[i] != b[i - 1]) return false;
+    return isConsonant(i);
+}
+
+// True if b[i-2..i] is consonant-vowel-consonant and the last is not w, x or y
+bool PorterStemmer::consonantVowelConsonant(int i) const {
+    if (i < 2 || !isConsonant(i) || isConsonant(i - 1) || !isConsonant(i - 2)) {
+        return false;
+    }
+    char c = b[i];
+    return !(c == 'w' || c == 'x' || c == 'y');
+}
+
+// True if b[0..k] ends with the suffix; sets j to the index before it
+bool PorterStemmer::ends(const char* suffix) {
+    int length = suffixLength(suffix);
+    if (length > k + 1) return false;
+    if (suffix[length - 1] != b[k]) return false;
+    for (int i = 0; i < length; i++) {
+        if (b[k - length + 1 + i] != suffix[i]) {
+            return false;
+        }
+    }
+    j = k - length;
+    return true;
+}
+
+// Replaces b[j+1..k] with the suffix and adjusts k
+void PorterStemmer::setTo(const char* suffix) {
+    int length = suffixLength(suffix);
+    for (int i = 0; i < length; i++) {
+        b[j + 1 + i] = suffix[i];
+    }
+    k = j + length;
+}
+
+// Replaces the matched suffix only when the remaining stem has m > 0
+void PorterStemmer::replaceIfMeasured(const char* suffix) {
+    if (measure() > 0) {
+        setTo(suffix);
+    }
+}
+
+// Removes plurals and -ed / -ing
+void PorterStemmer::step1ab() {
+    if (b[k] == 's') {
+        if (ends("sses")) {
+            k -= 2;
+        } else if (ends("ies")) {
+            setTo("i");
+        } else if (b[k - 1] != 's') {
+            k--;
+        }
+    }
+    if (ends("eed")) {
+        if (measure() > 0) {
+            k--;
+        }
+    } else if ((ends("ed") || ends("ing")) && vowelInStem()) {
+        k = j;
+        if (ends("at")) {
+            setTo("ate");
+        } else if (ends("bl")) {
+            setTo("ble");
+        } else if (ends("iz")) {
+            setTo("ize");
+        } else if (doubleConsonant(k)) {
+            k--;
+            char c = b[k];
+            if (c == 'l' || c == 's' || c == 'z') {
+                k++;
+            }
+        } else if (measure() == 1 && consonantVowelConsonant(k)) {
+            setTo("e");
+        }
+    }
+}
+
+// Turns a terminal y into i when there is another vowel in the stem
+void PorterStemmer::step1c() {
+    if (ends("y") && vowelInStem()) {
+        b[k] = 'i';
+    }
+}
+
+// Maps double suffixes to single ones (-ization -> -ize, ...)
+void PorterStemmer::step2() {
+    switch (b[k - 1]) {
+        case 'a':
+            if (ends("ational")) { replaceIfMeasured("ate"); break; }
+            if (ends("tional")) { replaceIfMeasured("tion"); break; }
+            break;
+        case 'c':
+            if (ends("enci")) { replaceIfMeasured("ence"); break; }
+            if (ends("anci")) { replaceIfMeasured("ance"); break; }
+            break;
+        case 'e':
+            if (ends("izer")) { replaceIfMeasured("ize"); break; }
+            break;
+        case 'l':
+            if (ends("bli")) { replaceIfMeasured("ble"); break; }
+            if (ends("alli")) { replaceIfMeasured("al"); break; }
+            if (ends("entli")) { replaceIfMeasured("ent"); break; }
+            if (ends("eli")) { replaceIfMeasured("e"); break; }
+            if (ends("ousli")) { replaceIfMeasured("ous"); break; }
+            break;
+        case 'o':
+            if (ends("ization")) { replaceIfMeasured("ize"); break; }
+            if (ends("ation")) { replaceIfMeasured("ate"); break; }
+            if (ends("ator")) { replaceIfMeasured("ate"); break; }
+            break;
+        case 's':
+            if (ends("alism")) { replaceIfMeasured("al"); break; }
+            if (ends("iveness")) { replaceIfMeasured("ive"); break; }
+            if (ends("fulness")) { replaceIfMeasured("ful"); break; }
+            if (ends("ousness")) { replaceIfMeasured("ous"); break; }
+            break;
+        case 't':
+            if (ends("aliti")) { replaceIfMeasured("al"); break; }
+            if (ends("iviti")) { replaceIfMeasured("ive"); break; }
+            if (ends("biliti")) { replaceIfMeasured("ble"); break; }
+            break;
+        case 'g':
+            if (ends("logi")) { replaceIfMeasured("log"); break; }
+            break;
+        default:
+            break;
+    }
+}
+
+// Handles -ic-, -full, -ness etc.
+void PorterStemmer::step3() {
+    switch (b[k]) {
+        case 'e':
+            if (ends("icate")) { replaceIfMeasured("ic"); break; }
+            if (ends("ative")) { replaceIfMeasured(""); break; }
+            if (ends("alize")) { replaceIfMeasured("al"); break; }
+            break;
+        case 'i':
+            if (ends("iciti")) { replaceIfMeasured("ic"); break; }
+            break;
+        case 'l':
+            if (ends("ical")) { replaceIfMeasured("ic"); break; }
+            if (ends("ful")) { replaceIfMeasured(""); break; }
+            break;
+        case 's':
+            if (ends("ness")) { replaceIfMeasured(""); break; }
+            break;
+        default:
+            break;
+    }
+}
+
+// Removes -ant, -ence etc. when the remaining stem has m > 1
+void PorterStemmer::step4() {
+    switch (b[k - 1]) {
+        case 'a':
+            if (ends("al")) break;
+            return;
+        case 'c':
+            if (ends("ance")) break;
+            if (ends("ence")) break;
+            return;
+        case 'e':
+            if (ends("er")) break;
+            return;
+        case 'i':
+            if (ends("ic")) break;
+            return;
+        case 'l':
+            if (ends("able")) break;
+            if (ends("ible")) break;
+            return;
+        case 'n':
+            if (ends("ant")) break;
+            if (ends("ement")) break;
+            if (ends("ment")) break;
+            if (ends("ent")) break;
+            return;
+        case 'o':
+            if (ends("ion") && j >= 0 && (b[j] == 's' || b[j] == 't')) break;
+            if (ends("ou")) break;
+            return;
+        case 's':
+            if (ends("ism")) break;
+            return;
+        case 't':
+            if (ends("ate")) break;
+            if (ends("iti")) break;
+            return;
+        case 'u':
+            if (ends("ous")) break;
+            return;
+        case 'v':
+            if (ends("ive")) break;
+            return;
+        case 'z':
+            if (ends("ize")) break;
+            return;
+        default:
+            return;
+    }
+    if (measure() > 1) {
+        k = j;
+    }
+}
+
+// Removes a final -e and reduces -ll when the stem has m > 1
+void PorterStemmer::step5() {
+    j = k;
+    if (b[k] == 'e') {
+        int m = measure();
+        if (m > 1 || (m == 1 && !consonantVowelConsonant(k - 1))) {
+            k--;
+        }
+    }
+    if (b[k] == 'l' && doubleConsonant(k) && measure() > 1) {
+        k--;
+    }
+}
+
+// Stems a word into the output buffer
+int PorterStemmer::stem(const DSStringView& word, char* out) {
+    int length = word.size();
+    bool stemmable = (length <= MAX_WORD_LENGTH);
+
+    // Copy the word, noting whether it is purely lowercase ASCII letters
+    int copyLength = stemmable ? length : MAX_WORD_LENGTH;
+    for (int i = 0; i < copyLength; i++) {
+        char c = word[i];
+        out[i] = c;
+        if (c < 'a' || c > 'z') {
+            stemmable = false;
+        }
+    }
+
+    // Words of one or two letters, and anything non-alphabetic, are left alone
+    if (!stemmable || length <= 2) {
+        return copyLength;
+    }
+
+    b = out;
+    k = length - 1;
+    j = 0;
+
+    step1ab();
+    if (k > 0) {
+        step1c();
+        step2();
+        step3();
+        step4();
+        step5();
+    }
+    return k + 1;
+}
+
+//=== StemCache ===//
+
+// Constructor - sizes the slot array to a power of two
+StemCache::StemCache(int numSlots) {
+    unsigned int size = 1;
+    while (size < static_cast<unsigned int>(numSlots)) {
+        size <<= 1;
+    }
+
+    Slot empty;
+    empty.tag = 0;
+    empty.wordLength = 0;
+    empty.stemLength = 0;
+    slots.assign(size, empty);
+
+    mask = size - 1;
+    hits = 0;
+    misses = 0;
+}
+
+// Returns the stem of a word, consulting the cache first
+int StemCache::stem(const DSStringView& word, char* out) {
+    int length = word.size();
+
+    // Long words do not fit in a slot; stem them directly
+    if (length > MAX_CACHED_LENGTH) {
+        misses++;
+        return stemmer.stem(word, out);
+    }
+
+    unsigned int tag = hashWord(word);
+    Slot& slot = slots[tag & mask];
+
+    // Hit: same hash and same characters
+    if (slot.tag == tag && slot.wordLength == length) {
+        bool same = true;
+        for (int i = 0; i < length; i++) {
+            if (slot.word[i] != word[i]) {
+                same = false;
+                break;
+            }
+        }
+        if (same) {
+            hits++;
+            for (int i = 0; i < slot.stemLength; i++) {
+                out[i] = slot.stem[i];
+            }
+            return slot.stemLength;
+        }
+    }
+
+    // Miss: run the stemmer and replace whatever occupied the slot
+    misses++;
+    int stemLength = stemmer.stem(word, out);
+
+    slot.tag = tag;
+    slot.wordLength = static_cast<unsigned char>(length);
+    slot.stemLength = static_cast<unsigned char>(stemLength);
+    for (int i = 0; i < length; i++) {
+        slot.word[i] = word[i];
+    }
+    for (int i = 0; i < stemLength; i++) {
+        slot.stem[i] = out[i];
+    }
+    return stemLength;
+}
@@ -0,0 +1,179 @@
+/**
+ * PredictionCache.cpp
+ *
+ * Implementation of the sharded CLOCK prediction cache declared in
+ * PredictionCache.h.
+ */
+
+#include "../include/PredictionCache.h"
+#include "../include/Hash64.h"
+#include <iostream>
+#include <iomanip>
+
+// Default constructor - a disabled cache
+PredictionCache::PredictionCache() : setsPerShard(0) {
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        shards[i].hits = 0;
+        shards[i].misses = 0;
+        shards[i].evictions = 0;
+    }
+}
+
+// Sizes the cache and clears it
+void PredictionCache::configure(size_t capacity) {
+    setsPerShard = (capacity + NUM_SHARDS * WAYS - 1) / (NUM_SHARDS * WAYS);
+
+    Set empty;
+    for (int w = 0; w < WAYS; w++) {
+        empty.keys[w] = 0;
+        empty.scores[w] = 0;
+    }
+    empty.referenced = 0;
+    empty.hand = 0;
+
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        shards[i].sets.assign(setsPerShard, empty);
+    }
+    resetStats();
+}
+
+// Computes the cache key of a tweet text
+uint64_t PredictionCache::textKey(const DSString& text) {
+    // Normalize into an 8-byte window and hash each full window
+    uint64_t hash = 0;
+    char window[8];
+    int filled = 0;
+    bool pendingSpace = false;
+
+    for (int i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c == ' ') {
+            // Collapse space runs; leading and trailing spaces vanish (the
+            // tokenizer splits on spaces but not on other control characters)
+            pendingSpace = (filled > 0 || hash != 0);
+            continue;
+        }
+        if (pendingSpace) {
+            window[filled++] = ' ';
+            pendingSpace = false;
+            if (filled == 8) {
+                hash = hash64(window, 8, hash);
+                filled = 0;
+            }
+        }
+        window[filled++] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c;
+        if (filled == 8) {
+            hash = hash64(window, 8, hash);
+            filled = 0;
+        }
+    }
+    hash = hash64(window, filled, hash);
+
+    // 0 marks an empty way
+    return hash == 0 ? 1 : hash;
+}
+
+// Looks up a score
+bool PredictionCache::lookup(uint64_t key, int& score) {
+    if (setsPerShard == 0) {
+        return false;
+    }
+    Shard& shard = shards[key & (NUM_SHARDS - 1)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    Set& set = shard.sets[(key >> 6) % setsPerShard];
+    for (int w = 0; w < WAYS; w++) {
+        if (set.keys[w] == key) {
+            set.referenced |= static_cast<unsigned char>(1u << w);
+            score = set.scores[w];
+            shard.hits++;
+            return true;
+        }
+    }
+    shard.misses++;
+    return false;
+}
+
+// Stores a score, evicting with CLOCK if the set is full
+void PredictionCache::insert(uint64_t key, int score) {
+    if (setsPerShard == 0) {
+        return;
+    }
+    Shard& shard = shards[key & (NUM_SHARDS - 1)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    Set& set = shard.sets[(key >> 6) % setsPerShard];
+
+    // Already present (another thread inserted it) or a free way
+    for (int w = 0; w < WAYS; w++) {
+        if (set.keys[w] == key || set.keys[w] == 0) {
+            set.keys[w] = key;
+            set.scores[w] = score;
+            return;
+        }
+    }
+
+    // CLOCK: skip (and clear) referenced ways until an unreferenced one is found
+    while (set.referenced & (1u << set.hand)) {
+        set.referenced &= static_cast<unsigned char>(~(1u << set.hand));
+        set.hand = static_cast<unsigned char>((set.hand + 1) % WAYS);
+    }
+    set.keys[set.hand] = key;
+    set.scores[set.hand] = score;
+    set.hand = static_cast<unsigned char>((set.hand + 1) % WAYS);
+    shard.evictions++;
+}
+
+// Total hits across all shards
+long long PredictionCache::getHits() const {
+    long long total = 0;
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        total += shards[i].hits;
+    }
+    return total;
+}
+
+// Total misses across all shards
+long long PredictionCache::getMisses() const {
+    long long total = 0;
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        total += shards[i].misses;
+    }
+    return total;
+}
+
+// Total evictions across all shards
+long long PredictionCache::getEvictions() const {
+    long long total = 0;
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        total += shards[i].evictions;
+    }
+    return total;
+}
+
+// Resets the counters without clearing cached scores
+void PredictionCache::resetStats() {
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        std::lock_guard<std::mutex> guard(shards[i].lock);
+        shards[i].hits = 0;
+        shards[i].misses = 0;
+        shards[i].evictions = 0;
+    }
+}
+
+// Prints hit rate and occupancy
+void PredictionCache::printStats() const {
+    if (setsPerShard == 0) {
+        return;
+    }
+    long long hits = getHits();
+    long long lookups = hits + getMisses();
+    double hitRate = (lookups > 0) ? 100.0 * hits / lookups : 0.0;
+
+    std::streamsize oldPrecision = std::cout.precision();
+    std::cout << "Prediction cache: " << hits << " hits of " << lookups << " lookups ("
+              << std::fixed << std::setprecision(1) << hitRate << "%), "
+              << getEvictions() << " evictions, capacity "
+              << setsPerShard * NUM_SHARDS * WAYS << " entries"
+              << std::defaultfloat << std::setprecision(oldPrecision) << std::endl;
+}
@@ -0,0 +1,441 @@
+/**
+ * ScoringServer.cpp
+ *
+ * Implementation of the hot-reloading scoring daemon declared in
+ * ScoringServer.h.
+ */
+
+#include "../include/ScoringServer.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>      // For strerror and memcmp
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+std::atomic<bool> ScoringServer::stopRequested(false);
+
+// How often blocking loops check for a stop request
+static const int POLL_INTERVAL_MS = 200;
+
+// Quiet time after a change before the model file is read
+static const int SETTLE_MS = 100;
+
+/**
+ * Helper function: writes a whole buffer to a socket
+ * @return False if the peer has gone away
+ */
+static bool sendAll(int socket, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(socket, data, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+/**
+ * Helper function: true if a request line starts with the given verb
+ * followed by the end of the line or a space
+ */
+static bool isVerb(const char* line, size_t length, const char* verb) {
+    size_t verbLength = std::strlen(verb);
+    return length >= verbLength && std::memcmp(line, verb, verbLength) == 0 &&
+           (length == verbLength || line[verbLength] == ' ');
+}
+
+/**
+ * Helper function: merges per-thread histograms and appends their
+ * percentiles in microseconds as "<name>_p50_us <value> ..." fields
+ */
+static void appendPercentiles(std::ostringstream& text, const char* name,
+                              const std::vector<LatencyHistogram>& histograms) {
+    LatencyHistogram merged;
+    for (const LatencyHistogram& histogram : histograms) {
+        merged.merge(histogram);
+    }
+    static const double PERCENTILES[] = {50.0, 90.0, 99.0, 99.9};
+    static const char* const LABELS[] = {"p50", "p90", "p99", "p99.9"};
+    text << std::setprecision(1);
+    for (int i = 0; i < 4; i++) {
+        text << " " << name << "_" << LABELS[i] << "_us " << merged.valueAtPercentile(PERCENTILES[i]) / 1000.0;
+    }
+    text << " " << name << "_max_us " << merged.maxValue() / 1000.0;
+}
+
+// Constructor - nothing is loaded or opened until start()
+ScoringServer::ScoringServer(const ServerOptions& serverOptions)
+    : options(serverOptions), listenSocket(-1), current(nullptr), epochs(serverOptions.threads), generation(0),
+      servingGeneration(0), servingWords(0),
+      batcher(serverOptions.maxBatch, serverOptions.batchDelayMicros, serverOptions.latencyTargetMicros,
+              serverOptions.queueLimit, serverOptions.clientLimit),
+      requestLatency(serverOptions.threads), batchLatency(serverOptions.threads) {
+}
+
+// Destructor - stops the threads and frees the model
+ScoringServer::~ScoringServer() {
+    stopRequested.store(true);
+    reapConnections(true);
+    batcher.stop();
+    for (std::thread& scorer : scorers) {
+        scorer.join();
+    }
+    scorers.clear();
+    if (watcher.joinable()) {
+        watcher.join();
+    }
+    if (listenSocket >= 0) {
+        close(listenSocket);
+    }
+    delete current.load();
+}
+
+// Asks a running server to stop
+void ScoringServer::requestStop() {
+    stopRequested.store(true);
+}
+
+// Loads the model, starts listening and starts the file watcher
+bool ScoringServer::start() {
+    ServingModel* model = loadServingModel();
+    if (model == nullptr) {
+        return false;
+    }
+    current.store(model);
+    servingGeneration.store(model->generation);
+    servingWords.store(model->words);
+
+    listenSocket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenSocket < 0) {
+        std::cerr << "Error: Could not create a socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenSocket, SOMAXCONN) != 0) {
+        std::cerr << "Error: Could not listen on port " << options.port << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Watch the directory rather than the file, so a new file renamed over
+    // the old one (the safe way to replace a model) is seen as well
+    if (options.watch) {
+        std::string path(options.modelFile.c_str());
+        size_t slash = path.rfind('/');
+        std::string directory = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        int notifier = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (notifier < 0 || inotify_add_watch(notifier, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            std::cerr << "Error: Could not watch " << directory << ": " << std::strerror(errno) << std::endl;
+            if (notifier >= 0) {
+                close(notifier);
+            }
+            return false;
+        }
+        watcher = std::thread(&ScoringServer::watchLoop, this, notifier);
+    }
+
+    for (int slot = 0; slot < epochs.numReaders(); slot++) {
+        scorers.push_back(std::thread(&ScoringServer::scoreLoop, this, slot));
+    }
+
+    std::cout << "Serving " << options.modelFile << " on 127.0.0.1:" << options.port << " with "
+              << epochs.numReaders() << " scoring threads, batches of up to " << options.maxBatch << " within "
+              << options.batchDelayMicros << " us, " << options.queueLimit << " queued requests at most ("
+              << options.clientLimit << " per connection, " << (options.shed ? "shedding" : "backpressure")
+              << " when full)" << (options.watch ? ", reloading on change" : "") << std::endl;
+    return true;
+}
+
+// Builds a classifier from the model file
+ScoringServer::ServingModel* ScoringServer::loadServingModel() {
+    ServingModel* model = new ServingModel();
+    SentimentClassifier& classifier = model->classifier;
+    classifier.setStemmingEnabled(options.stemming);
+    classifier.setNegationEnabled(options.negation);
+    classifier.setSubwordFeaturesEnabled(options.subword);
+    classifier.setPredictionCacheCapacity(options.cacheEntries);
+    classifier.setNumThreads(epochs.numReaders());
+    if (!classifier.loadModel(options.modelFile) ||
+        (options.freezeBits > 0 && !classifier.freezeModel(options.freezeOptions))) {
+        delete model;
+        return nullptr;
+    }
+    model->generation = ++generation;
+    model->words = classifier.getVocabularySize();
+    return model;
+}
+
+// Loads the model file again, swaps it in and reclaims the old model
+void ScoringServer::reloadModel() {
+    auto start = std::chrono::steady_clock::now();
+    ServingModel* model = loadServingModel();
+    if (model == nullptr) {
+        std::cerr << "Error: Reloading " << options.modelFile << " failed; still serving generation "
+                  << current.load()->generation << std::endl;
+        return;
+    }
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // New requests see the new model from here on; the old one is deleted
+    // once the requests that loaded it have finished
+    ServingModel* old = current.exchange(model);
+    servingGeneration.store(model->generation);
+    servingWords.store(model->words);
+    double drainSeconds = epochs.synchronize();
+    delete old;
+
+    std::cout << std::fixed << std::setprecision(2) << "Reloaded model: generation " << model->generation
+              << ", " << model->words << " words, loaded in " << loadSeconds * 1000.0
+              << " ms, old model reclaimed after " << drainSeconds * 1000.0 << " ms" << std::defaultfloat << std::endl;
+}
+
+// Watches the model file's directory and reloads on changes
+void ScoringServer::watchLoop(int notifier) {
+    std::string path(options.modelFile.c_str());
+    size_t slash = path.rfind('/');
+    std::string fileName = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    alignas(inotify_event) char events[4096];
+
+    bool changed = false;
+    while (!stopRequested.load()) {
+        pollfd waiting = {notifier, POLLIN, 0};
+        int ready = poll(&waiting, 1, changed ? SETTLE_MS : POLL_INTERVAL_MS);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "Error: Model watcher failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        // Quiet since the last change: the writer is done, reload once for all events
+        if (ready == 0 && changed) {
+            changed = false;
+            reloadModel();
+            continue;
+        }
+
+        ssize_t length;
+        while ((length = read(notifier, events, sizeof(events))) > 0) {
+            for (char* position = events; position < events + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+                if (event->len > 0 && fileName == event->name) {
+                    changed = true;
+                }
+                position += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+    close(notifier);
+}
+
+// Accepts connections until a stop is requested
+void ScoringServer::run() {
+    while (!stopRequested.load()) {
+        pollfd waiting = {listenSocket, POLLIN, 0};
+        if (poll(&waiting, 1, POLL_INTERVAL_MS) > 0) {
+            int client = accept4(listenSocket, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0) {
+                connections.emplace_back();
+                Connection& connection = connections.back();
+                connection.socket = client;
+                connection.thread = std::thread(&ScoringServer::serveConnection, this, &connection);
+            }
+        }
+        reapConnections(false);
+    }
+
+    std::cout << "Stopping server..." << std::endl;
+    reapConnections(true);
+    batcher.stop();
+    for (std::thread& scorer : scorers) {
+        scorer.join();
+    }
+    scorers.clear();
+    if (watcher.joinable()) {
+        watcher.join();
+    }
+}
+
+// Joins the threads of connections that have closed
+void ScoringServer::reapConnections(bool all) {
+    for (auto it = connections.begin(); it != connections.end();) {
+        if (all && !it->finished.load()) {
+            shutdown(it->socket, SHUT_RDWR);    // Wakes the connection's thread
+        }
+        if (all || it->finished.load()) {
+            it->thread.join();
+            close(it->socket);
+            it = connections.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Scores batches from the batcher until it is stopped
+void ScoringServer::scoreLoop(int slot) {
+    std::vector<ScoreRequest*> batch;
+    std::vector<const DSString*> texts;
+    std::vector<int> scores;
+    while (batcher.takeBatch(batch)) {
+        texts.clear();
+        for (const ScoreRequest* request : batch) {
+            texts.push_back(&request->text);
+        }
+        scores.resize(batch.size());
+
+        // The whole batch is scored by the model that was current when it started
+        auto scoreStart = std::chrono::steady_clock::now();
+        epochs.enter(slot);
+        current.load()->classifier.scoreTexts(texts.data(), texts.size(), scores.data(), slot);
+        epochs.exit(slot);
+        auto scoreEnd = std::chrono::steady_clock::now();
+        batchLatency[slot].record(scoreEnd - scoreStart);
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            batch[i]->score = scores[i];
+            requestLatency[slot].record(scoreEnd - batch[i]->arrival);
+        }
+        batcher.complete(batch);
+    }
+}
+
+// Answers the requests of one connection until it closes
+void ScoringServer::serveConnection(Connection* connection) {
+    std::vector<char> pending;
+    std::vector<std::pair<size_t, size_t>> lines;  // Start and length of each complete line
+    std::vector<ScoreRequest> requests;
+    std::vector<ScoreRequest*> submitted;
+    std::string replies;
+    std::string reply;
+    char buffer[16384];
+    bool open = true;
+    while (open) {
+        ssize_t received = recv(connection->socket, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        pending.insert(pending.end(), buffer, buffer + received);
+
+        // Split off the complete lines
+        lines.clear();
+        size_t lineStart = 0;
+        size_t scoreLines = 0;
+        for (size_t i = 0; i < pending.size(); i++) {
+            if (pending[i] == '\n') {
+                size_t lineEnd = (i > lineStart && pending[i - 1] == '\r') ? i - 1 : i;
+                lines.push_back(std::make_pair(lineStart, lineEnd - lineStart));
+                if (isVerb(pending.data() + lineStart, lineEnd - lineStart, "SCORE")) {
+                    scoreLines++;
+                }
+                lineStart = i + 1;
+            }
+        }
+
+        // Queue every SCORE line of this read at once and wait for all of
+        // them; until they are queued, nothing more is read from the socket
+        RequestGroup group;
+        requests.clear();
+        requests.resize(scoreLines);
+        submitted.clear();
+        for (const std::pair<size_t, size_t>& line : lines) {
+            const char* text = pending.data() + line.first;
+            if (isVerb(text, line.second, "SCORE")) {
+                ScoreRequest& request = requests[submitted.size()];
+                request.text = (line.second > 6) ? DSString(text + 6, static_cast<int>(line.second - 6)) : DSString("");
+                request.group = &group;
+                submitted.push_back(&request);
+            }
+        }
+        size_t accepted = 0;
+        if (!submitted.empty()) {
+            group.remaining = submitted.size();
+            accepted = batcher.submit(connection->queue, submitted.data(), submitted.size(), options.shed);
+            if (accepted < submitted.size()) {
+                std::lock_guard<std::mutex> guard(group.lock);
+                group.remaining -= submitted.size() - accepted;
+            }
+            group.wait();
+        }
+
+        // Reply in request order; commands after a QUIT are dropped
+        size_t nextScore = 0;
+        for (const std::pair<size_t, size_t>& line : lines) {
+            const char* text = pending.data() + line.first;
+            if (isVerb(text, line.second, "SCORE")) {
+                if (nextScore >= accepted) {
+                    reply = "UNAVAILABLE";
+                    nextScore++;
+                } else {
+                    int score = requests[nextScore++].score;
+                    reply = "OK " + std::to_string(score > 0 ? 4 : 0) + " " + std::to_string(score);
+                }
+            } else if (!handleCommand(text, line.second, reply)) {
+                open = false;
+                break;
+            }
+            if (reply.size() > 0) {
+                replies += reply;
+                replies += '\n';
+            }
+        }
+        pending.erase(pending.begin(), pending.begin() + lineStart);
+        if (open && pending.size() > MAX_LINE_BYTES) {
+            replies += "ERR line too long\n";
+            open = false;
+        }
+        if (!replies.empty() && !sendAll(connection->socket, replies.data(), replies.size())) {
+            open = false;
+        }
+        replies.clear();
+    }
+    connection->finished.store(true);
+}
+
+// Answers one request line other than SCORE
+bool ScoringServer::handleCommand(const char* line, size_t length, std::string& reply) {
+    reply.clear();
+    if (isVerb(line, length, "MODEL")) {
+        reply = "OK generation " + std::to_string(servingGeneration.load()) + " words " +
+                std::to_string(servingWords.load());
+    } else if (isVerb(line, length, "STATS")) {
+        BatcherStats stats = batcher.stats();
+        std::ostringstream text;
+        text << "OK requests " << stats.requests << " batches " << stats.batches << " mean_batch " << std::fixed
+             << std::setprecision(2) << (stats.batches > 0 ? static_cast<double>(stats.requests) / stats.batches : 0.0)
+             << " queued " << stats.queued << " queue_limit " << stats.queueLimit << " shed " << stats.shed
+             << " blocked " << stats.blocked << " target_batch " << stats.targetBatch << " delay_us "
+             << stats.delayMicros << " arrival_rate " << std::setprecision(0) << stats.arrivalRate << " p99_us "
+             << stats.p99Micros;
+        appendPercentiles(text, "request", requestLatency);
+        appendPercentiles(text, "batch", batchLatency);
+        reply = text.str();
+    } else if (isVerb(line, length, "PING")) {
+        reply = "OK";
+    } else if (isVerb(line, length, "QUIT")) {
+        return false;
+    } else if (length > 0) {
+        reply = "ERR unknown command";
+    }
+    return true;
+}
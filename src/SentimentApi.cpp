@@ -0,0 +1,164 @@
+/**
+ * SentimentApi.cpp
+ *
+ * Implementation of the C interface declared in SentimentApi.h, on top of
+ * the serving entry points of SentimentClassifier.
+ */
+
+#include "../include/SentimentApi.h"
+#include "../include/SentimentClassifier.h"
+#include <climits>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+/**
+ * Loaded model behind the opaque handle: the classifier and the worker
+ * slots not currently lent to a caller
+ */
+struct sentiment_model {
+    SentimentClassifier classifier;
+    std::mutex lock;
+    std::condition_variable slotFreed;
+    std::vector<int> freeSlots;
+
+    /**
+     * Borrows a worker slot, waiting while all are in use
+     */
+    int acquireSlot() {
+        std::unique_lock<std::mutex> guard(lock);
+        slotFreed.wait(guard, [this] { return !freeSlots.empty(); });
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+
+    /**
+     * Returns a borrowed slot
+     */
+    void releaseSlot(int slot) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            freeSlots.push_back(slot);
+        }
+        slotFreed.notify_one();
+    }
+};
+
+/**
+ * Worker slot borrowed for the lifetime of the object, returned however
+ * the scope is left
+ */
+struct SlotLease {
+    sentiment_model& model;
+    int slot;
+
+    explicit SlotLease(sentiment_model& owner) : model(owner), slot(owner.acquireSlot()) {}
+    ~SlotLease() { model.releaseSlot(slot); }
+    SlotLease(const SlotLease&) = delete;
+    SlotLease& operator=(const SlotLease&) = delete;
+};
+
+// Loads a model saved with --save-model
+sentiment_model* sentiment_load_model(const char* path, unsigned flags, int freeze_bits, size_t cache_entries,
+                                      int max_callers) {
+    if (path == nullptr) {
+        std::cerr << "Error: No model file given" << std::endl;
+        return nullptr;
+    }
+    if (freeze_bits != 0 && freeze_bits != 8 && freeze_bits != 16 && freeze_bits != 32) {
+        std::cerr << "Error: freeze_bits must be 0, 32, 16 or 8" << std::endl;
+        return nullptr;
+    }
+    if (max_callers <= 0) {
+        max_callers = static_cast<int>(std::thread::hardware_concurrency());
+    }
+
+    try {
+        std::unique_ptr<sentiment_model> model(new sentiment_model());
+        SentimentClassifier& classifier = model->classifier;
+        classifier.setStemmingEnabled((flags & SENTIMENT_STEM) != 0);
+        classifier.setNegationEnabled((flags & SENTIMENT_NEGATION) != 0);
+        classifier.setSubwordFeaturesEnabled((flags & SENTIMENT_NGRAMS) != 0);
+        classifier.setPredictionCacheCapacity(cache_entries);
+        classifier.setNumThreads(max_callers);
+        FreezeOptions freezeOptions;
+        freezeOptions.weightBits = freeze_bits;
+        if (!classifier.loadModel(DSString(path)) || (freeze_bits > 0 && !classifier.freezeModel(freezeOptions))) {
+            return nullptr;
+        }
+        for (int slot = classifier.getNumThreads() - 1; slot >= 0; slot--) {
+            model->freeSlots.push_back(slot);
+        }
+        return model.release();
+    } catch (const std::bad_alloc&) {
+        std::cerr << "Error: Out of memory loading " << path << std::endl;
+        return nullptr;
+    } catch (const std::exception& error) {
+        std::cerr << "Error: Could not load " << path << ": " << error.what() << std::endl;
+        return nullptr;
+    } catch (...) {
+        std::cerr << "Error: Could not load " << path << std::endl;
+        return nullptr;
+    }
+}
+
+// Scores a batch of tweet texts
+int sentiment_score_batch(sentiment_model* model, const char** texts, const size_t* lens, size_t n, float* out) {
+    if (n == 0) {
+        return 0;
+    }
+    if (model == nullptr || texts == nullptr || lens == nullptr || out == nullptr) {
+        std::cerr << "Error: sentiment_score_batch needs a model, texts, lengths and an output array" << std::endl;
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if ((texts[i] == nullptr && lens[i] > 0) || lens[i] > static_cast<size_t>(INT_MAX)) {
+            std::cerr << "Error: Invalid text " << i << " passed to sentiment_score_batch" << std::endl;
+            return -1;
+        }
+    }
+
+    try {
+        std::vector<DSString> copies;
+        std::vector<const DSString*> pointers(n);
+        std::vector<int> scores(n);
+        copies.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            copies.emplace_back(texts[i] != nullptr ? texts[i] : "", static_cast<int>(lens[i]));
+            pointers[i] = &copies.back();
+        }
+
+        {
+            SlotLease lease(*model);
+            model->classifier.scoreTexts(pointers.data(), n, scores.data(), lease.slot);
+        }
+        for (size_t i = 0; i < n; i++) {
+            out[i] = static_cast<float>(scores[i]);
+        }
+        return 0;
+    } catch (const std::bad_alloc&) {
+        std::cerr << "Error: Out of memory scoring a batch of " << n << " texts" << std::endl;
+        return -1;
+    } catch (const std::exception& error) {
+        std::cerr << "Error: Could not score a batch of " << n << " texts: " << error.what() << std::endl;
+        return -1;
+    } catch (...) {
+        std::cerr << "Error: Could not score a batch of " << n << " texts" << std::endl;
+        return -1;
+    }
+}
+
+// Frees a model
+void sentiment_free_model(sentiment_model* model) {
+    try {
+        delete model;
+    } catch (...) {
+        // Nothing may escape into C code; the model is gone either way
+    }
+}
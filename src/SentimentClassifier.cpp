@@ -7,8 +7,20 @@
  */
 
 #include "../include/SentimentClassifier.h"
+#include "../include/Utf8.h"
 #include <iostream>
 #include <iomanip> // For formatting accuracy output
+#include <chrono>  // For tokenizer throughput measurement
+#include <thread>  // For parallel batch parsing
+#include <atomic>  // For handing out input files to parser threads
+#include <sstream>
+#include <cmath>   // For sizing the shared vocabulary
+#include "../include/CsvChunker.h"
+#include "../include/ModelFile.h"
+#include <fcntl.h>     // For mapping the training file when planning shards
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 /**
  * Default constructor
@@ -19,9 +31,187 @@ SentimentClassifier::SentimentClassifier() {
     totalPositiveTweets = 0;
     totalNegativeTweets = 0;
     
+    // Stemming is off unless requested
+    stemmingEnabled = false;
+    subwordEnabled = false;
+    negationEnabled = false;
+    dedupeMode = DEDUPE_OFF;
+    sharedVocabularyEnabled = false;
+    sharedVocabularyPages = HUGE_PAGES_OFF;
+    freezeCheckEnabled = false;
+    frozenPages = HUGE_PAGES_OFF;
+    numaMode = NUMA_OFF;
+    parityTweets = 0;
+    parityMismatches = 0;
+    parityError = 0.0;
+    
+    subwordTokensTrained = 0;
+    subwordSeconds = 0.0;
+    subwordTokensScored = 0;
+    tokensProcessed = 0;
+    tokenizeSeconds = 0.0;
+    
+    readQueueDepth = AsyncFileReader::DEFAULT_QUEUE_DEPTH;
+    readBlockSize = AsyncFileReader::DEFAULT_BLOCK_SIZE;
+    
+    // One parser thread per hardware thread by default
+    setNumThreads(static_cast<int>(std::thread::hardware_concurrency()));
+    
     // Other member variables (maps) are automatically initialized by their constructors
 }
 
+/**
+ * Enables or disables the Porter stemming stage
+ * 
+ * @param enabled True to stem every token after tokenization
+ */
+void SentimentClassifier::setStemmingEnabled(bool enabled) {
+    stemmingEnabled = enabled;
+}
+
+/**
+ * Enables or disables hashed character n-gram features
+ * 
+ * @param enabled True to score out-of-vocabulary tokens from their n-grams
+ */
+void SentimentClassifier::setSubwordFeaturesEnabled(bool enabled) {
+    subwordEnabled = enabled;
+}
+
+/**
+ * Enables or disables negation scope marking in the tokenizer
+ * 
+ * @param enabled True to mark tokens between a negator and the next clause punctuation
+ */
+void SentimentClassifier::setNegationEnabled(bool enabled) {
+    negationEnabled = enabled;
+}
+
+/**
+ * Selects how duplicate training tweets are detected and skipped
+ * 
+ * @param mode Deduplication strategy (DEDUPE_OFF to count every tweet)
+ */
+void SentimentClassifier::setDedupeMode(DedupeMode mode) {
+    dedupeMode = mode;
+}
+
+/**
+ * Selects whether training threads count words in one shared lock-free table
+ * 
+ * @param enabled True to use the shared table
+ */
+void SentimentClassifier::setSharedVocabularyEnabled(bool enabled) {
+    sharedVocabularyEnabled = enabled;
+}
+
+/**
+ * Selects the pages backing the shared training table
+ * 
+ * @param mode Largest page size to try
+ */
+void SentimentClassifier::setSharedVocabularyPages(HugePageMode mode) {
+    sharedVocabularyPages = mode;
+}
+
+/**
+ * Enables the prediction cache
+ * 
+ * @param capacity Number of cached scores (0 disables the cache)
+ */
+void SentimentClassifier::setPredictionCacheCapacity(size_t capacity) {
+    predictionCache.configure(capacity);
+}
+
+/**
+ * Sets how uncompressed input files are read
+ * 
+ * @param queueDepth Number of block reads kept in flight
+ * @param blockSize Bytes per read
+ */
+void SentimentClassifier::setReadOptions(int queueDepth, size_t blockSize) {
+    readQueueDepth = queueDepth;
+    readBlockSize = blockSize;
+}
+
+/**
+ * Sets the number of threads that parse and tokenize input in parallel
+ * 
+ * @param threads Number of parser threads (at least 1)
+ */
+void SentimentClassifier::setNumThreads(int threads) {
+    numThreads = (threads < 1) ? 1 : threads;
+    workers.clear();
+    workers.resize(numThreads);
+    assignNodes();
+}
+
+/**
+ * Selects NUMA placement of parser threads
+ * 
+ * @param mode NUMA_OFF, NUMA_PIN or NUMA_REPLICATE
+ */
+void SentimentClassifier::setNumaMode(NumaMode mode) {
+    numaMode = mode;
+    assignNodes();
+}
+
+/**
+ * Assigns every worker slot its NUMA node (all node 0 unless pinning)
+ */
+void SentimentClassifier::assignNodes() {
+    for (int slot = 0; slot < numThreads; slot++) {
+        workers[slot].node = numaPinning() ? numaTopology.nodeOfSlot(slot, numThreads) : 0;
+    }
+}
+
+/**
+ * Helper function: True if the word at text[wordStart..wordEnd) is a negator
+ * Contractions are split at the apostrophe by the tokenizer, so "don't"
+ * arrives as "don" + "t"; a lone "t" directly after "n'" (or "n" followed
+ * by a typographic apostrophe) counts as the negator.
+ */
+static bool isNegator(const char* text, int wordStart, int wordEnd) {
+    static const char* const NEGATORS[] = {
+        "no", "not", "never", "nothing", "nobody", "none", "neither", "nor",
+        "nowhere", "cannot", "cant", "dont", "wont", "isnt", "arent", "wasnt",
+        "werent", "didnt", "doesnt", "hasnt", "havent", "hadnt", "couldnt",
+        "shouldnt", "wouldnt", "aint", "without"
+    };
+    int length = wordEnd - wordStart;
+    
+    // "n't" split by the tokenizer
+    if (length == 1 && text[wordStart] == 't') {
+        if (wordStart >= 2 && text[wordStart - 1] == '\'' && text[wordStart - 2] == 'n') {
+            return true;
+        }
+        // U+2019 right single quotation mark is E2 80 99 in UTF-8
+        return wordStart >= 4 && text[wordStart - 4] == 'n' &&
+               static_cast<unsigned char>(text[wordStart - 3]) == 0xE2 &&
+               static_cast<unsigned char>(text[wordStart - 2]) == 0x80 &&
+               static_cast<unsigned char>(text[wordStart - 1]) == 0x99;
+    }
+    
+    // Every listed negator is 2 to 8 letters long and ends in o, r, e, y, g or t
+    if (length < 2 || length > 8) {
+        return false;
+    }
+    char last = text[wordEnd - 1];
+    if (last != 't' && last != 'o' && last != 'r' && last != 'e' && last != 'y' && last != 'g') {
+        return false;
+    }
+    for (const char* negator : NEGATORS) {
+        int k = 0;
+        while (k < length && negator[k] == text[wordStart + k]) {
+            k++;
+        }
+        if (k == length && negator[k] == '\0') {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * Tokenizes a tweet text into individual words
  * 
@@ -29,60 +219,206 @@ SentimentClassifier::SentimentClassifier() {
  * 1. Convert the tweet to lowercase
  * 2. Split by spaces and punctuation
  * 3. Filter out empty tokens
+ * 4. Optionally stem each word
+ * 5. Optionally mark words inside a negation scope
+ * 
+ * Note: This implementation scans the text once, remembering where the
+ * current word started and emitting it as a view when a delimiter is
+ * encountered. Runs of ASCII are classified 16 bytes at a time; a block
+ * containing UTF-8 is walked one code point at a time so multi-byte
+ * characters are never split and Unicode spaces and punctuation
+ * (curly quotes, ellipsis, no-break space) also end a word. Each emoji
+ * becomes a token of its own, even when written directly against a word.
  * 
- * Note: This implementation manually tokenizes by iterating through the text
- * character by character, building words until a delimiter is encountered.
+ * Negation scope is tracked as state in the same pass: after a negator
+ * ("not", "never", "n't", ...) every token up to the next clause
+ * punctuation is emitted with the NEGATION_MARKER prefix, so "not good"
+ * yields "not", "!good" and never adds the weight of "good".
  * 
  * @param tweetText The text of the tweet to tokenize
+ * @param stemCache Stem cache of the calling thread
  * @return Vector of DSString objects representing individual words
  */
-std::vector<DSString> SentimentClassifier::tokenizeTweet(const DSString& tweetText) const {
+std::vector<DSString> SentimentClassifier::tokenizeTweet(const DSString& tweetText, StemCache& stemCache) const {
     std::vector<DSString> tokens;
     
     // Convert tweet to lowercase for case-insensitive analysis
     DSString lowerText = tweetText.toLowerCase();
+    const char* text = lowerText.c_str();
+    int textLength = lowerText.size();
     
-    // Current word being built
-    DSString currentWord;
+    // Start of the word currently being scanned (-1 when between words)
+    int wordStart = -1;
     
-    // Characters that delimit words (space, punctuation)
-    const char* delimiters = " ,.!?;:\"'()[]{}@#$%^&*-_=+<>/\\|~`";
+    // True while inside a negation scope
+    bool negated = false;
     
-    // Process each character
-    for (int i = 0; i < lowerText.size(); i++) {
-        char c = lowerText[i];
-        
-        // Check if current character is a delimiter
-        bool isDelimiter = false;
-        for (int j = 0; delimiters[j] != '\0'; j++) {
-            if (c == delimiters[j]) {
-                isDelimiter = true;
-                break;
+    int i = 0;
+    while (i < textLength) {
+        // Fast path: a block of 16 ASCII bytes classified at once
+        unsigned int delimiterMask;
+        unsigned int clauseMask;
+        if (i + UTF8_BLOCK_SIZE <= textLength && classifyAsciiBlock(text + i, delimiterMask, clauseMask)) {
+            // Bits set where a word starts or ends inside this block
+            unsigned int wordMask = ~delimiterMask & 0xFFFFu;
+            unsigned int carry = (wordStart >= 0) ? 1u : 0u;
+            unsigned int transitions = (wordMask ^ ((wordMask << 1) | carry)) & 0xFFFFu;
+            
+            // Clause punctuation only matters while tracking negation
+            if (!negationEnabled) {
+                clauseMask = 0;
             }
+            
+            // Visit word boundaries and clause ends in text order
+            unsigned int events = transitions | clauseMask;
+            while (events != 0) {
+                unsigned int bit = events & (~events + 1);
+                int position = i + __builtin_ctz(events);
+                if (transitions & bit) {
+                    if (wordStart < 0) {
+                        wordStart = position;
+                    } else {
+                        endWord(tokens, text, wordStart, position, negated, stemCache);
+                        wordStart = -1;
+                    }
+                }
+                if (clauseMask & bit) {
+                    negated = false;
+                }
+                events &= events - 1;
+            }
+            i += UTF8_BLOCK_SIZE;
+            continue;
         }
         
-        if (isDelimiter) {
+        // Slow path: one (possibly multi-byte) character
+        int codePoint;
+        int numBytes = utf8Decode(text + i, textLength - i, codePoint);
+        
+        if (isEmoji(codePoint)) {
+            // Emoji end the current word and become tokens of their own
+            if (wordStart >= 0) {
+                endWord(tokens, text, wordStart, i, negated, stemCache);
+                wordStart = -1;
+            }
+            appendToken(tokens, DSStringView(text + i, numBytes), negated, stemCache);
+        } else if (isWordDelimiter(codePoint) || isEmojiComponent(codePoint)) {
             // If we have a word, add it to tokens
-            if (currentWord.size() > 0) {
-                tokens.push_back(currentWord);
-                currentWord = DSString(); // Reset current word
+            // (skin tones, joiners and variation selectors are dropped like spaces)
+            if (wordStart >= 0) {
+                endWord(tokens, text, wordStart, i, negated, stemCache);
+                wordStart = -1;
             }
-        } else {
-            // Add character to current word
-            // Create a temporary null-terminated C-string with just this character
-            char temp[2] = {c, '\0'};
-            currentWord = currentWord + DSString(temp);
+            if (isClauseBoundary(codePoint)) {
+                negated = false;
+            }
+        } else if (wordStart < 0) {
+            // First character of a new word
+            wordStart = i;
         }
+        i += numBytes;
     }
     
     // Don't forget last word if not followed by delimiter
-    if (currentWord.size() > 0) {
-        tokens.push_back(currentWord);
+    if (wordStart >= 0) {
+        endWord(tokens, text, wordStart, textLength, negated, stemCache);
     }
     
     return tokens;
 }
 
+/**
+ * Emits the word text[wordStart..wordEnd) and updates the negation scope
+ * 
+ * @param tokens Token list to append to
+ * @param text Lowercased tweet text
+ * @param wordStart Index of the first character of the word
+ * @param wordEnd Index one past the last character of the word
+ * @param negated Negation scope flag, set when the word is a negator
+ * @param stemCache Stem cache of the calling thread
+ */
+void SentimentClassifier::endWord(std::vector<DSString>& tokens, const char* text,
+                                  int wordStart, int wordEnd, bool& negated, StemCache& stemCache) const {
+    if (negationEnabled && isNegator(text, wordStart, wordEnd)) {
+        // The negator itself is emitted unmarked and opens a new scope
+        appendToken(tokens, DSStringView(text + wordStart, wordEnd - wordStart), false, stemCache);
+        negated = true;
+        return;
+    }
+    appendToken(tokens, DSStringView(text + wordStart, wordEnd - wordStart), negated, stemCache);
+}
+
+/**
+ * Appends one word to a token list, stemming it first if enabled
+ * 
+ * @param tokens Token list to append to
+ * @param word View of the (lowercase) word inside the tweet text
+ * @param negated True to prefix the token with NEGATION_MARKER
+ * @param stemCache Stem cache of the calling thread
+ */
+void SentimentClassifier::appendToken(std::vector<DSString>& tokens, const DSStringView& word, bool negated,
+                                      StemCache& stemCache) const {
+    // Very long words are passed through unstemmed
+    if (word.size() > PorterStemmer::MAX_WORD_LENGTH) {
+        if (negated) {
+            char marker[2] = {NEGATION_MARKER, '\0'};
+            tokens.push_back(DSString(marker) + word.toDSString());
+        } else {
+            tokens.push_back(word.toDSString());
+        }
+        return;
+    }
+    
+    // Build the (marked) token in a local buffer so it is allocated only once
+    char buffer[PorterStemmer::MAX_WORD_LENGTH + 1];
+    int offset = 0;
+    if (negated) {
+        buffer[offset++] = NEGATION_MARKER;
+    }
+    
+    int length;
+    if (stemmingEnabled) {
+        length = stemCache.stem(word, buffer + offset);
+    } else {
+        length = word.size();
+        for (int k = 0; k < length; k++) {
+            buffer[offset + k] = word[k];
+        }
+    }
+    tokens.push_back(DSString(buffer, offset + length));
+}
+
+/**
+ * Prints tokenizer throughput and, if stemming, the stem cache hit rate
+ * 
+ * @param phase Name of the phase being reported (e.g. "Training")
+ */
+void SentimentClassifier::printTokenizerStats(const char* phase) const {
+    double tokensPerSecond = (tokenizeSeconds > 0.0) ? tokensProcessed / tokenizeSeconds : 0.0;
+    std::streamsize oldPrecision = std::cout.precision();
+    std::cout << phase << " tokenizer: " << tokensProcessed << " tokens, "
+              << std::fixed << std::setprecision(0) << tokensPerSecond << " tokens/sec";
+    
+    if (stemmingEnabled) {
+        long long hits = 0;
+        long long lookups = 0;
+        for (const WorkerState& worker : workers) {
+            hits += worker.stemCache.getHits();
+            lookups += worker.stemCache.getHits() + worker.stemCache.getMisses();
+        }
+        double hitRate = (lookups > 0) ? 100.0 * hits / lookups : 0.0;
+        std::cout << ", stem cache hit rate " << std::setprecision(1) << hitRate << "%";
+    }
+    std::cout << std::defaultfloat << std::setprecision(oldPrecision) << std::endl;
+}
+
+/**
+ * Prints how the last input was read (format, I/O backend or file pool)
+ */
+void SentimentClassifier::printInputStats() const {
+    std::cout << inputStats << std::endl;
+}
+
 /**
  * Parses a CSV line into its components
  * 
@@ -131,12 +467,70 @@ std::vector<DSString> SentimentClassifier::parseCSVLine(const DSString& line, bo
 
 /**
  * Calculates a sentiment score for a tweet based on the training data
- * For each word, adds (positive count - negative count) to the score
+ * For each word, adds (positive count - negative count) to the score;
+ * unknown words add their average n-gram score if subword features are on
  * 
  * @param tokens Vector of words from a tokenized tweet
+ * @param worker State of the calling thread (counts n-gram fallbacks)
  * @return The sentiment score (positive value suggests positive sentiment)
  */
-int SentimentClassifier::calculateSentimentScore(const std::vector<DSString>& tokens) const {
+int SentimentClassifier::calculateSentimentScore(const std::vector<DSString>& tokens, WorkerState& worker) const {
+    if (!frozenModel.isFrozen()) {
+        return countScore(tokens, worker.subwordScored);
+    }
+    
+    // Frozen model (the copy on this thread's node when replicated): sum the quantized weights, then scale once
+    const FrozenModel& model = frozenReplicas.empty() ? frozenModel : *frozenReplicas[worker.node];
+    long long quantizedSum = 0;
+    int subwordScore = 0;
+    for (const DSString& token : tokens) {
+        int weight;
+        if (model.lookup(token.c_str(), token.size(), weight, worker.probes)) {
+            quantizedSum += weight;
+        } else if (subwordEnabled && token.size() > 1) {
+            subwordScore += subwordFeatures.scoreToken(DSStringView(token));
+            worker.subwordScored++;
+        }
+    }
+    return frozenScore(tokens, quantizedSum, subwordScore, model, worker);
+}
+
+/**
+ * Turns the quantized sum of a tweet's frozen weights into its score
+ * Scaling once per tweet keeps the sum exact in the integer domain.
+ * 
+ * @param tokens Vector of words from the tokenized tweet
+ * @param quantizedSum Sum of the quantized weights of the words found
+ * @param subwordScore Score of the words scored from their n-grams
+ * @param model Frozen model the weights came from
+ * @param worker State of the calling thread
+ * @return The sentiment score
+ */
+int SentimentClassifier::frozenScore(const std::vector<DSString>& tokens, long long quantizedSum, int subwordScore,
+                                     const FrozenModel& model, WorkerState& worker) const {
+    int score = static_cast<int>(std::llround(quantizedSum * static_cast<double>(model.getScale()))) + subwordScore;
+    
+    // Parity check: compare with the full-precision score
+    if (freezeCheckEnabled) {
+        long long unused = 0;
+        int exact = countScore(tokens, unused);
+        worker.parityTweets++;
+        if ((exact > 0) != (score > 0)) {
+            worker.parityMismatches++;
+        }
+        worker.parityError += std::abs(exact - score);
+    }
+    return score;
+}
+
+/**
+ * Scores tokens at full precision from wordSentimentCounts
+ * 
+ * @param tokens Vector of words from a tokenized tweet
+ * @param subwordScored Incremented for every n-gram fallback
+ * @return The sentiment score
+ */
+int SentimentClassifier::countScore(const std::vector<DSString>& tokens, long long& subwordScored) const {
     int score = 0;
     
     // For each word in the tweet
@@ -147,85 +541,609 @@ int SentimentClassifier::calculateSentimentScore(const std::vector<DSString>& to
         if (it != wordSentimentCounts.end()) {
             // Add the difference between positive and negative frequencies to the score
             score += (it->second.first - it->second.second);
+        } else if (subwordEnabled && token.size() > 1) {
+            // Unknown word: fall back to its character n-grams
+            score += subwordFeatures.scoreToken(DSStringView(token));
+            subwordScored++;
         }
     }
     
     return score;
 }
 
+/**
+ * Scores one tweet text
+ * With the prediction cache enabled, a text seen before (after case and
+ * whitespace normalization) is answered from the cache without tokenizing.
+ * 
+ * @param tweetText The text of the tweet
+ * @param worker State of the calling thread
+ * @return The sentiment score (positive value suggests positive sentiment)
+ */
+int SentimentClassifier::scoreTweet(const DSString& tweetText, WorkerState& worker) {
+    uint64_t cacheKey = 0;
+    int score;
+    if (predictionCache.isEnabled()) {
+        cacheKey = PredictionCache::textKey(tweetText);
+        if (predictionCache.lookup(cacheKey, score)) {
+            return score;
+        }
+    }
+    
+    // Tokenize the tweet
+    auto tokenizeStart = std::chrono::steady_clock::now();
+    std::vector<DSString> tokens = tokenizeTweet(tweetText, worker.stemCache);
+    worker.tokenizeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - tokenizeStart).count();
+    worker.tokens += tokens.size();
+    
+    score = calculateSentimentScore(tokens, worker);
+    
+    if (predictionCache.isEnabled()) {
+        predictionCache.insert(cacheKey, score);
+    }
+    return score;
+}
+
+/**
+ * Scores one tweet text on behalf of a serving thread
+ * 
+ * @param tweetText The text of the tweet
+ * @param slot Worker slot of the caller
+ * @return The sentiment score (positive value suggests positive sentiment)
+ */
+int SentimentClassifier::scoreText(const DSString& tweetText, int slot) {
+    return scoreTweet(tweetText, workers[slot]);
+}
+
+/**
+ * Scores a batch of tweet texts on behalf of a serving thread
+ * Cached texts are answered first; the rest are tokenized, and with a
+ * frozen model all their words go through one batched lookup.
+ * 
+ * @param tweetTexts The texts to score
+ * @param count Number of texts
+ * @param scores Receives the score of each text
+ * @param slot Worker slot of the caller
+ */
+void SentimentClassifier::scoreTexts(const DSString* const* tweetTexts, size_t count, int* scores, int slot) {
+    WorkerState& worker = workers[slot];
+    if (!frozenModel.isFrozen()) {
+        for (size_t i = 0; i < count; i++) {
+            scores[i] = scoreTweet(*tweetTexts[i], worker);
+        }
+        return;
+    }
+    
+    // Tokenize every text the cache cannot answer
+    std::vector<size_t> pending;
+    std::vector<uint64_t> cacheKeys;
+    std::vector<std::vector<DSString>> tokens;
+    auto tokenizeStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        uint64_t cacheKey = 0;
+        if (predictionCache.isEnabled()) {
+            cacheKey = PredictionCache::textKey(*tweetTexts[i]);
+            if (predictionCache.lookup(cacheKey, scores[i])) {
+                continue;
+            }
+        }
+        pending.push_back(i);
+        cacheKeys.push_back(cacheKey);
+        tokens.push_back(tokenizeTweet(*tweetTexts[i], worker.stemCache));
+        worker.tokens += tokens.back().size();
+    }
+    worker.tokenizeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - tokenizeStart).count();
+    
+    // Look up the words of the whole batch at once
+    worker.batchWords.clear();
+    worker.batchLengths.clear();
+    for (const std::vector<DSString>& tweetTokens : tokens) {
+        for (const DSString& token : tweetTokens) {
+            worker.batchWords.push_back(token.c_str());
+            worker.batchLengths.push_back(token.size());
+        }
+    }
+    worker.batchWeights.resize(worker.batchWords.size());
+    worker.batchFound.resize(worker.batchWords.size());
+    const FrozenModel& model = frozenReplicas.empty() ? frozenModel : *frozenReplicas[worker.node];
+    model.lookupBatch(worker.batchWords.data(), worker.batchLengths.data(), worker.batchWords.size(),
+                      worker.batchWeights.data(), worker.batchFound.data(), worker.probes);
+    
+    // Sum each tweet's weights in the same order as calculateSentimentScore
+    size_t word = 0;
+    for (size_t t = 0; t < pending.size(); t++) {
+        long long quantizedSum = 0;
+        int subwordScore = 0;
+        for (const DSString& token : tokens[t]) {
+            if (worker.batchFound[word]) {
+                quantizedSum += worker.batchWeights[word];
+            } else if (subwordEnabled && token.size() > 1) {
+                subwordScore += subwordFeatures.scoreToken(DSStringView(token));
+                worker.subwordScored++;
+            }
+            word++;
+        }
+        int score = frozenScore(tokens[t], quantizedSum, subwordScore, model, worker);
+        scores[pending[t]] = score;
+        if (predictionCache.isEnabled()) {
+            predictionCache.insert(cacheKeys[t], score);
+        }
+    }
+}
+
+/**
+ * Reads a CSV input in batches and parses every batch in parallel
+ * 
+ * @param input Open reader positioned at the start of the file
+ * @param skipHeader True to skip the first record (the CSV header)
+ * @param parseRecord Called for every record on the thread of its chunk
+ * @param mergeChunk Called with each chunk's slot after every batch
+ * @param firstSlot Slot of the first chunk
+ * @param numSlots Maximum number of chunks per batch
+ * @param mergeLock Held around the merges if not null
+ * @return False if reading the input failed
+ */
+bool SentimentClassifier::parseInBatches(InputReader& input, bool skipHeader,
+                                         const std::function<void(int, const DSString&)>& parseRecord,
+                                         const std::function<void(int)>& mergeChunk,
+                                         int firstSlot, int numSlots, std::mutex* mergeLock) {
+    CsvChunker chunker(numSlots);
+    std::vector<size_t> boundaries;
+    std::string batch;
+    size_t start = 0;           // Offset of the first unparsed record in batch
+    bool headerSkipped = !skipHeader;
+    bool atEnd = false;
+    
+    while (!atEnd) {
+        // Read at least PARSE_BATCH_BYTES of new input behind any carried-over partial record
+        size_t target = batch.size() + PARSE_BATCH_BYTES;
+        while (batch.size() < target) {
+            if (!input.readBytes(batch)) {
+                atEnd = true;
+                break;
+            }
+        }
+        
+        // Skip the header record
+        if (!headerSkipped) {
+            size_t headerEnd = CsvChunker::recordEnd(batch.data(), 0, batch.size());
+            if (headerEnd == batch.size() && !atEnd) {
+                continue; // Header not complete yet
+            }
+            start = (headerEnd < batch.size()) ? headerEnd + 1 : batch.size();
+            headerSkipped = true;
+        }
+        
+        // Split on record boundaries; an incomplete last record stays in the batch
+        const char* data = batch.data() + start;
+        chunker.split(data, batch.size() - start, numSlots, atEnd, boundaries);
+        int numChunks = static_cast<int>(boundaries.size()) - 1;
+        
+        auto parseChunk = [&](int chunk) {
+            if (numaPinning()) {
+                numaTopology.pinCurrentThread(workers[firstSlot + chunk].node);
+            }
+            auto chunkStart = std::chrono::steady_clock::now();
+            size_t position = boundaries[chunk];
+            size_t end = boundaries[chunk + 1];
+            while (position < end) {
+                size_t recordEnd = CsvChunker::recordEnd(data, position, end);
+                parseRecord(firstSlot + chunk, DSString(data + position, static_cast<int>(recordEnd - position)));
+                position = recordEnd + 1;
+            }
+            workers[firstSlot + chunk].chunkLatency.record(std::chrono::steady_clock::now() - chunkStart);
+        };
+        std::vector<std::thread> threads;
+        for (int chunk = 1; chunk < numChunks; chunk++) {
+            threads.emplace_back(parseChunk, chunk);
+        }
+        parseChunk(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        if (mergeLock != nullptr) {
+            mergeLock->lock();
+        }
+        for (int chunk = 0; chunk < numChunks; chunk++) {
+            mergeChunk(firstSlot + chunk);
+        }
+        if (mergeLock != nullptr) {
+            mergeLock->unlock();
+        }
+        
+        batch.erase(0, start + boundaries[numChunks]);
+        start = 0;
+    }
+    
+    return !input.hasError();
+}
+
+/**
+ * Parses every record of an input set
+ * 
+ * @param inputs Files to parse
+ * @param role Kind of input ("training", "test"), for messages
+ * @param parseRecord Called as parseRecord(slot, record) for every record
+ * @param mergeChunk Called with a slot whose parsed records are ready
+ * @return False if a file could not be read
+ */
+bool SentimentClassifier::parseInputs(const InputSet& inputs, const char* role,
+                                      const std::function<void(int, const DSString&)>& parseRecord,
+                                      const std::function<void(int)>& mergeChunk) {
+    std::ostringstream stats;
+    
+    // One file: every thread works on each batch of it
+    if (inputs.size() == 1) {
+        const InputFile& file = inputs[0];
+        InputReader reader(readQueueDepth, readBlockSize);
+        if (!reader.open(file.path, file.begin, file.end)) {
+            std::cerr << "Error opening " << role << " file: " << file.path << std::endl;
+            return false;
+        }
+        bool ok = parseInBatches(reader, file.hasHeader(), parseRecord, mergeChunk, 0, numThreads, nullptr);
+        reader.close();
+        if (numaPinning()) {
+            numaTopology.unpinCurrentThread();
+        }
+        if (!ok) {
+            std::cerr << "Error reading " << role << " file: " << file.path << std::endl;
+            return false;
+        }
+        stats << "Input: " << InputReader::formatName(reader.getFormat()) << ", read via "
+              << reader.readMethod() << " (queue depth " << readQueueDepth << ", "
+              << (readBlockSize >> 10) << " KiB blocks)";
+        inputStats = stats.str();
+        return true;
+    }
+    
+    // Several files: each thread takes the next largest file and parses it alone
+    InputSet ordered = inputs;
+    ordered.sortLargestFirst();
+    int poolSize = (static_cast<size_t>(numThreads) < ordered.size()) ? numThreads : static_cast<int>(ordered.size());
+    std::atomic<size_t> nextFile(0);
+    std::atomic<bool> failed(false);
+    std::mutex mergeLock;
+    
+    auto parseFiles = [&](int slot) {
+        InputReader reader(readQueueDepth, readBlockSize);
+        size_t index;
+        while (!failed && (index = nextFile++) < ordered.size()) {
+            const InputFile& file = ordered[index];
+            bool ok = reader.open(file.path, file.begin, file.end) &&
+                      parseInBatches(reader, file.hasHeader(), parseRecord, mergeChunk, slot, 1, &mergeLock);
+            reader.close();
+            if (!ok) {
+                std::lock_guard<std::mutex> guard(mergeLock);
+                std::cerr << "Error reading " << role << " file: " << file.path << std::endl;
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int slot = 1; slot < poolSize; slot++) {
+        threads.emplace_back(parseFiles, slot);
+    }
+    parseFiles(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if (numaPinning()) {
+        numaTopology.unpinCurrentThread();
+    }
+    
+    stats << "Input: " << ordered.size() << " files, " << (ordered.totalBytes() >> 20)
+          << " MiB on disk, parsed largest first by " << poolSize << " threads";
+    inputStats = stats.str();
+    return !failed;
+}
+
+/**
+ * Resets the per-thread counters and stem cache statistics
+ */
+void SentimentClassifier::resetWorkerStats() {
+    for (WorkerState& worker : workers) {
+        worker.stemCache.resetStats();
+        worker.tokens = 0;
+        worker.tokenizeSeconds = 0.0;
+        worker.subwordScored = 0;
+        worker.positiveTweets = 0;
+        worker.negativeTweets = 0;
+        worker.parityTweets = 0;
+        worker.parityMismatches = 0;
+        worker.parityError = 0.0;
+        worker.probes = FrozenProbeStats();
+        worker.tweetsPredicted = 0;
+        worker.predictSeconds = 0.0;
+        worker.tweetLatency.reset();
+        worker.chunkLatency.reset();
+    }
+}
+
+/**
+ * Sums the per-thread counters into the phase totals
+ */
+void SentimentClassifier::collectWorkerStats() {
+    tokensProcessed = 0;
+    tokenizeSeconds = 0.0;
+    subwordTokensScored = 0;
+    parityTweets = 0;
+    parityMismatches = 0;
+    parityError = 0.0;
+    frozenProbes = FrozenProbeStats();
+    for (const WorkerState& worker : workers) {
+        tokensProcessed += worker.tokens;
+        tokenizeSeconds += worker.tokenizeSeconds;
+        subwordTokensScored += worker.subwordScored;
+        parityTweets += worker.parityTweets;
+        parityMismatches += worker.parityMismatches;
+        parityError += worker.parityError;
+        frozenProbes.hotHits += worker.probes.hotHits;
+        frozenProbes.coldHits += worker.probes.coldHits;
+        frozenProbes.misses += worker.probes.misses;
+        frozenProbes.bloomSkipped += worker.probes.bloomSkipped;
+        frozenProbes.bloomPassed += worker.probes.bloomPassed;
+    }
+}
+
 /**
  * Trains the sentiment classifier on labeled data
  * 
- * @param trainingDataFile Path to the training CSV file
+ * @param trainingData Training CSV file, directory, glob pattern or @manifest
  * @return True if training was successful, false otherwise
  */
-bool SentimentClassifier::train(const DSString& trainingDataFile) {
-    // Open the training file
-    std::ifstream inFile(trainingDataFile.c_str());
-    if (!inFile.is_open()) {
+bool SentimentClassifier::train(const DSString& trainingData) {
+    InputSet inputs;
+    if (!inputs.add(trainingData)) {
+        return false;
+    }
+    return train(inputs);
+}
+
+/**
+ * Splits training input into shards for training in separate processes
+ * 
+ * @param inputs Training files
+ * @param numShards Number of shards
+ * @param shards Set to numShards input sets
+ * @return False if the input cannot be sharded
+ */
+bool SentimentClassifier::planShards(const InputSet& inputs, int numShards,
+                                     std::vector<InputSet>& shards) const {
+    if (inputs.size() != 1) {
+        inputs.assignShards(numShards, shards);
+        return true;
+    }
+    
+    // A single file is split into byte ranges
+    const DSString& trainingDataFile = inputs[0].path;
+    shards.assign(numShards, InputSet());
+    int fd = ::open(trainingDataFile.c_str(), O_RDONLY);
+    if (fd < 0) {
         std::cerr << "Error opening training file: " << trainingDataFile.c_str() << std::endl;
         return false;
     }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        std::cerr << "Error: sharded training needs a regular file: " << trainingDataFile.c_str() << std::endl;
+        ::close(fd);
+        return false;
+    }
+    size_t length = static_cast<size_t>(info.st_size);
+    if (length == 0) {
+        for (InputSet& shard : shards) {
+            shard.addRange(trainingDataFile, 0, 0);
+        }
+        ::close(fd);
+        return true;
+    }
     
-    // Read the file line by line
-    std::string line;
-    bool isFirstLine = true; // Skip header line
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error mapping training file: " << trainingDataFile.c_str() << std::endl;
+        return false;
+    }
+    const char* data = static_cast<const char*>(mapped);
     
-    while (std::getline(inFile, line)) {
-        // Skip the header line
-        if (isFirstLine) {
-            isFirstLine = false;
-            continue;
+    // Compressed streams cannot be split at byte offsets
+    if (InputReader::detectFormat(data, (length < 4) ? static_cast<int>(length) : 4) != INPUT_PLAIN) {
+        std::cerr << "Error: a single compressed file cannot be sharded (pass several files instead): "
+                  << trainingDataFile.c_str() << std::endl;
+        munmap(mapped, length);
+        return false;
+    }
+    
+    // Shards start after the header and end on record boundaries
+    size_t headerEnd = CsvChunker::recordEnd(data, 0, length);
+    size_t start = (headerEnd < length) ? headerEnd + 1 : length;
+    CsvChunker chunker(numThreads);
+    std::vector<size_t> chunks;
+    chunker.split(data + start, length - start, numShards, true, chunks);
+    munmap(mapped, length);
+    
+    // split() returns fewer chunks for tiny files; pad with empty shards
+    std::vector<size_t> boundaries(numShards + 1, length);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        boundaries[i] = start + chunks[i];
+    }
+    for (int i = 0; i < numShards; i++) {
+        shards[i].addRange(trainingDataFile, boundaries[i], boundaries[i + 1]);
+    }
+    return true;
+}
+
+/**
+ * Trains on every file (or shard) of an input set
+ * 
+ * @param inputs Training files
+ * @return True if training was successful, false otherwise
+ */
+bool SentimentClassifier::train(const InputSet& inputs) {
+    // A frozen model would no longer match the counts
+    clearFrozenModel();
+    
+    // Tokenizer statistics are reported per phase
+    resetWorkerStats();
+    
+    // Size the duplicate filter from the file size (no tweet line is shorter than 32 bytes)
+    // Pipes have no size, so assume 64 MiB of input for them
+    if (dedupeMode != DEDUPE_OFF) {
+        size_t fileBytes = inputs.totalEstimate();
+        if (fileBytes == 0) {
+            fileBytes = static_cast<size_t>(64) << 20;
         }
-        
-        // Convert std::string to DSString
-        DSString dsLine(line.c_str());
-        
+        deduplicator.configure(dedupeMode, fileBytes / 32 + 1);
+    }
+    
+    // Size the shared table from the input size: vocabulary grows roughly with
+    // the square root of the text (Heaps' law); overflow beyond it still counts
+    bool shared = sharedVocabularyEnabled;
+    if (shared) {
+        double fileBytes = static_cast<double>(inputs.totalEstimate());
+        size_t expectedWords = static_cast<size_t>(64.0 * std::sqrt(fileBytes));
+        sharedVocabulary.reserve((expectedWords > 65536) ? expectedWords : 65536, numThreads, sharedVocabularyPages);
+    }
+    
+    // Tweets parsed and tokenized by each slot (chunk or file) of the current batch
+    struct ParsedTweet {
+        int sentiment;
+        std::vector<DSString> tokens;
+        TweetDeduplicator::Keys dedupeKeys;     // Hashed here, inserted by the merge
+    };
+    std::vector<std::vector<ParsedTweet>> parsed(numThreads);
+    
+    // Runs in parallel: parse one CSV record and tokenize its text
+    auto parseRecord = [&](int chunk, const DSString& line) {
         // Parse the CSV line (with sentiment)
-        std::vector<DSString> fields = parseCSVLine(dsLine, true);
+        std::vector<DSString> fields = parseCSVLine(line, true);
         
         // Ensure we have enough fields (at least sentiment and text)
         if (fields.size() < 6) {
-            continue; // Skip malformed lines
+            return; // Skip malformed lines
         }
         
         // Extract sentiment and text
         DSString sentimentStr = fields[0];
-        DSString tweetID = fields[1];
         DSString tweetText = fields[5]; // The text is the 6th field (index 5)
         
         // Convert sentiment to integer (0 for negative, 4 for positive)
-        int sentiment = 0;
-        if (sentimentStr[0] == '4') {
-            sentiment = 4;
-            totalPositiveTweets++;
-        } else {
-            totalNegativeTweets++;
-        }
+        ParsedTweet tweet;
+        tweet.sentiment = (sentimentStr[0] == '4') ? 4 : 0;
         
         // Tokenize the tweet
-        std::vector<DSString> tokens = tokenizeTweet(tweetText);
+        WorkerState& worker = workers[chunk];
+        auto tokenizeStart = std::chrono::steady_clock::now();
+        tweet.tokens = tokenizeTweet(tweetText, worker.stemCache);
+        worker.tokenizeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - tokenizeStart).count();
+        worker.tokens += tweet.tokens.size();
         
-        // Update word frequency counts based on sentiment
-        for (const DSString& token : tokens) {
-            // Skip very short words (likely not meaningful)
-            if (token.size() <= 1) {
-                continue;
+        // Fingerprint or MinHash band keys, hashed on this thread
+        deduplicator.computeKeys(tweet.tokens, tweet.dedupeKeys);
+        
+        // Shared table: count the words right here, on the parser thread
+        // (the duplicate check too, so a tweet's words are counted at most once)
+        if (shared) {
+            if (deduplicator.isDuplicate(tweet.dedupeKeys)) {
+                return;
+            }
+            bool positive = (tweet.sentiment == 4);
+            for (const DSString& token : tweet.tokens) {
+                if (token.size() > 1) {
+                    sharedVocabulary.add(chunk, token.c_str(), token.size(), positive);
+                }
+            }
+            if (positive) {
+                worker.positiveTweets++;
+            } else {
+                worker.negativeTweets++;
             }
+            if (!subwordEnabled) {
+                return; // Nothing left for the merge
+            }
+        }
+        
+        parsed[chunk].push_back(std::move(tweet));
+    };
+    
+    // Runs serially (in input order within a file): count the parsed tweets
+    auto mergeChunk = [&](int chunk) {
+        for (const ParsedTweet& tweet : parsed[chunk]) {
+            const std::vector<DSString>& tokens = tweet.tokens;
+            int sentiment = tweet.sentiment;
             
-            // Get the current counts for this word
-            auto& counts = wordSentimentCounts[token];
+            // Words were already counted by the parser threads into the shared table
+            if (!shared) {
+                // Skip retweets and copies of tweets already counted (in input order)
+                if (deduplicator.isDuplicate(tweet.dedupeKeys)) {
+                    continue;
+                }
+                
+                if (sentiment == 4) {
+                    totalPositiveTweets++;
+                } else {
+                    totalNegativeTweets++;
+                }
+                
+                // Update word frequency counts based on sentiment
+                for (const DSString& token : tokens) {
+                    // Skip very short words (likely not meaningful)
+                    if (token.size() <= 1) {
+                        continue;
+                    }
+                    
+                    // Get the current counts for this word
+                    auto& counts = wordSentimentCounts[token];
+                    
+                    // Update positive or negative count
+                    if (sentiment == 4) {
+                        counts.first++; // Increment positive count
+                    } else {
+                        counts.second++; // Increment negative count
+                    }
+                }
+            }
             
-            // Update positive or negative count
-            if (sentiment == 4) {
-                counts.first++; // Increment positive count
-            } else {
-                counts.second++; // Increment negative count
+            // Update character n-gram counts for the same tokens
+            if (subwordEnabled) {
+                auto subwordStart = std::chrono::steady_clock::now();
+                for (const DSString& token : tokens) {
+                    if (token.size() > 1) {
+                        subwordFeatures.addToken(DSStringView(token), sentiment == 4);
+                        subwordTokensTrained++;
+                    }
+                }
+                subwordSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - subwordStart).count();
             }
         }
+        parsed[chunk].clear();
+    };
+    
+    bool readFailed = !parseInputs(inputs, "training", parseRecord, mergeChunk);
+    collectWorkerStats();
+    if (readFailed) {
+        return false;
     }
     
-    inFile.close();
+    // Fold the shared table into the model
+    if (shared) {
+        auto foldStart = std::chrono::steady_clock::now();
+        for (const WorkerState& worker : workers) {
+            totalPositiveTweets += worker.positiveTweets;
+            totalNegativeTweets += worker.negativeTweets;
+        }
+        sharedVocabulary.forEach([&](const DSString& word, int positive, int negative) {
+            auto& counts = wordSentimentCounts[word];
+            counts.first += positive;
+            counts.second += negative;
+        });
+        double foldSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - foldStart).count();
+        std::cout << "Shared vocabulary: " << sharedVocabulary.size() << " words in the table, "
+                  << sharedVocabulary.overflowWords() << " overflow, "
+                  << (sharedVocabulary.memoryBytes() >> 10) << " KiB ("
+                  << LargePageBuffer::describeBacking(sharedVocabulary.slotPages()) << "), folded in "
+                  << static_cast<long long>(foldSeconds * 1000.0) << " ms" << std::endl;
+        sharedVocabulary.reserve(0, 1);
+    }
     
     // Output some stats about the training
     std::cout << "Training complete. Processed " 
@@ -233,22 +1151,312 @@ bool SentimentClassifier::train(const DSString& trainingDataFile) {
               << totalPositiveTweets << " positive, "
               << totalNegativeTweets << " negative)." << std::endl;
     std::cout << "Vocabulary size: " << wordSentimentCounts.size() << " words." << std::endl;
+    printTokenizerStats("Training");
+    printInputStats();
+    deduplicator.printStats();
+    if (subwordEnabled) {
+        double tokensPerSecond = (subwordSeconds > 0.0) ? subwordTokensTrained / subwordSeconds : 0.0;
+        std::cout << "Subword n-grams: " << subwordTokensTrained << " tokens hashed, "
+                  << static_cast<long long>(tokensPerSecond) << " tokens/sec" << std::endl;
+    }
+    
+    return true;
+}
+
+/**
+ * Model file flags describing the current tokenizer settings
+ */
+unsigned int SentimentClassifier::modelFlags() const {
+    unsigned int flags = 0;
+    if (stemmingEnabled) {
+        flags |= MODEL_STEMMED;
+    }
+    if (negationEnabled) {
+        flags |= MODEL_NEGATION;
+    }
+    if (subwordEnabled) {
+        flags |= MODEL_SUBWORD;
+    }
+    return flags;
+}
+
+/**
+ * Writes the trained counts to a binary model file
+ * 
+ * @param modelFile Path of the model file to write
+ * @return True on success, false otherwise
+ */
+bool SentimentClassifier::saveModel(const DSString& modelFile) const {
+    ModelHeader header;
+    header.flags = modelFlags();
+    header.totalPositive = totalPositiveTweets;
+    header.totalNegative = totalNegativeTweets;
     
+    ModelWriter writer;
+    if (!writer.open(modelFile, header)) {
+        return false;
+    }
+    
+    // std::map iterates in DSString order, which is the order the format requires
+    for (const auto& entry : wordSentimentCounts) {
+        writer.writeWord(entry.first, entry.second.first, entry.second.second);
+    }
+    if (subwordEnabled) {
+        writer.writeSubword(subwordFeatures.getBucketBits(), subwordFeatures.getMinN(),
+                            subwordFeatures.getMaxN(), subwordFeatures.getCounts());
+    }
+    return writer.close();
+}
+
+/**
+ * Replaces the trained counts with those of a binary model file
+ * 
+ * @param modelFile Path of the model file to read
+ * @return True on success, false otherwise
+ */
+bool SentimentClassifier::loadModel(const DSString& modelFile) {
+    ModelReader reader;
+    if (!reader.open(modelFile)) {
+        return false;
+    }
+    
+    const ModelHeader& header = reader.getHeader();
+    if (header.flags != modelFlags()) {
+        std::cerr << "Error: " << modelFile << " was trained with different tokenizer options "
+                  << "(stemming " << ((header.flags & MODEL_STEMMED) ? "on" : "off")
+                  << ", negation " << ((header.flags & MODEL_NEGATION) ? "on" : "off")
+                  << ", subword n-grams " << ((header.flags & MODEL_SUBWORD) ? "on" : "off") << ")" << std::endl;
+        return false;
+    }
+    
+    // Records are sorted, so each insert goes at the end of the map
+    clearFrozenModel();
+    wordSentimentCounts.clear();
+    DSString word;
+    int positive;
+    int negative;
+    while (reader.nextWord(word, positive, negative)) {
+        wordSentimentCounts.emplace_hint(wordSentimentCounts.end(), word, std::make_pair(positive, negative));
+    }
+    if (reader.hasError()) {
+        return false;
+    }
+    
+    if (subwordEnabled) {
+        unsigned int bucketBits;
+        int minN;
+        int maxN;
+        std::vector<std::pair<int, int>> counts;
+        if (!reader.readSubword(bucketBits, minN, maxN, counts)) {
+            return false;
+        }
+        if (bucketBits != subwordFeatures.getBucketBits() || minN != subwordFeatures.getMinN() ||
+            maxN != subwordFeatures.getMaxN() || !subwordFeatures.setCounts(counts)) {
+            std::cerr << "Error: " << modelFile << " uses different subword parameters" << std::endl;
+            return false;
+        }
+    }
+    
+    totalPositiveTweets = static_cast<int>(header.totalPositive);
+    totalNegativeTweets = static_cast<int>(header.totalNegative);
+    std::cout << "Loaded model " << modelFile << ": " << wordSentimentCounts.size() << " words from "
+              << (totalPositiveTweets + totalNegativeTweets) << " tweets ("
+              << totalPositiveTweets << " positive, " << totalNegativeTweets << " negative)." << std::endl;
     return true;
 }
 
+/**
+ * Freezes the trained counts into the compact serving model
+ * 
+ * @param options Weight width, hot tier size and guard false-positive rate
+ * @return True on success, false otherwise
+ */
+bool SentimentClassifier::freezeModel(const FreezeOptions& options) {
+    FreezeStats stats;
+    FreezeOptions modelOptions = options;
+    modelOptions.tokenizerFlags = modelFlags();
+    clearFrozenModel();
+    if (!frozenModel.build(wordSentimentCounts, modelOptions, stats)) {
+        return false;
+    }
+    frozenPages = options.hugePages;
+    
+    std::streamsize oldPrecision = std::cout.precision();
+    double percent = (stats.words > 0) ? 100.0 / stats.words : 0.0;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Frozen model: " << stats.words << " words, int" << stats.weightBits
+              << " weights, scale " << stats.scale << std::endl;
+    std::cout << "  Weights: " << (stats.weightBytes >> 10) << " KiB (was "
+              << (stats.fullWeightBytes >> 10) << " KiB of count pairs), whole model "
+              << (stats.totalBytes >> 10) << " KiB (" << LargePageBuffer::describeBacking(stats.pages) << ")" << std::endl;
+    std::cout << "  Quantization: " << stats.wide << " in the int32 side table (" << stats.wide * percent
+              << "%), " << stats.zeroed << " rounded to zero (" << stats.zeroed * percent << "%)" << std::endl;
+    std::cout << "  Hot tier: " << stats.hotWords << " most frequent words in " << (stats.hotBytes >> 10)
+              << " KiB, " << stats.hotShare * 100.0 << "% of training tokens" << std::endl;
+    if (stats.bloomBytes > 0) {
+        std::cout << "  Cold-word guard: " << (stats.bloomBytes >> 10) << " KiB Bloom filter, " << stats.bloomHashes
+                  << " hashes, " << stats.bloomFalsePositiveRate * 100.0 << "% expected false positives" << std::endl;
+    }
+    std::cout << std::defaultfloat << std::setprecision(oldPrecision);
+    
+    replicateFrozenModel();
+    return true;
+}
+
+/**
+ * Publishes the frozen model in a POSIX shared memory segment
+ * 
+ * @param name Segment name
+ * @return True on success, false otherwise
+ */
+bool SentimentClassifier::publishModel(const DSString& name) const {
+    if (!frozenModel.publish(name.c_str())) {
+        return false;
+    }
+    std::cout << "Published frozen model as shared memory segment " << name << " ("
+              << (frozenModel.sizeBytes() >> 10) << " KiB)" << std::endl;
+    return true;
+}
+
+/**
+ * Uses a frozen model published by another process instead of training
+ * 
+ * @param name Segment name
+ * @return True on success, false otherwise
+ */
+bool SentimentClassifier::attachModel(const DSString& name) {
+    if (subwordEnabled) {
+        std::cerr << "Error: subword n-grams are not part of a shared frozen model" << std::endl;
+        return false;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    clearFrozenModel();
+    if (!frozenModel.attach(name.c_str())) {
+        return false;
+    }
+    unsigned int flags = frozenModel.getTokenizerFlags();
+    if (flags != modelFlags()) {
+        std::cerr << "Error: " << name << " was frozen with different tokenizer options "
+                  << "(stemming " << ((flags & MODEL_STEMMED) ? "on" : "off")
+                  << ", negation " << ((flags & MODEL_NEGATION) ? "on" : "off")
+                  << ", subword n-grams " << ((flags & MODEL_SUBWORD) ? "on" : "off") << ")" << std::endl;
+        clearFrozenModel();
+        return false;
+    }
+    
+    // The counts are not needed: prediction only reads the frozen model
+    wordSentimentCounts.clear();
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Attached shared model " << name << ": " << frozenModel.numWords() << " words, "
+              << (frozenModel.sizeBytes() >> 10) << " KiB, in " << milliseconds << " ms" << std::endl;
+    
+    replicateFrozenModel();
+    return true;
+}
+
+/**
+ * Copies the frozen model onto every NUMA node when replicating
+ * Each copy is written by a thread pinned to its node, so the kernel's
+ * first-touch policy places its pages in that node's memory.
+ */
+void SentimentClassifier::replicateFrozenModel() {
+    if (numaMode != NUMA_REPLICATE || !numaPinning() || !frozenModel.isFrozen()) {
+        return;
+    }
+    int numNodes = numaTopology.numNodes();
+    frozenReplicas.clear();
+    for (int node = 0; node < numNodes; node++) {
+        frozenReplicas.emplace_back(new FrozenModel());
+    }
+    
+    std::vector<std::thread> threads;
+    for (int node = 0; node < numNodes; node++) {
+        threads.emplace_back([this, node]() {
+            numaTopology.pinCurrentThread(node);
+            frozenReplicas[node]->copyFrom(frozenModel, frozenPages);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::cout << "  Replicated on " << numNodes << " NUMA nodes (" << (frozenModel.sizeBytes() >> 10)
+              << " KiB each)" << std::endl;
+}
+
+/**
+ * Discards the frozen model and its replicas
+ */
+void SentimentClassifier::clearFrozenModel() {
+    frozenReplicas.clear();
+    frozenModel.clear();
+}
+
+/**
+ * Prints prediction throughput per NUMA node
+ */
+void SentimentClassifier::printNodeStats() const {
+    int numNodes = numaPinning() ? numaTopology.numNodes() : 1;
+    for (int node = 0; node < numNodes; node++) {
+        int threads = 0;
+        long long tweets = 0;
+        double seconds = 0.0;
+        for (const WorkerState& worker : workers) {
+            if (worker.node == node) {
+                threads++;
+                tweets += worker.tweetsPredicted;
+                seconds += worker.predictSeconds;
+            }
+        }
+        std::cout << "NUMA node " << numaTopology.nodeId(node) << " (" << numaTopology.nodeCpus(node).size()
+                  << " CPUs" << (frozenReplicas.empty() ? "" : ", own model copy") << "): "
+                  << threads << " threads, " << tweets << " tweets";
+        if (seconds > 0.0) {
+            std::cout << ", " << static_cast<long long>(tweets / seconds) << " tweets/s per thread";
+        }
+        std::cout << std::endl;
+    }
+}
+
+/**
+ * Prints the latency percentiles of the parser threads, merged
+ */
+void SentimentClassifier::printLatencyStats() const {
+    LatencyHistogram tweetLatency;
+    LatencyHistogram chunkLatency;
+    for (const WorkerState& worker : workers) {
+        tweetLatency.merge(worker.tweetLatency);
+        chunkLatency.merge(worker.chunkLatency);
+    }
+    if (tweetLatency.count() > 0) {
+        std::cout << "Scoring latency per tweet: " << tweetLatency.summary() << std::endl;
+    }
+    if (chunkLatency.count() > 0) {
+        std::cout << "Latency per batch chunk (" << chunkLatency.count() << " chunks): " << chunkLatency.summary()
+                  << std::endl;
+    }
+}
+
+/**
+ * Enables the full-precision parity check for the frozen model
+ * 
+ * @param enabled True to run the parity check during prediction
+ */
+void SentimentClassifier::setFreezeCheckEnabled(bool enabled) {
+    freezeCheckEnabled = enabled;
+}
+
 /**
  * Predicts sentiments for tweets in test data
  * 
- * @param testDataFile Path to the test CSV file
+ * @param testData Test CSV file, directory, glob pattern or @manifest
  * @param predictionsOutputFile Path where prediction results will be written
  * @return True if prediction was successful, false otherwise
  */
-bool SentimentClassifier::predict(const DSString& testDataFile, const DSString& predictionsOutputFile) {
-    // Open the test file
-    std::ifstream inFile(testDataFile.c_str());
-    if (!inFile.is_open()) {
-        std::cerr << "Error opening test file: " << testDataFile.c_str() << std::endl;
+bool SentimentClassifier::predict(const DSString& testData, const DSString& predictionsOutputFile) {
+    // Expand the test input (plain, gzip or zstd files)
+    InputSet inputs;
+    if (!inputs.add(testData)) {
         return false;
     }
     
@@ -256,56 +1464,98 @@ bool SentimentClassifier::predict(const DSString& testDataFile, const DSString&
     std::ofstream outFile(predictionsOutputFile.c_str());
     if (!outFile.is_open()) {
         std::cerr << "Error opening predictions output file: " << predictionsOutputFile.c_str() << std::endl;
-        inFile.close();
         return false;
     }
     
-    // Read the file line by line
-    std::string line;
-    bool isFirstLine = true; // Skip header line
+    // Tokenizer statistics are reported per phase
+    resetWorkerStats();
+    predictionCache.resetStats();
     
-    while (std::getline(inFile, line)) {
-        // Skip the header line
-        if (isFirstLine) {
-            isFirstLine = false;
-            continue;
-        }
-        
-        // Convert std::string to DSString
-        DSString dsLine(line.c_str());
-        
+    // Predictions made by each slot (chunk or file) of the current batch: (tweetID, sentiment)
+    std::vector<std::vector<std::pair<DSString, int>>> results(numThreads);
+    
+    // Runs in parallel: parse one CSV record and score its text
+    auto predictRecord = [&](int chunk, const DSString& line) {
         // Parse the CSV line (without sentiment)
-        std::vector<DSString> fields = parseCSVLine(dsLine, false);
+        std::vector<DSString> fields = parseCSVLine(line, false);
         
         // Ensure we have enough fields (at least ID and text)
         if (fields.size() < 5) {
-            continue; // Skip malformed lines
+            return; // Skip malformed lines
         }
         
         // Extract tweet ID and text
         DSString tweetID = fields[0]; // ID is the first field
         DSString tweetText = fields[4]; // Text is the 5th field (index 4)
         
-        // Tokenize the tweet
-        std::vector<DSString> tokens = tokenizeTweet(tweetText);
-        
-        // Calculate sentiment score
-        int score = calculateSentimentScore(tokens);
+        // Calculate sentiment score (from the cache for repeated texts)
+        WorkerState& worker = workers[chunk];
+        auto scoreStart = std::chrono::steady_clock::now();
+        int score = scoreTweet(tweetText, worker);
+        auto scoreTime = std::chrono::steady_clock::now() - scoreStart;
+        worker.predictSeconds += std::chrono::duration<double>(scoreTime).count();
+        worker.tweetsPredicted++;
+        worker.tweetLatency.record(scoreTime);
         
         // Determine sentiment (4 for positive, 0 for negative)
         int predictedSentiment = (score > 0) ? 4 : 0;
-        
-        // Store the prediction
-        predictions[tweetID] = predictedSentiment;
-        
-        // Write prediction to output file: <sentiment>,<tweetID>
-        outFile << predictedSentiment << "," << tweetID << std::endl;
-    }
+        results[chunk].push_back(std::make_pair(tweetID, predictedSentiment));
+    };
+    
+    // Runs serially (in input order within a file): store and write the predictions
+    auto writeChunk = [&](int chunk) {
+        for (const auto& result : results[chunk]) {
+            // Store the prediction
+            predictions[result.first] = result.second;
+            
+            // Write prediction to output file: <sentiment>,<tweetID>
+            outFile << result.second << "," << result.first << std::endl;
+        }
+        results[chunk].clear();
+    };
     
-    inFile.close();
+    bool readFailed = !parseInputs(inputs, "test", predictRecord, writeChunk);
     outFile.close();
+    if (readFailed) {
+        return false;
+    }
     
+    collectWorkerStats();
     std::cout << "Prediction complete. Made predictions for " << predictions.size() << " tweets." << std::endl;
+    printTokenizerStats("Prediction");
+    printInputStats();
+    if (numaMode != NUMA_OFF) {
+        printNodeStats();
+    }
+    printLatencyStats();
+    predictionCache.printStats();
+    std::streamsize oldPrecision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(2);
+    long long frozenLookups = frozenProbes.hotHits + frozenProbes.coldHits + frozenProbes.misses;
+    if (frozenModel.isFrozen() && frozenLookups > 0) {
+        std::cout << "Frozen model lookups: " << frozenLookups << ", " << (100.0 * frozenProbes.hotHits / frozenLookups)
+                  << "% hot tier, " << (100.0 * frozenProbes.coldHits / frozenLookups) << "% cold tier, "
+                  << (100.0 * frozenProbes.misses / frozenLookups) << "% not in model" << std::endl;
+    }
+    long long guardChecks = frozenProbes.bloomSkipped + frozenProbes.bloomPassed;
+    if (frozenModel.isFrozen() && guardChecks > 0) {
+        long long falsePositives = frozenProbes.bloomPassed - frozenProbes.coldHits;
+        long long absent = frozenProbes.bloomSkipped + falsePositives;
+        std::cout << "Cold-word guard: skipped " << frozenProbes.bloomSkipped << " of " << guardChecks
+                  << " cold probes (" << (100.0 * frozenProbes.bloomSkipped / guardChecks) << "%), "
+                  << falsePositives << " false positives ("
+                  << (absent > 0 ? 100.0 * falsePositives / absent : 0.0) << "% of absent words)" << std::endl;
+    }
+    if (frozenModel.isFrozen() && freezeCheckEnabled && parityTweets > 0) {
+        std::cout << "Frozen model parity: " << parityMismatches << " of " << parityTweets
+                  << " scored tweets changed label (" << (100.0 * parityMismatches / parityTweets)
+                  << "%), mean score error " << (parityError / parityTweets) << std::endl;
+    }
+    std::cout << std::defaultfloat << std::setprecision(oldPrecision);
+    if (subwordEnabled) {
+        std::cout << "Subword n-grams: " << subwordTokensScored
+                  << " out-of-vocabulary tokens scored" << std::endl;
+    }
     
     return true;
 }
@@ -313,15 +1563,14 @@ bool SentimentClassifier::predict(const DSString& testDataFile, const DSString&
 /**
  * Evaluates prediction accuracy against ground truth
  * 
- * @param groundTruthFile Path to the file with actual sentiments
+ * @param groundTruth File(s) with actual sentiments
  * @param accuracyOutputFile Path where accuracy results will be written
  * @return True if evaluation was successful, false otherwise
  */
-bool SentimentClassifier::evaluatePredictions(const DSString& groundTruthFile, const DSString& accuracyOutputFile) {
-    // Open the ground truth file
-    std::ifstream truthFile(groundTruthFile.c_str());
-    if (!truthFile.is_open()) {
-        std::cerr << "Error opening ground truth file: " << groundTruthFile.c_str() << std::endl;
+bool SentimentClassifier::evaluatePredictions(const DSString& groundTruth, const DSString& accuracyOutputFile) {
+    // Expand the ground truth input (plain, gzip or zstd files)
+    InputSet truthFiles;
+    if (!truthFiles.add(groundTruth)) {
         return false;
     }
     
@@ -329,7 +1578,6 @@ bool SentimentClassifier::evaluatePredictions(const DSString& groundTruthFile, c
     std::ofstream accFile(accuracyOutputFile.c_str());
     if (!accFile.is_open()) {
         std::cerr << "Error opening accuracy output file: " << accuracyOutputFile.c_str() << std::endl;
-        truthFile.close();
         return false;
     }
     
@@ -340,47 +1588,62 @@ bool SentimentClassifier::evaluatePredictions(const DSString& groundTruthFile, c
     // Compare predictions to actual sentiments
     std::vector<std::tuple<int, int, DSString>> misclassifications; // (predicted, actual, tweetID)
     
-    // Read the ground truth file line by line
+    // Read each ground truth file line by line
+    InputReader truthFile(readQueueDepth, readBlockSize);
     std::string line;
-    bool isFirstLine = true; // Skip header line
-    
-    while (std::getline(truthFile, line)) {
-        // Skip the header line
-        if (isFirstLine) {
-            isFirstLine = false;
-            continue;
-        }
-        
-        // Convert std::string to DSString
-        DSString dsLine(line.c_str());
-        
-        // Parse the CSV line
-        std::vector<DSString> fields = parseCSVLine(dsLine, false);
-        
-        // Ensure we have enough fields (ID and sentiment)
-        if (fields.size() < 2) {
-            continue; // Skip malformed lines
+    for (size_t f = 0; f < truthFiles.size(); f++) {
+        const DSString& truthPath = truthFiles[f].path;
+        if (!truthFile.open(truthPath)) {
+            std::cerr << "Error opening ground truth file: " << truthPath.c_str() << std::endl;
+            return false;
         }
+        bool isFirstLine = true; // Skip header line
         
-        // Extract tweet ID and actual sentiment
-        DSString tweetID = fields[1]; // The ID is in the second column (index 1)
-        int actualSentiment = (fields[0][0] == '4') ? 4 : 0; // The sentiment is in the first column (index 0)
-        
-        // Lookup our prediction
-        auto it = predictions.find(tweetID);
-        if (it != predictions.end()) {
-            int predictedSentiment = it->second;
+        while (truthFile.readLine(line)) {
+            // Skip the header line
+            if (isFirstLine) {
+                isFirstLine = false;
+                continue;
+            }
             
-            // Increment total count
-            totalPredictions++;
+            // Convert std::string to DSString
+            DSString dsLine(line.c_str());
             
-            // Check if prediction matches actual sentiment
-            if (predictedSentiment == actualSentiment) {
-                correctPredictions++;
-            } else {
-                // Store misclassification
-                misclassifications.push_back(std::make_tuple(predictedSentiment, actualSentiment, tweetID));
+            // Parse the CSV line
+            std::vector<DSString> fields = parseCSVLine(dsLine, false);
+            
+            // Ensure we have enough fields (ID and sentiment)
+            if (fields.size() < 2) {
+                continue; // Skip malformed lines
             }
+            
+            // Extract tweet ID and actual sentiment
+            DSString tweetID = fields[1]; // The ID is in the second column (index 1)
+            int actualSentiment = (fields[0][0] == '4') ? 4 : 0; // The sentiment is in the first column (index 0)
+            
+            // Lookup our prediction
+            auto it = predictions.find(tweetID);
+            if (it != predictions.end()) {
+                int predictedSentiment = it->second;
+            
+                // Increment total count
+                totalPredictions++;
+            
+                // Check if prediction matches actual sentiment
+                if (predictedSentiment == actualSentiment) {
+                    correctPredictions++;
+                } else {
+                    // Store misclassification
+                    misclassifications.push_back(std::make_tuple(predictedSentiment, actualSentiment, tweetID));
+                }
+            }
+        }
+        
+        bool readFailed = truthFile.hasError();
+        truthFile.close();
+        if (readFailed) {
+            std::cerr << "Error reading ground truth file: " << truthPath.c_str() << std::endl;
+            return false;
         }
     }
     
@@ -400,7 +1663,6 @@ bool SentimentClassifier::evaluatePredictions(const DSString& groundTruthFile, c
         accFile << std::get<0>(mis) << "," << std::get<1>(mis) << "," << std::get<2>(mis) << std::endl;
     }
     
-    truthFile.close();
     accFile.close();
     
     std::cout << "Evaluation complete. Accuracy: " << (accuracy * 100.0) << "%" << std::endl;
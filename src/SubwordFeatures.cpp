@@ -0,0 +1,112 @@
+/**
+ * SubwordFeatures.cpp
+ *
+ * Implementation of the hashed character n-gram features declared in
+ * SubwordFeatures.h.
+ */
+
+#include "../include/SubwordFeatures.h"
+
+// Multiplier of the rolling polynomial hash (arithmetic is mod 2^32)
+static const unsigned int ROLLING_BASE = 257u;
+
+// Constructor - records the configuration; buckets are allocated lazily
+SubwordFeatures::SubwordFeatures(int bucketBits, int minN, int maxN) {
+    this->bucketBits = static_cast<unsigned int>(bucketBits);
+    this->minN = (minN < 1) ? 1 : minN;
+    this->maxN = (maxN < this->minN) ? this->minN : maxN;
+}
+
+// Computes the bucket index of every n-gram of the token
+int SubwordFeatures::hashNgrams(const DSStringView& token, unsigned int* buckets) const {
+    // The token is hashed as if wrapped in boundary markers: '<' token '>'
+    int paddedLength = token.size() + 2;
+    int numBuckets = 0;
+
+    for (int n = minN; n <= maxN && n <= paddedLength; n++) {
+        // BASE^(n-1), used to remove the byte leaving the window
+        unsigned int leadingPower = 1;
+        for (int i = 1; i < n; i++) {
+            leadingPower *= ROLLING_BASE;
+        }
+
+        // Distinct seed per n so "abc" as a 3-gram and a 4-gram prefix differ
+        unsigned int seed = static_cast<unsigned int>(n) * 0x9E3779B9u;
+        unsigned int hash = 0;
+
+        for (int p = 0; p < paddedLength; p++) {
+            unsigned char in = (p == 0) ? '<' : (p == paddedLength - 1) ? '>'
+                             : static_cast<unsigned char>(token[p - 1]);
+
+            // Slide the window: drop the byte n positions back, add the new one
+            if (p >= n) {
+                int q = p - n;
+                unsigned char out = (q == 0) ? '<' : static_cast<unsigned char>(token[q - 1]);
+                hash -= out * leadingPower;
+            }
+            hash = hash * ROLLING_BASE + in;
+
+            if (p >= n - 1) {
+                if (numBuckets == MAX_NGRAMS) {
+                    return numBuckets;
+                }
+                // Finalize with a multiplicative mix and keep the top bits
+                unsigned int mixed = (hash ^ seed) * 0x85EBCA6Bu;
+                mixed ^= mixed >> 13;
+                mixed *= 0xC2B2AE35u;
+                buckets[numBuckets++] = mixed >> (32 - bucketBits);
+            }
+        }
+    }
+    return numBuckets;
+}
+
+// Adds the n-grams of a training token to the bucket counts
+void SubwordFeatures::addToken(const DSStringView& token, bool positive) {
+    if (token.size() > MAX_TOKEN_LENGTH) {
+        return;
+    }
+
+    // Allocate the bucket array on first use
+    if (counts.empty()) {
+        counts.assign(static_cast<size_t>(1) << bucketBits, std::make_pair(0, 0));
+    }
+
+    unsigned int buckets[MAX_NGRAMS];
+    int numBuckets = hashNgrams(token, buckets);
+    for (int i = 0; i < numBuckets; i++) {
+        if (positive) {
+            counts[buckets[i]].first++;
+        } else {
+            counts[buckets[i]].second++;
+        }
+    }
+}
+
+// Scores a token from its n-grams alone
+int SubwordFeatures::scoreToken(const DSStringView& token) const {
+    if (counts.empty() || token.size() > MAX_TOKEN_LENGTH) {
+        return 0;
+    }
+
+    unsigned int buckets[MAX_NGRAMS];
+    int numBuckets = hashNgrams(token, buckets);
+    if (numBuckets == 0) {
+        return 0;
+    }
+
+    long long total = 0;
+    for (int i = 0; i < numBuckets; i++) {
+        total += counts[buckets[i]].first - counts[buckets[i]].second;
+    }
+    return static_cast<int>(total / numBuckets);
+}
+
+// Replaces the bucket counts
+bool SubwordFeatures::setCounts(std::vector<std::pair<int, int>>& newCounts) {
+    if (newCounts.size() != (static_cast<size_t>(1) << bucketBits)) {
+        return false;
+    }
+    counts.swap(newCounts);
+    return true;
+}
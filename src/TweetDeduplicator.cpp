@@ -0,0 +1,166 @@
+/**
+ * TweetDeduplicator.cpp
+ *
+ * Implementation of the training-set deduplicator declared in TweetDeduplicator.h.
+ */
+
+#include "../include/TweetDeduplicator.h"
+#include "../include/Hash64.h"
+#include <iostream>
+#include <iomanip>
+#include <cstring> // For strcmp on mode names
+
+// Default constructor - deduplication off
+TweetDeduplicator::TweetDeduplicator() : mode(DEDUPE_OFF), checked(0), duplicates(0) {
+}
+
+// Selects the mode and sizes the underlying structures
+void TweetDeduplicator::configure(DedupeMode mode, size_t expectedTweets) {
+    this->mode = mode;
+    checked.store(0);
+    duplicates.store(0);
+
+    if (mode == DEDUPE_EXACT) {
+        seen.reserve(expectedTweets);
+    } else if (mode == DEDUPE_MINHASH) {
+        seen.reserve(expectedTweets * LSH_BANDS);
+    } else if (mode == DEDUPE_BLOOM) {
+        // About 7 bits set per key keeps ~1% false positives up to 3.5M tweets
+        bloom.initWithMemory(BLOOM_MEMORY_BYTES, 7);
+    }
+}
+
+// 64-bit fingerprint of a token sequence
+uint64_t TweetDeduplicator::fingerprint(const std::vector<DSString>& tokens) const {
+    // Chaining keeps token order and boundaries ("ab c" differs from "a bc")
+    uint64_t hash = 0;
+    for (const DSString& token : tokens) {
+        hash = hash64(token.c_str(), token.size(), hash);
+    }
+    return hash;
+}
+
+// LSH band keys of the tweet's MinHash signature
+void TweetDeduplicator::minHashBands(const std::vector<DSString>& tokens, uint64_t* bands) const {
+    // Signature: for each of NUM_MINHASHES hash functions, the minimum over the
+    // tweet's word bigrams (a single-token tweet uses its one token)
+    uint64_t signature[NUM_MINHASHES];
+    for (int i = 0; i < NUM_MINHASHES; i++) {
+        signature[i] = ~0ull;
+    }
+    uint64_t previous = hash64(tokens[0].c_str(), tokens[0].size());
+    size_t numShingles = (tokens.size() > 1) ? tokens.size() - 1 : 1;
+    for (size_t t = 0; t < numShingles; t++) {
+        uint64_t base = previous;
+        if (t + 1 < tokens.size()) {
+            uint64_t next = hash64(tokens[t + 1].c_str(), tokens[t + 1].size());
+            base = mix64(previous * 31 + next);
+            previous = next;
+        }
+        for (int i = 0; i < NUM_MINHASHES; i++) {
+            uint64_t h = mix64(base + static_cast<uint64_t>(i + 1) * 0x9E3779B97F4A7C15ull);
+            if (h < signature[i]) {
+                signature[i] = h;
+            }
+        }
+    }
+
+    // Each band of LSH_ROWS minimums becomes one key, salted by the band index
+    for (int band = 0; band < LSH_BANDS; band++) {
+        bands[band] = hash64(reinterpret_cast<const char*>(signature + band * LSH_ROWS),
+                             LSH_ROWS * sizeof(uint64_t), static_cast<uint64_t>(band));
+    }
+}
+
+// Computes the set keys of a tweet without recording it
+void TweetDeduplicator::computeKeys(const std::vector<DSString>& tokens, Keys& keys) const {
+    keys.count = 0;
+    if (mode == DEDUPE_OFF || tokens.empty()) {
+        return;
+    }
+    if (mode == DEDUPE_MINHASH) {
+        minHashBands(tokens, keys.values);
+        keys.count = LSH_BANDS;
+    } else {
+        keys.values[0] = fingerprint(tokens);
+        keys.count = 1;
+    }
+}
+
+// Records a tweet and reports whether it was seen before
+bool TweetDeduplicator::isDuplicate(const std::vector<DSString>& tokens) {
+    Keys keys;
+    computeKeys(tokens, keys);
+    return isDuplicate(keys);
+}
+
+// Records a tweet by its precomputed keys
+bool TweetDeduplicator::isDuplicate(const Keys& keys) {
+    if (keys.count == 0) {
+        return false;
+    }
+    checked.fetch_add(1, std::memory_order_relaxed);
+
+    // Every band key is inserted, even after one is found
+    bool duplicate = false;
+    for (int i = 0; i < keys.count; i++) {
+        bool present = (mode == DEDUPE_BLOOM) ? bloom.insert(keys.values[i]) : !seen.insert(keys.values[i]);
+        if (present) {
+            duplicate = true;
+        }
+    }
+
+    if (duplicate) {
+        duplicates.fetch_add(1, std::memory_order_relaxed);
+    }
+    return duplicate;
+}
+
+// Prints the number of tweets checked and skipped, and memory used
+void TweetDeduplicator::printStats() const {
+    if (mode == DEDUPE_OFF) {
+        return;
+    }
+    long long numChecked = checked.load();
+    long long numDuplicates = duplicates.load();
+    size_t memory = (mode == DEDUPE_BLOOM) ? bloom.memoryBytes() : seen.memoryBytes();
+
+    std::cout << "Deduplication (" << modeName(mode) << "): " << numDuplicates
+              << " of " << numChecked << " tweets skipped as duplicates, "
+              << memory / 1024 << " KB";
+    if (mode == DEDUPE_BLOOM) {
+        std::streamsize oldPrecision = std::cout.precision();
+        std::cout << ", estimated false-positive rate " << std::fixed << std::setprecision(4)
+                  << bloom.estimatedFalsePositiveRate(static_cast<size_t>(numChecked - numDuplicates)) * 100.0 << "%"
+                  << std::defaultfloat << std::setprecision(oldPrecision);
+    } else if (seen.getOverflows() > 0) {
+        std::cout << ", " << seen.getOverflows() << " fingerprints dropped (set full)";
+    }
+    std::cout << std::endl;
+}
+
+// Parses a mode name
+bool TweetDeduplicator::parseMode(const char* name, DedupeMode& mode) {
+    if (std::strcmp(name, "exact") == 0) {
+        mode = DEDUPE_EXACT;
+    } else if (std::strcmp(name, "bloom") == 0) {
+        mode = DEDUPE_BLOOM;
+    } else if (std::strcmp(name, "minhash") == 0) {
+        mode = DEDUPE_MINHASH;
+    } else if (std::strcmp(name, "off") == 0) {
+        mode = DEDUPE_OFF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Returns the name of a mode
+const char* TweetDeduplicator::modeName(DedupeMode mode) {
+    switch (mode) {
+        case DEDUPE_EXACT: return "exact";
+        case DEDUPE_BLOOM: return "bloom";
+        case DEDUPE_MINHASH: return "minhash";
+        default: return "off";
+    }
+}
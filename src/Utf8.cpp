@@ -0,0 +1,340 @@
+/**
+ * Utf8.cpp
+ *
+ * Implementation of the UTF-8 helpers declared in Utf8.h.
+ * The block helpers use SSE2 when the compiler targets it (all x86-64 builds)
+ * and a plain byte loop otherwise.
+ */
+
+#include "../include/Utf8.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Helper function: ASCII delimiter test (space and all ASCII punctuation)
+ */
+static bool isAsciiDelimiter(unsigned char c) {
+    return (c >= 0x20 && c <= 0x2F) || (c >= 0x3A && c <= 0x40) ||
+           (c >= 0x5B && c <= 0x60) || (c >= 0x7B && c <= 0x7E);
+}
+
+/**
+ * Helper function: ASCII clause punctuation test
+ */
+static bool isAsciiClauseBoundary(unsigned char c) {
+    return c == ',' || c == '.' || c == '!' || c == '?' || c == ';' || c == ':';
+}
+
+/**
+ * Emoji and pictographic code point ranges (inclusive, sorted, non-overlapping)
+ * Based on the Unicode Extended_Pictographic property, with whole blocks
+ * merged where they are entirely pictographic.
+ */
+static const int EMOJI_RANGES[][2] = {
+    {0x00A9, 0x00A9}, {0x00AE, 0x00AE}, {0x203C, 0x203C}, {0x2049, 0x2049},
+    {0x2122, 0x2122}, {0x2139, 0x2139}, {0x2194, 0x2199}, {0x21A9, 0x21AA},
+    {0x231A, 0x231B}, {0x2328, 0x2328}, {0x23CF, 0x23CF}, {0x23E9, 0x23F3},
+    {0x23F8, 0x23FA}, {0x24C2, 0x24C2}, {0x25AA, 0x25AB}, {0x25B6, 0x25B6},
+    {0x25C0, 0x25C0}, {0x25FB, 0x25FE}, {0x2600, 0x27BF}, {0x2934, 0x2935},
+    {0x2B05, 0x2B07}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+    {0x3030, 0x3030}, {0x303D, 0x303D}, {0x3297, 0x3297}, {0x3299, 0x3299},
+    {0x1F000, 0x1F3FA}, {0x1F400, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7FF},
+    {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF}
+};
+
+static const int NUM_EMOJI_RANGES = sizeof(EMOJI_RANGES) / sizeof(EMOJI_RANGES[0]);
+
+// Decodes one UTF-8 encoded character
+int utf8Decode(const char* str, int remaining, int& codePoint) {
+    unsigned char lead = static_cast<unsigned char>(str[0]);
+
+    // ASCII
+    if (lead < 0x80) {
+        codePoint = lead;
+        return 1;
+    }
+
+    // Determine sequence length and the payload bits of the lead byte
+    int length;
+    int value;
+    int minimum;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2; value = lead & 0x1F; minimum = 0x80;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3; value = lead & 0x0F; minimum = 0x800;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4; value = lead & 0x07; minimum = 0x10000;
+    } else {
+        // Stray continuation byte or invalid lead byte
+        codePoint = -1;
+        return 1;
+    }
+
+    if (length > remaining) {
+        codePoint = -1;
+        return 1;
+    }
+
+    // Accumulate continuation bytes
+    for (int i = 1; i < length; i++) {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        if ((c & 0xC0) != 0x80) {
+            codePoint = -1;
+            return 1;
+        }
+        value = (value << 6) | (c & 0x3F);
+    }
+
+    // Reject overlong encodings, surrogates and values past U+10FFFF
+    if (value < minimum || (value >= 0xD800 && value <= 0xDFFF) || value > 0x10FFFF) {
+        codePoint = -1;
+        return 1;
+    }
+
+    codePoint = value;
+    return length;
+}
+
+// Encodes a code point as UTF-8
+int utf8Encode(int codePoint, char* out) {
+    if (codePoint < 0x80) {
+        out[0] = static_cast<char>(codePoint);
+        return 1;
+    }
+    if (codePoint < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+        out[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        return 2;
+    }
+    if (codePoint < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+        out[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+    out[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    return 4;
+}
+
+// Returns the lowercase form of a code point
+int utf8ToLower(int codePoint) {
+    // ASCII
+    if (codePoint >= 'A' && codePoint <= 'Z') {
+        return codePoint + 32;
+    }
+    if (codePoint < 0xC0) {
+        return codePoint;
+    }
+
+    // Latin-1 Supplement: U+00C0-U+00DE except the multiplication sign
+    if (codePoint <= 0xDE) {
+        return (codePoint == 0xD7) ? codePoint : codePoint + 0x20;
+    }
+
+    // Latin Extended-A: alternating upper/lower pairs
+    // (U+0130 dotted I and U+0131 dotless i have no same-length mapping)
+    if (codePoint >= 0x100 && codePoint <= 0x12F) {
+        return codePoint | 1;
+    }
+    if (codePoint >= 0x132 && codePoint <= 0x137) {
+        return codePoint | 1;
+    }
+    if (codePoint >= 0x139 && codePoint <= 0x148) {
+        return (codePoint & 1) ? codePoint + 1 : codePoint;
+    }
+    if (codePoint >= 0x14A && codePoint <= 0x177) {
+        return codePoint | 1;
+    }
+    if (codePoint == 0x178) {
+        return 0xFF; // Y with diaeresis
+    }
+    if (codePoint >= 0x179 && codePoint <= 0x17E) {
+        return (codePoint & 1) ? codePoint + 1 : codePoint;
+    }
+
+    // Greek capitals (U+03A2 is unassigned)
+    if (codePoint >= 0x391 && codePoint <= 0x3AB && codePoint != 0x3A2) {
+        return codePoint + 0x20;
+    }
+
+    // Cyrillic capitals
+    if (codePoint >= 0x400 && codePoint <= 0x40F) {
+        return codePoint + 0x50;
+    }
+    if (codePoint >= 0x410 && codePoint <= 0x42F) {
+        return codePoint + 0x20;
+    }
+
+    return codePoint;
+}
+
+// Returns true if the code point separates words
+bool isWordDelimiter(int codePoint) {
+    if (codePoint < 0) {
+        return false;
+    }
+    if (codePoint < 0x80) {
+        return isAsciiDelimiter(static_cast<unsigned char>(codePoint));
+    }
+
+    // Latin-1 no-break space and punctuation (inverted marks, guillemets)
+    if (codePoint == 0xA0 || codePoint == 0xA1 || codePoint == 0xAB ||
+        codePoint == 0xBB || codePoint == 0xBF) {
+        return true;
+    }
+
+    // General Punctuation: typographic spaces, dashes, curly quotes, ellipsis
+    if (codePoint >= 0x2000 && codePoint <= 0x206F) {
+        return true;
+    }
+
+    // Supplemental Punctuation and CJK spaces/punctuation
+    if ((codePoint >= 0x2E00 && codePoint <= 0x2E7F) ||
+        (codePoint >= 0x3000 && codePoint <= 0x3003)) {
+        return true;
+    }
+
+    return false;
+}
+
+// Returns true if the code point ends a clause
+bool isClauseBoundary(int codePoint) {
+    if (codePoint < 0) {
+        return false;
+    }
+    if (codePoint < 0x80) {
+        return isAsciiClauseBoundary(static_cast<unsigned char>(codePoint));
+    }
+
+    // Inverted marks, ellipsis, interrobang and CJK comma/full stop
+    return codePoint == 0xA1 || codePoint == 0xBF || codePoint == 0x2026 ||
+           codePoint == 0x203D || codePoint == 0x3001 || codePoint == 0x3002;
+}
+
+// Returns true if the code point is an emoji or pictographic symbol
+bool isEmoji(int codePoint) {
+    // Quick reject for everything below the first range (all of ASCII)
+    if (codePoint < EMOJI_RANGES[0][0]) {
+        return false;
+    }
+
+    // Binary search for the last range starting at or before codePoint
+    int low = 0;
+    int high = NUM_EMOJI_RANGES - 1;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (EMOJI_RANGES[mid][0] <= codePoint) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return codePoint <= EMOJI_RANGES[low][1];
+}
+
+// Returns true if the code point only modifies a neighbouring emoji
+bool isEmojiComponent(int codePoint) {
+    return codePoint == 0x200D ||                           // Zero width joiner
+           codePoint == 0xFE0E || codePoint == 0xFE0F ||    // Text/emoji variation selectors
+           (codePoint >= 0x1F3FB && codePoint <= 0x1F3FF) || // Skin tone modifiers
+           codePoint == 0x20E3;                             // Combining enclosing keycap
+}
+
+#if defined(__SSE2__)
+
+// Lowercases one block of 16 bytes if they are all ASCII
+bool lowerAsciiBlock(const char* src, char* dest) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+    // Any byte with the high bit set means the block needs the UTF-8 path
+    if (_mm_movemask_epi8(bytes) != 0) {
+        return false;
+    }
+
+    // With every byte < 0x80, signed compares classify 'A'..'Z' correctly
+    __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('A' - 1)),
+                                    _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), bytes));
+    __m128i lowered = _mm_add_epi8(bytes, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), lowered);
+    return true;
+}
+
+/**
+ * Helper function: Mask of bytes in [lo, hi] for a block known to be ASCII
+ */
+static inline __m128i inRange(__m128i bytes, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(hi + 1)), bytes));
+}
+
+/**
+ * Helper function: Mask of bytes equal to c
+ */
+static inline __m128i equalTo(__m128i bytes, char c) {
+    return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c));
+}
+
+// Classifies one block of 16 bytes if they are all ASCII
+bool classifyAsciiBlock(const char* src, unsigned int& delimiterMask, unsigned int& clauseMask) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+    if (_mm_movemask_epi8(bytes) != 0) {
+        return false;
+    }
+
+    // Space and ASCII punctuation fall in four contiguous ranges
+    __m128i delimiters = _mm_or_si128(_mm_or_si128(inRange(bytes, 0x20, 0x2F), inRange(bytes, 0x3A, 0x40)),
+                                      _mm_or_si128(inRange(bytes, 0x5B, 0x60), inRange(bytes, 0x7B, 0x7E)));
+    delimiterMask = static_cast<unsigned int>(_mm_movemask_epi8(delimiters));
+
+    // Clause punctuation: , . ! ? ; :
+    __m128i clauses = _mm_or_si128(_mm_or_si128(equalTo(bytes, ','), equalTo(bytes, '.')),
+                                   _mm_or_si128(_mm_or_si128(equalTo(bytes, '!'), equalTo(bytes, '?')),
+                                                _mm_or_si128(equalTo(bytes, ';'), equalTo(bytes, ':'))));
+    clauseMask = static_cast<unsigned int>(_mm_movemask_epi8(clauses));
+    return true;
+}
+
+#else
+
+// Lowercases one block of 16 bytes if they are all ASCII (portable version)
+bool lowerAsciiBlock(const char* src, char* dest) {
+    for (int i = 0; i < UTF8_BLOCK_SIZE; i++) {
+        if (static_cast<unsigned char>(src[i]) >= 0x80) {
+            return false;
+        }
+    }
+    for (int i = 0; i < UTF8_BLOCK_SIZE; i++) {
+        char c = src[i];
+        dest[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c;
+    }
+    return true;
+}
+
+// Classifies one block of 16 bytes if they are all ASCII (portable version)
+bool classifyAsciiBlock(const char* src, unsigned int& delimiterMask, unsigned int& clauseMask) {
+    unsigned int mask = 0;
+    unsigned int clauses = 0;
+    for (int i = 0; i < UTF8_BLOCK_SIZE; i++) {
+        unsigned char c = static_cast<unsigned char>(src[i]);
+        if (c >= 0x80) {
+            return false;
+        }
+        if (isAsciiDelimiter(c)) {
+            mask |= 1u << i;
+        }
+        if (isAsciiClauseBoundary(c)) {
+            clauses |= 1u << i;
+        }
+    }
+    delimiterMask = mask;
+    clauseMask = clauses;
+    return true;
+}
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ * VocabularyBench.cpp
+ *
+ * Benchmark of the two ways training threads can build the vocabulary:
+ * - shared:  every thread counts into one ConcurrentVocabulary
+ * - sharded: every thread counts into its own std::map, and the maps are
+ *            merged into one afterwards
+ * Token streams follow a Zipf distribution, as word frequencies in tweets
+ * do, so a few very hot words see most of the contention.
+ *
+ * Usage: ./vocabbench [tokens] [zipf_exponent] [vocabulary]
+ * (defaults: 2000000 tokens, exponents 1.0 and 1.2, 100000 words)
+ */
+
+#include "../include/ConcurrentVocabulary.h"
+#include "../include/DSString.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+typedef std::map<DSString, std::pair<int, int>> CountMap;
+
+// Helper function: seconds elapsed since start
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Helper function: a distinct word for every rank
+DSString makeWord(int rank) {
+    char text[16];
+    int length = 0;
+    text[length++] = 'w';
+    for (unsigned int value = static_cast<unsigned int>(rank) * 2654435761u; value != 0; value /= 26) {
+        text[length++] = static_cast<char>('a' + value % 26);
+    }
+    text[length] = '\0';
+    return DSString(text);
+}
+
+// Helper function: draws a token stream of word ranks from a Zipf distribution
+std::vector<int> makeZipfStream(size_t numTokens, int vocabulary, double exponent, unsigned int seed) {
+    std::vector<double> cumulative(vocabulary);
+    double total = 0.0;
+    for (int rank = 0; rank < vocabulary; rank++) {
+        total += 1.0 / std::pow(rank + 1.0, exponent);
+        cumulative[rank] = total;
+    }
+
+    std::mt19937_64 random(seed);
+    std::uniform_real_distribution<double> uniform(0.0, total);
+    std::vector<int> stream(numTokens);
+    for (size_t i = 0; i < numTokens; i++) {
+        stream[i] = static_cast<int>(std::lower_bound(cumulative.begin(), cumulative.end(), uniform(random)) -
+                                     cumulative.begin());
+    }
+    return stream;
+}
+
+// Helper function: runs body(thread, begin, end) over equal slices of the stream
+template <typename Body>
+void runThreads(int numThreads, size_t numTokens, Body body) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        size_t begin = numTokens * t / numThreads;
+        size_t end = numTokens * (t + 1) / numThreads;
+        threads.emplace_back(body, t, begin, end);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Counts the stream in one shared table; returns the counts as a map
+CountMap countShared(const std::vector<DSString>& words, const std::vector<int>& stream, int numThreads,
+                     size_t expectedWords, double& seconds, size_t& overflow) {
+    ConcurrentVocabulary vocabulary;
+    vocabulary.reserve(expectedWords, numThreads);
+
+    auto start = std::chrono::steady_clock::now();
+    runThreads(numThreads, stream.size(), [&](int thread, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const DSString& word = words[stream[i]];
+            vocabulary.add(thread, word.c_str(), word.size(), (i & 1) == 0);
+        }
+    });
+    seconds = secondsSince(start);
+    overflow = vocabulary.overflowWords();
+
+    CountMap result;
+    vocabulary.forEach([&](const DSString& word, int positive, int negative) {
+        auto& counts = result[word];
+        counts.first += positive;
+        counts.second += negative;
+    });
+    return result;
+}
+
+// Counts the stream in per-thread maps and merges them
+CountMap countSharded(const std::vector<DSString>& words, const std::vector<int>& stream, int numThreads,
+                      double& seconds, size_t& entries) {
+    std::vector<CountMap> local(numThreads);
+
+    auto start = std::chrono::steady_clock::now();
+    runThreads(numThreads, stream.size(), [&](int thread, size_t begin, size_t end) {
+        CountMap& counts = local[thread];
+        for (size_t i = begin; i < end; i++) {
+            auto& entry = counts[words[stream[i]]];
+            if ((i & 1) == 0) {
+                entry.first++;
+            } else {
+                entry.second++;
+            }
+        }
+    });
+
+    entries = 0;
+    CountMap result;
+    for (const CountMap& counts : local) {
+        entries += counts.size();
+        for (const auto& entry : counts) {
+            auto& merged = result[entry.first];
+            merged.first += entry.second.first;
+            merged.second += entry.second.second;
+        }
+    }
+    seconds = secondsSince(start);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    size_t numTokens = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+    std::vector<double> exponents;
+    if (argc > 2) {
+        exponents.push_back(std::atof(argv[2]));
+    } else {
+        exponents.push_back(1.0);
+        exponents.push_back(1.2);
+    }
+    int vocabulary = (argc > 3) ? std::atoi(argv[3]) : 100000;
+
+    std::vector<DSString> words;
+    for (int rank = 0; rank < vocabulary; rank++) {
+        words.push_back(makeWord(rank));
+    }
+
+    const int threadCounts[] = {1, 2, 4, 8, 16, 32, 64};
+    std::cout << "Vocabulary benchmark: " << numTokens << " tokens, " << vocabulary << " words, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    for (double exponent : exponents) {
+        std::vector<int> stream = makeZipfStream(numTokens, vocabulary, exponent, 42);
+        std::cout << std::endl << "Zipf exponent " << exponent << std::endl;
+        std::cout << "threads   shared ms  Mtok/s   sharded ms  Mtok/s   sharded entries" << std::endl;
+
+        for (int numThreads : threadCounts) {
+            double sharedSeconds;
+            double shardedSeconds;
+            size_t overflow;
+            size_t entries;
+            CountMap shared = countShared(words, stream, numThreads, vocabulary, sharedSeconds, overflow);
+            CountMap sharded = countSharded(words, stream, numThreads, shardedSeconds, entries);
+            assert(shared == sharded);
+            assert(overflow == 0);
+
+            std::cout << std::fixed << std::setprecision(1)
+                      << std::setw(7) << numThreads
+                      << std::setw(12) << sharedSeconds * 1000.0
+                      << std::setw(8) << numTokens / sharedSeconds / 1e6
+                      << std::setw(13) << shardedSeconds * 1000.0
+                      << std::setw(8) << numTokens / shardedSeconds / 1e6
+                      << std::setw(18) << entries << std::endl;
+        }
+
+        // An undersized table must still count every word exactly
+        double seconds;
+        size_t overflow;
+        size_t entries;
+        CountMap small = countShared(words, stream, 8, 1000, seconds, overflow);
+        assert(overflow > 0);
+        assert(small == countSharded(words, stream, 8, seconds, entries));
+        std::cout << "Undersized table: " << overflow << " overflow words, counts exact" << std::endl;
+    }
+    return 0;
+}
@@ -8,28 +8,239 @@
 
 #include "../include/DSString.h"
 #include "../include/SentimentClassifier.h"
+#include "../include/DistributedTrainer.h"
+#include "../include/ModelFile.h"
+#include "../include/ScoringServer.h"
 #include <iostream>
+#include <csignal> // For stopping the server on SIGINT and SIGTERM
+#include <thread>
+#include <cstring> // For strcmp on command-line flags
+#include <cstdlib> // For strtoul, atoi and atof on numeric options
+#include <cstdio>  // For sscanf on the shard option
+#include <vector>
 
 /**
  * Display usage information when incorrect arguments are provided
  */
 void displayUsage() {
-    std::cout << "Usage: ./sentiment <training_file> <test_file> <test_sentiment_file> <results_file> <accuracy_file>" << std::endl;
+    std::cout << "Usage: ./sentiment <training_file> <test_file> <test_sentiment_file> <results_file> <accuracy_file> [options]" << std::endl;
+    std::cout << "       ./sentiment merge <output_model> <input_model>..." << std::endl;
+    std::cout << "       ./sentiment unpublish <segment>" << std::endl;
+    std::cout << "       ./sentiment serve <model_file> [--port <n>] [--threads <n>] [--batch <n>] [--batch-delay <us>]" << std::endl;
+    std::cout << "                               [--latency-target <us>] [--queue-limit <n>] [--client-limit <n>]" << std::endl;
+    std::cout << "                               [--shed] [--no-watch] [options]" << std::endl;
     std::cout << std::endl;
     std::cout << "Arguments:" << std::endl;
-    std::cout << "  <training_file>       - CSV file with labeled training data" << std::endl;
-    std::cout << "  <test_file>           - CSV file with unlabeled test data" << std::endl;
-    std::cout << "  <test_sentiment_file> - CSV file with actual sentiments for test data" << std::endl;
+    std::cout << "  <training_file>       - CSV file(s) with labeled training data" << std::endl;
+    std::cout << "  <test_file>           - CSV file(s) with unlabeled test data" << std::endl;
+    std::cout << "  <test_sentiment_file> - CSV file(s) with actual sentiments for test data" << std::endl;
     std::cout << "  <results_file>        - Output file for prediction results" << std::endl;
     std::cout << "  <accuracy_file>       - Output file for accuracy metrics" << std::endl;
+    std::cout << "  Input arguments may also name a directory, a quoted glob pattern (\"logs/*.csv.gz\")" << std::endl;
+    std::cout << "  or a manifest file listing one path per line, written @manifest.txt" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --stem                - Apply Porter stemming to every token" << std::endl;
+    std::cout << "  --ngrams              - Score unknown words from hashed character 3-5 grams" << std::endl;
+    std::cout << "  --negation            - Mark words between a negator and the next punctuation" << std::endl;
+    std::cout << "  --dedupe <mode>       - Skip duplicate training tweets: exact, bloom or minhash" << std::endl;
+    std::cout << "  --cache <entries>     - Cache scores of repeated tweet texts during prediction" << std::endl;
+    std::cout << "  --shared-vocab        - Count training words in one lock-free table shared by all threads" << std::endl;
+    std::cout << "  --freeze <bits>       - Predict from a compact frozen model with 32, 16 or 8 bit weights" << std::endl;
+    std::cout << "  --freeze-check        - Also score at full precision and report label changes" << std::endl;
+    std::cout << "  --publish-model <seg> - Publish the frozen model in a shared memory segment such as /sentiment" << std::endl;
+    std::cout << "  --attach-model <seg>  - Score with a model another process published instead of training" << std::endl;
+    std::cout << "  --huge-pages <mode>   - Back the frozen model and shared table with huge pages: off, thp or hugetlb (default thp)" << std::endl;
+    std::cout << "  --freeze-hot <words>  - Most frequent words kept in the frozen model's hot table (default 1024)" << std::endl;
+    std::cout << "  --freeze-bloom <rate> - False-positive rate of the frozen model's unknown-word filter (default 0.01, 0 = off)" << std::endl;
+    std::cout << "  --io-depth <n>        - Block reads kept in flight for uncompressed input (default 4)" << std::endl;
+    std::cout << "  --io-block <KiB>      - Size of each input block read (default 1024)" << std::endl;
+    std::cout << "  --threads <n>         - Parser threads for training and prediction (default: all cores)" << std::endl;
+    std::cout << "  --numa <mode>         - Thread placement on multi-socket machines: off, pin or replicate (default pin)" << std::endl;
+    std::cout << "  --workers <n>         - Train in n forked processes on shards of the input and merge" << std::endl;
+    std::cout << "  --shard <i>/<n>       - Train only shard i of n, save it with --save-model and exit" << std::endl;
+    std::cout << "  --save-model <path>   - Write the trained model to a binary model file" << std::endl;
+    std::cout << "  --load-model <path>   - Use a saved model instead of training" << std::endl;
     std::cout << std::endl;
     std::cout << "Example:" << std::endl;
     std::cout << "  ./sentiment data/train.csv data/test.csv data/test_sentiment.csv results.csv accuracy.txt" << std::endl;
 }
 
+/**
+ * Merges partial models written with --shard into one model file
+ */
+int runMerge(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "Error: merge needs an output model and at least one input model." << std::endl;
+        displayUsage();
+        return 1;
+    }
+    DSString outputModel(argv[2]);
+    std::vector<DSString> inputModels;
+    for (int i = 3; i < argc; i++) {
+        inputModels.push_back(DSString(argv[i]));
+    }
+    if (!mergeModelFiles(inputModels, outputModel)) {
+        std::cerr << "Error: Failed to merge models." << std::endl;
+        return 1;
+    }
+    std::cout << "Merged " << inputModels.size() << " models into " << outputModel << std::endl;
+    return 0;
+}
+
+/**
+ * Removes a frozen model published with --publish-model
+ */
+int runUnpublish(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Error: unpublish needs one shared memory segment name." << std::endl;
+        displayUsage();
+        return 1;
+    }
+    if (!FrozenModel::unpublish(argv[2])) {
+        return 1;
+    }
+    std::cout << "Removed shared model " << argv[2] << std::endl;
+    return 0;
+}
+
+/**
+ * Signal handler: stops the scoring server
+ */
+void stopServer(int) {
+    ScoringServer::requestStop();
+}
+
+/**
+ * Serves a saved model over TCP until interrupted, reloading it when the
+ * model file changes
+ */
+int runServe(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Error: serve needs a model file." << std::endl;
+        displayUsage();
+        return 1;
+    }
+    ServerOptions options;
+    options.modelFile = DSString(argv[2]);
+    options.threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (options.threads < 1) {
+        options.threads = 1;
+    }
+    for (int i = 3; i < argc; i++) {
+        if (std::strcmp(argv[i], "--stem") == 0) {
+            options.stemming = true;
+        } else if (std::strcmp(argv[i], "--ngrams") == 0) {
+            options.subword = true;
+        } else if (std::strcmp(argv[i], "--negation") == 0) {
+            options.negation = true;
+        } else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            options.cacheEntries = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--freeze") == 0 && i + 1 < argc) {
+            options.freezeBits = std::atoi(argv[++i]);
+            options.freezeOptions.weightBits = options.freezeBits;
+            if (options.freezeBits != 8 && options.freezeBits != 16 && options.freezeBits != 32) {
+                std::cerr << "Error: --freeze must be 32, 16 or 8" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--freeze-hot") == 0 && i + 1 < argc) {
+            int hotWords = std::atoi(argv[++i]);
+            if (hotWords < 0) {
+                std::cerr << "Error: --freeze-hot must not be negative" << std::endl;
+                return 1;
+            }
+            options.freezeOptions.hotWords = static_cast<size_t>(hotWords);
+        } else if (std::strcmp(argv[i], "--freeze-bloom") == 0 && i + 1 < argc) {
+            options.freezeOptions.bloomFalsePositiveRate = std::atof(argv[++i]);
+            if (options.freezeOptions.bloomFalsePositiveRate < 0.0 || options.freezeOptions.bloomFalsePositiveRate >= 1.0) {
+                std::cerr << "Error: --freeze-bloom must be at least 0 and below 1" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--huge-pages") == 0 && i + 1 < argc) {
+            if (!LargePageBuffer::parseMode(argv[++i], options.freezeOptions.hugePages)) {
+                std::cerr << "Error: Unknown huge page mode " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            options.port = std::atoi(argv[++i]);
+            if (options.port < 1 || options.port > 65535) {
+                std::cerr << "Error: --port must be between 1 and 65535" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = std::atoi(argv[++i]);
+            if (options.threads < 1 || options.threads > 1024) {
+                std::cerr << "Error: --threads must be between 1 and 1024" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            int maxBatch = std::atoi(argv[++i]);
+            if (maxBatch < 1 || maxBatch > 4096) {
+                std::cerr << "Error: --batch must be between 1 and 4096" << std::endl;
+                return 1;
+            }
+            options.maxBatch = static_cast<size_t>(maxBatch);
+        } else if (std::strcmp(argv[i], "--batch-delay") == 0 && i + 1 < argc) {
+            options.batchDelayMicros = std::atoi(argv[++i]);
+            if (options.batchDelayMicros < 0 || options.batchDelayMicros > 1000000) {
+                std::cerr << "Error: --batch-delay must be between 0 and 1000000 microseconds" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--latency-target") == 0 && i + 1 < argc) {
+            options.latencyTargetMicros = std::atoi(argv[++i]);
+            if (options.latencyTargetMicros < 1) {
+                std::cerr << "Error: --latency-target must be at least 1 microsecond" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--queue-limit") == 0 && i + 1 < argc) {
+            long limit = std::atol(argv[++i]);
+            if (limit < 1) {
+                std::cerr << "Error: --queue-limit must be at least 1" << std::endl;
+                return 1;
+            }
+            options.queueLimit = static_cast<size_t>(limit);
+        } else if (std::strcmp(argv[i], "--client-limit") == 0 && i + 1 < argc) {
+            long limit = std::atol(argv[++i]);
+            if (limit < 1) {
+                std::cerr << "Error: --client-limit must be at least 1" << std::endl;
+                return 1;
+            }
+            options.clientLimit = static_cast<size_t>(limit);
+        } else if (std::strcmp(argv[i], "--shed") == 0) {
+            options.shed = true;
+        } else if (std::strcmp(argv[i], "--no-watch") == 0) {
+            options.watch = false;
+        } else {
+            std::cerr << "Error: Unknown serve option " << argv[i] << std::endl;
+            displayUsage();
+            return 1;
+        }
+    }
+    
+    ScoringServer server(options);
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    if (!server.start()) {
+        std::cerr << "Error: Failed to start the server." << std::endl;
+        return 1;
+    }
+    server.run();
+    return 0;
+}
+
 int main(int argc, char** argv) {
+    if (argc >= 2 && std::strcmp(argv[1], "merge") == 0) {
+        return runMerge(argc, argv);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "unpublish") == 0) {
+        return runUnpublish(argc, argv);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "serve") == 0) {
+        return runServe(argc, argv);
+    }
+    
     // Check if the correct number of arguments is provided
-    if (argc != 6) {
+    if (argc < 6) {
         std::cerr << "Error: Incorrect number of arguments." << std::endl;
         displayUsage();
         return 1;
@@ -42,6 +253,153 @@ int main(int argc, char** argv) {
     DSString resultsFile(argv[4]);
     DSString accuracyFile(argv[5]);
     
+    // Parse optional flags following the positional arguments
+    bool stemming = false;
+    bool ngrams = false;
+    bool negation = false;
+    DedupeMode dedupeMode = DEDUPE_OFF;
+    size_t cacheEntries = 0;
+    bool sharedVocabulary = false;
+    int freezeBits = 0; // 0 = predict from the training counts
+    bool freezeCheck = false;
+    FreezeOptions freezeOptions;
+    HugePageMode hugePages = HUGE_PAGES_TRANSPARENT;
+    NumaMode numaMode = NUMA_PIN;
+    DSString publishSegment;
+    DSString attachSegment;
+    int ioDepth = AsyncFileReader::DEFAULT_QUEUE_DEPTH;
+    size_t ioBlockKiB = AsyncFileReader::DEFAULT_BLOCK_SIZE >> 10;
+    int threads = 0; // 0 = one per hardware thread
+    int workers = 0; // 0 = train in this process
+    int shardIndex = -1;
+    int shardCount = 0;
+    DSString saveModelFile;
+    DSString loadModelFile;
+    for (int i = 6; i < argc; i++) {
+        if (std::strcmp(argv[i], "--stem") == 0) {
+            stemming = true;
+        } else if (std::strcmp(argv[i], "--ngrams") == 0) {
+            ngrams = true;
+        } else if (std::strcmp(argv[i], "--negation") == 0) {
+            negation = true;
+        } else if (std::strcmp(argv[i], "--dedupe") == 0 && i + 1 < argc) {
+            if (!TweetDeduplicator::parseMode(argv[++i], dedupeMode)) {
+                std::cerr << "Error: Unknown dedupe mode " << argv[i] << std::endl;
+                displayUsage();
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheEntries = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--shared-vocab") == 0) {
+            sharedVocabulary = true;
+        } else if (std::strcmp(argv[i], "--freeze") == 0 && i + 1 < argc) {
+            freezeBits = std::atoi(argv[++i]);
+            freezeOptions.weightBits = freezeBits;
+            if (freezeBits != 8 && freezeBits != 16 && freezeBits != 32) {
+                std::cerr << "Error: --freeze must be 32, 16 or 8" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--freeze-check") == 0) {
+            freezeCheck = true;
+        } else if (std::strcmp(argv[i], "--freeze-hot") == 0 && i + 1 < argc) {
+            int hotWords = std::atoi(argv[++i]);
+            if (hotWords < 0) {
+                std::cerr << "Error: --freeze-hot must not be negative" << std::endl;
+                return 1;
+            }
+            freezeOptions.hotWords = static_cast<size_t>(hotWords);
+        } else if (std::strcmp(argv[i], "--numa") == 0 && i + 1 < argc) {
+            if (!NumaTopology::parseMode(argv[++i], numaMode)) {
+                std::cerr << "Error: Unknown NUMA mode " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--huge-pages") == 0 && i + 1 < argc) {
+            if (!LargePageBuffer::parseMode(argv[++i], hugePages)) {
+                std::cerr << "Error: Unknown huge page mode " << argv[i] << std::endl;
+                return 1;
+            }
+            freezeOptions.hugePages = hugePages;
+        } else if (std::strcmp(argv[i], "--freeze-bloom") == 0 && i + 1 < argc) {
+            freezeOptions.bloomFalsePositiveRate = std::atof(argv[++i]);
+            if (freezeOptions.bloomFalsePositiveRate < 0.0 || freezeOptions.bloomFalsePositiveRate >= 1.0) {
+                std::cerr << "Error: --freeze-bloom must be at least 0 and below 1" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--io-depth") == 0 && i + 1 < argc) {
+            ioDepth = std::atoi(argv[++i]);
+            if (ioDepth < 1 || ioDepth > 256) {
+                std::cerr << "Error: --io-depth must be between 1 and 256" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--io-block") == 0 && i + 1 < argc) {
+            ioBlockKiB = std::strtoul(argv[++i], nullptr, 10);
+            if (ioBlockKiB < 4 || ioBlockKiB > 65536) {
+                std::cerr << "Error: --io-block must be between 4 and 65536 KiB" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+            if (threads < 1 || threads > 1024) {
+                std::cerr << "Error: --threads must be between 1 and 1024" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+            if (workers < 1 || workers > 1024) {
+                std::cerr << "Error: --workers must be between 1 and 1024" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%d/%d", &shardIndex, &shardCount) != 2 ||
+                shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount) {
+                std::cerr << "Error: --shard must be <i>/<n> with 0 <= i < n" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--save-model") == 0 && i + 1 < argc) {
+            saveModelFile = DSString(argv[++i]);
+        } else if (std::strcmp(argv[i], "--load-model") == 0 && i + 1 < argc) {
+            loadModelFile = DSString(argv[++i]);
+        } else if (std::strcmp(argv[i], "--publish-model") == 0 && i + 1 < argc) {
+            publishSegment = DSString(argv[++i]);
+        } else if (std::strcmp(argv[i], "--attach-model") == 0 && i + 1 < argc) {
+            attachSegment = DSString(argv[++i]);
+        } else {
+            std::cerr << "Error: Unknown option " << argv[i] << std::endl;
+            displayUsage();
+            return 1;
+        }
+    }
+    
+    // Shard counts only add up to the single-process counts without deduplication,
+    // which needs to see every tweet
+    bool sharded = (workers > 0 || shardCount > 0);
+    if (sharded && dedupeMode != DEDUPE_OFF) {
+        std::cerr << "Error: --dedupe cannot be combined with --workers or --shard" << std::endl;
+        return 1;
+    }
+    if (freezeCheck && freezeBits == 0) {
+        std::cerr << "Error: --freeze-check needs --freeze" << std::endl;
+        return 1;
+    }
+    if (shardCount > 0 && saveModelFile.size() == 0) {
+        std::cerr << "Error: --shard needs --save-model" << std::endl;
+        return 1;
+    }
+    if (loadModelFile.size() > 0 && sharded) {
+        std::cerr << "Error: --load-model cannot be combined with --workers or --shard" << std::endl;
+        return 1;
+    }
+    if (publishSegment.size() > 0 && freezeBits == 0) {
+        std::cerr << "Error: --publish-model needs --freeze" << std::endl;
+        return 1;
+    }
+    if (attachSegment.size() > 0 && (freezeBits > 0 || sharded || loadModelFile.size() > 0 ||
+                                      saveModelFile.size() > 0)) {
+        std::cerr << "Error: --attach-model replaces training; it cannot be combined with --freeze, "
+                  << "--workers, --shard, --load-model or --save-model" << std::endl;
+        return 1;
+    }
+    
     // Display the configuration
     std::cout << "Sentiment Analysis Configuration:" << std::endl;
     std::cout << "  Training File:       " << trainingFile << std::endl;
@@ -49,18 +407,122 @@ int main(int argc, char** argv) {
     std::cout << "  Test Sentiment File: " << testSentimentFile << std::endl;
     std::cout << "  Results File:        " << resultsFile << std::endl;
     std::cout << "  Accuracy File:       " << accuracyFile << std::endl;
+    std::cout << "  Stemming:            " << (stemming ? "on" : "off") << std::endl;
+    std::cout << "  Subword n-grams:     " << (ngrams ? "on" : "off") << std::endl;
+    std::cout << "  Negation scope:      " << (negation ? "on" : "off") << std::endl;
+    std::cout << "  Deduplication:       " << TweetDeduplicator::modeName(dedupeMode) << std::endl;
+    std::cout << "  Prediction cache:    " << cacheEntries << " entries" << std::endl;
+    std::cout << "  Training vocabulary: " << (sharedVocabulary ? "shared lock-free table" : "serial merge") << std::endl;
+    std::cout << "  Huge pages:          " << LargePageBuffer::modeName(hugePages) << std::endl;
+    std::cout << "  NUMA placement:      " << NumaTopology::modeName(numaMode) << std::endl;
+    std::cout << "  Serving model:       ";
+    if (freezeBits > 0) {
+        std::cout << "frozen, int" << freezeBits << " weights, " << freezeOptions.hotWords << " hot words, ";
+        if (freezeOptions.bloomFalsePositiveRate > 0.0) {
+            std::cout << "guard at " << freezeOptions.bloomFalsePositiveRate << " false positives";
+        } else {
+            std::cout << "no guard";
+        }
+        std::cout << (freezeCheck ? ", parity check" : "") << std::endl;
+    } else if (attachSegment.size() > 0) {
+        std::cout << "shared segment " << attachSegment << std::endl;
+    } else {
+        std::cout << "training counts" << std::endl;
+    }
+    if (publishSegment.size() > 0) {
+        std::cout << "  Publish model as:    " << publishSegment << std::endl;
+    }
+    std::cout << "  Input reads:         " << ioDepth << " x " << ioBlockKiB << " KiB in flight" << std::endl;
+    std::cout << "  Parser threads:      ";
+    if (threads > 0) {
+        std::cout << threads << std::endl;
+    } else {
+        std::cout << "auto" << std::endl;
+    }
+    if (loadModelFile.size() > 0) {
+        std::cout << "  Model:               loaded from " << loadModelFile << std::endl;
+    } else if (shardCount > 0) {
+        std::cout << "  Training:            shard " << shardIndex << " of " << shardCount << std::endl;
+    } else if (workers > 0) {
+        std::cout << "  Training:            " << workers << " worker processes" << std::endl;
+    } else {
+        std::cout << "  Training:            single process" << std::endl;
+    }
+    if (saveModelFile.size() > 0) {
+        std::cout << "  Save model to:       " << saveModelFile << std::endl;
+    }
     std::cout << std::endl;
     
     // Create a sentiment classifier
     SentimentClassifier classifier;
+    classifier.setStemmingEnabled(stemming);
+    classifier.setSubwordFeaturesEnabled(ngrams);
+    classifier.setNegationEnabled(negation);
+    classifier.setDedupeMode(dedupeMode);
+    classifier.setSharedVocabularyEnabled(sharedVocabulary);
+    classifier.setSharedVocabularyPages(hugePages);
+    classifier.setNumaMode(numaMode);
+    classifier.setFreezeCheckEnabled(freezeCheck);
+    classifier.setPredictionCacheCapacity(cacheEntries);
+    classifier.setReadOptions(ioDepth, ioBlockKiB << 10);
+    if (threads > 0) {
+        classifier.setNumThreads(threads);
+    }
     
-    // Step 1: Train the classifier
-    std::cout << "Training classifier..." << std::endl;
-    if (!classifier.train(trainingFile)) {
+    // Step 1: Train the classifier (or load a trained model)
+    bool trained;
+    if (attachSegment.size() > 0) {
+        std::cout << "Attaching shared model..." << std::endl;
+        trained = classifier.attachModel(attachSegment);
+    } else if (loadModelFile.size() > 0) {
+        std::cout << "Loading model..." << std::endl;
+        trained = classifier.loadModel(loadModelFile);
+    } else if (shardCount > 0) {
+        std::cout << "Training classifier on shard " << shardIndex << "/" << shardCount << "..." << std::endl;
+        InputSet inputs;
+        std::vector<InputSet> shards;
+        trained = inputs.add(trainingFile) && classifier.planShards(inputs, shardCount, shards) &&
+                  classifier.train(shards[shardIndex]);
+    } else if (workers > 0) {
+        std::cout << "Training classifier..." << std::endl;
+        InputSet inputs;
+        DistributedTrainer coordinator(workers);
+        trained = inputs.add(trainingFile) && coordinator.train(classifier, inputs);
+    } else {
+        std::cout << "Training classifier..." << std::endl;
+        trained = classifier.train(trainingFile);
+    }
+    if (!trained) {
         std::cerr << "Error: Failed to train the classifier." << std::endl;
         return 1;
     }
     
+    if (saveModelFile.size() > 0) {
+        if (!classifier.saveModel(saveModelFile)) {
+            std::cerr << "Error: Failed to save the model." << std::endl;
+            return 1;
+        }
+        std::cout << "Model saved to: " << saveModelFile << std::endl;
+    }
+    
+    // A shard worker only contributes its partial model
+    if (shardCount > 0) {
+        return 0;
+    }
+    
+    // Freeze the counts into the compact serving model
+    if (freezeBits > 0) {
+        std::cout << "Freezing model..." << std::endl;
+        if (!classifier.freezeModel(freezeOptions)) {
+            std::cerr << "Error: Failed to freeze the model." << std::endl;
+            return 1;
+        }
+        if (publishSegment.size() > 0 && !classifier.publishModel(publishSegment)) {
+            std::cerr << "Error: Failed to publish the model." << std::endl;
+            return 1;
+        }
+    }
+    
     // Step 2: Make predictions
     std::cout << "Making predictions..." << std::endl;
     if (!classifier.predict(testFile, resultsFile)) {